@@ -79,7 +79,62 @@ typedef struct app_border_cfg
     float       sharpness;
 
 }   app_border_cfg_t;
-    
+
+/* ...frame consumers subject to rate control */
+enum {
+    APP_RATE_SV,
+    APP_RATE_DM,
+    APP_RATE_SC,
+    APP_RATE_NUMBER,
+};
+
+/* ...consumer rate control configuration */
+typedef struct app_rate_cfg
+{
+    /* ...decimation ratio (pass every N-th frame; zero or one - all frames) */
+    int         ratio;
+
+    /* ...target rate in frames per second (zero - no pacing) */
+    float       fps;
+
+}   app_rate_cfg_t;
+
+/* ...load-shedding controller configuration */
+typedef struct app_shed_cfg
+{
+    /* ...minimal frame rate (zero - not supervised) */
+    float       fps;
+
+    /* ...maximal average capture-to-display latency in microseconds (zero - not supervised) */
+    u32         latency;
+
+    /* ...number of consecutive supervision periods to step down / step up the ladder */
+    int         down, up;
+
+}   app_shed_cfg_t;
+
+/* ...camera roles */
+enum {
+    APP_CAMERA_SV,
+    APP_CAMERA_DM,
+    APP_CAMERA_SC,
+    APP_CAMERA_ROLES,
+};
+
+/* ...camera topology entry */
+typedef struct app_topology_cfg
+{
+    /* ...camera role */
+    int         role;
+
+    /* ...capture (VIN) device name */
+    char       *vin;
+
+    /* ...correction (IMR) device name (smart-cameras only; NULL - default) */
+    char       *imr;
+
+}   app_topology_cfg_t;
+
 /* ...application configuration data */
 typedef struct app_cfg
 {
@@ -104,6 +159,12 @@ typedef struct app_cfg
     /* ...smart-camera gradient configuration for active/inactve state */
     app_border_cfg_t    sc_active_border, sc_inactive_border;
 
+    /* ...cameras topology in VIN device order (none - default layout) */
+    app_topology_cfg_t *topology;
+
+    /* ...number of configured cameras */
+    int                 topology_number, topology_alloc;
+
 }   app_cfg_t;
 
 extern app_cfg_t    __app_cfg;
@@ -0,0 +1,233 @@
+/*******************************************************************************
+ * utest-atlas.c
+ *
+ * Car sprite atlas packing tool
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      ATLAS_TOOL
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-png.h"
+#include "utest-car-atlas.h"
+#include <getopt.h>
+#include <sys/stat.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Global variables definitions
+ ******************************************************************************/
+
+/* ...log level */
+int     LOG_LEVEL = 1;
+
+/* ...model file prefix and output file */
+static char    *__model = "./data/model";
+static char    *__output = NULL;
+
+/* ...number of steps for model positions */
+static int      __steps[3] = { 8, 32, 8 };
+
+/* ...sprite dimensions */
+static int      __car_width = 1920, __car_height = 1080;
+
+/* ...store sprites pre-converted into car plane format */
+static int      __raw = 0;
+
+/*******************************************************************************
+ * Sprites packing
+ ******************************************************************************/
+
+/* ...read whole file into memory */
+static void * __file_read(const char *path, u32 *length)
+{
+    FILE           *fp;
+    struct stat     st;
+    void           *data = NULL;
+
+    CHK_ERR(fp = fopen(path, "rb"), NULL);
+
+    if (fstat(fileno(fp), &st) == 0 && st.st_size > 0 && (data = malloc((size_t)st.st_size)) != NULL)
+    {
+        (fread(data, 1, (size_t)st.st_size, fp) == (size_t)st.st_size ? *length = (u32)st.st_size : (free(data), data = NULL, 0));
+    }
+
+    fclose(fp);
+
+    return data;
+}
+
+/* ...pack all views of a model */
+static int atlas_pack(car_atlas_writer_t *writer)
+{
+    char        path[256];
+    u32         size = (u32)(__car_width * __car_height * 4), length;
+    void       *data = NULL;
+    int         s[3], n = 0, missing = 0, r;
+
+    /* ...conversion buffer for pre-converted sprites */
+    CHK_ERR(!__raw || (data = malloc(size)) != NULL, -(errno = ENOMEM));
+
+    for (s[0] = 0; s[0] < __steps[0]; s[0]++)
+    for (s[1] = 0; s[1] < __steps[1]; s[1]++)
+    for (s[2] = 0; s[2] < __steps[2]; s[2]++)
+    {
+        snprintf(path, sizeof(path), "%s-%d-%d-%d.png", __model, s[0], s[1], s[2]);
+
+        if (__raw)
+        {
+            int     w = __car_width, h = __car_height, format = GST_VIDEO_FORMAT_ARGB;
+
+            /* ...decode once here so that application only copies pixels */
+            if (create_png(path, &w, &h, &format, &data) < 0)
+            {
+                missing++;
+                continue;
+            }
+
+            CHK_API(car_atlas_writer_add(writer, path, CAR_ATLAS_RAW, data, size));
+        }
+        else
+        {
+            void   *png;
+
+            /* ...PNG stream is stored as is */
+            if ((png = __file_read(path, &length)) == NULL)
+            {
+                TRACE(ERROR, _x("failed to read '%s': %m"), path);
+                missing++;
+                continue;
+            }
+
+            r = car_atlas_writer_add(writer, path, CAR_ATLAS_PNG, png, length);
+            free(png);
+            CHK_API(r);
+        }
+
+        n++;
+    }
+
+    free(data);
+
+    TRACE(INIT, _b("%d sprites packed, %d missing"), n, missing);
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Parameters parsing
+ ******************************************************************************/
+
+static const struct option    options[] = {
+    {   "debug",    required_argument,  NULL,   'd' },
+    {   "model",    required_argument,  NULL,   'm' },
+    {   "steps",    required_argument,  NULL,   's' },
+    {   "cwidth",   required_argument,  NULL,   'X' },
+    {   "cheight",  required_argument,  NULL,   'Y' },
+    {   "raw",      no_argument,        NULL,   'r' },
+    {   "output",   required_argument,  NULL,   'o' },
+    {   NULL,       0,                  NULL,   0   },
+};
+
+static int parse_cmdline(int argc, char **argv)
+{
+    int     index = 0;
+    int     opt;
+
+    while ((opt = getopt_long(argc, argv, "d:m:s:X:Y:ro:", options, &index)) >= 0)
+    {
+        switch (opt)
+        {
+        case 'd':
+            LOG_LEVEL = atoi(optarg);
+            break;
+
+        case 'm':
+            __model = optarg;
+            break;
+
+        case 's':
+            CHK_ERR(sscanf(optarg, "%d:%d:%d", &__steps[0], &__steps[1], &__steps[2]) == 3, -(errno = EINVAL));
+            break;
+
+        case 'X':
+            CHK_ERR((__car_width = atoi(optarg)) > 0, -(errno = EINVAL));
+            break;
+
+        case 'Y':
+            CHK_ERR((__car_height = atoi(optarg)) > 0, -(errno = EINVAL));
+            break;
+
+        case 'r':
+            __raw = 1;
+            break;
+
+        case 'o':
+            __output = optarg;
+            break;
+
+        default:
+            return -EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Entry point
+ ******************************************************************************/
+
+int main(int argc, char **argv)
+{
+    car_atlas_writer_t     *writer;
+    char                    path[256];
+    int                     r;
+
+    TRACE_INIT("Car sprite atlas packing tool");
+
+    CHK_API(parse_cmdline(argc, argv));
+
+    /* ...application looks for "<model>.atlas" by default */
+    (!__output ? snprintf(path, sizeof(path), "%s.atlas", __model), __output = path : 0);
+
+    CHK_ERR(writer = car_atlas_writer_open(__output, __car_width, __car_height, GST_VIDEO_FORMAT_ARGB), -errno);
+
+    r = atlas_pack(writer);
+
+    /* ...index is written even if packing failed half-way */
+    CHK_API(car_atlas_writer_close(writer));
+
+    return r;
+}
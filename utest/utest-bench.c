@@ -0,0 +1,713 @@
+/*******************************************************************************
+ * utest-bench.c
+ *
+ * Headless surround-view pipeline benchmark
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      BENCH
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-display.h"
+#include "utest-imr-sv.h"
+#include "utest-vsink.h"
+#include "utest-imr.h"
+#include "utest-stamp.h"
+#include "utest-ring.h"
+#include "utest-pool.h"
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+#include <linux/videodev2.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...input buffers per camera */
+#define BENCH_POOL_SIZE                 4
+
+/* ...renderer ring size */
+#define BENCH_RING_SIZE                 4
+
+/* ...number of initial frames excluded from statistics */
+#define BENCH_WARMUP                    16
+
+/* ...reported intervals (pipeline stages and glass-to-glass time) */
+enum {
+    BENCH_VIN,
+    BENCH_IMR_QUEUE,
+    BENCH_IMR,
+    BENCH_VSP,
+    BENCH_REDRAW,
+    BENCH_DISPLAY,
+    BENCH_TOTAL,
+    BENCH_NUMBER,
+};
+
+/*******************************************************************************
+ * Global variables definitions (surround-view engine configuration)
+ ******************************************************************************/
+
+/* ...log level */
+int     LOG_LEVEL = 1;
+
+/* ...emulated IMR devices */
+char   *imr_dev_name[] = {
+    "imr-cpu:0",
+    "imr-cpu:1",
+    "imr-cpu:2",
+    "imr-cpu:3",
+    "imr-cpu:4",
+    "imr-cpu:5",
+    "imr-cpu:6",
+    "imr-cpu:7",
+};
+
+/* ...mesh file name */
+char   *__mesh_file_name = "mesh.obj";
+
+/* ...sphere gain factor */
+__scalar    __sphere_gain = 0.8;
+
+/* ...default car orientation */
+__vec3  __default_view = { __MATH_FLOAT(0), __MATH_FLOAT(0), __MATH_FLOAT(1.0) };
+
+/* ...number of steps for model positions */
+int     __steps[3] = { 8, 32, 8 };
+
+/* ...model file prefix */
+char   *__model = "./data/model";
+
+/* ...car shadow region */
+static __vec4   __shadow_rect = { __MATH_FLOAT(-0.5), __MATH_FLOAT(-0.2), __MATH_FLOAT(0.5), __MATH_FLOAT(0.2) };
+
+/* ...input / output / car image dimensions */
+static int      __in_width = 1280, __in_height = 1080;
+static int      __out_width = 1920, __out_height = 1080;
+static int      __car_width = 1920, __car_height = 1080;
+
+/* ...number of measured frames */
+static int      __frames = 300;
+
+/* ...input frame rate (zero - free-running) */
+static float    __fps = 0;
+
+/* ...raw input file (NULL - synthetic pattern) */
+static char    *__input_file = NULL;
+
+/* ...latency trace output file (NULL - disabled) */
+static char    *__trace_file = NULL;
+
+/*******************************************************************************
+ * Local types definitions
+ ******************************************************************************/
+
+typedef struct bench
+{
+    /* ...surround-view engine */
+    imr_sview_t        *sv;
+
+    /* ...input frame length */
+    u32                 size;
+
+    /* ...raw input file mapping */
+    u8                 *file;
+
+    /* ...input file length and number of frame-sets it contains */
+    size_t              file_size;
+    u32                 file_sets;
+
+    /* ...input buffers pools and their free-slots masks */
+    GstBuffer          *buffer[CAMERAS_NUMBER][BENCH_POOL_SIZE];
+    u8                 *plane[CAMERAS_NUMBER][BENCH_POOL_SIZE];
+    u32                 free[CAMERAS_NUMBER];
+
+    /* ...pristine synthetic pattern line and moving bar position in each buffer (negative - none) */
+    u8                 *line[CAMERAS_NUMBER];
+    int                 bar[CAMERAS_NUMBER][BENCH_POOL_SIZE];
+
+    /* ...composed frames waiting for presentation */
+    ring_t              output;
+
+    /* ...offscreen framebuffer */
+    u8                 *surface;
+
+    /* ...frames counters */
+    u32                 submitted, displayed, dropped;
+
+    /* ...completion flag */
+    int                 done;
+
+    /* ...collected intervals (us) */
+    u32                *sample[BENCH_NUMBER];
+
+    /* ...measurement start/end times (us) */
+    u64                 t0, t1;
+
+    /* ...resources usage at measurement start/end */
+    struct rusage       ru0, ru1;
+
+    /* ...data access lock */
+    pthread_mutex_t     lock;
+
+    /* ...state change condition */
+    pthread_cond_t      wait;
+
+}   bench_t;
+
+/*******************************************************************************
+ * Internal helpers
+ ******************************************************************************/
+
+/* ...intervals names */
+static const char * __bench_names[BENCH_NUMBER] = {
+    [BENCH_VIN] = "vin",
+    [BENCH_IMR_QUEUE] = "imr-queue",
+    [BENCH_IMR] = "imr",
+    [BENCH_VSP] = "vsp",
+    [BENCH_REDRAW] = "redraw",
+    [BENCH_DISPLAY] = "display",
+    [BENCH_TOTAL] = "total",
+};
+
+/* ...monotonic time in microseconds */
+static inline u64 __bench_now(void)
+{
+    struct timespec     ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* ...CPU time in microseconds */
+static inline u64 __bench_cpu(struct timeval *tv)
+{
+    return (u64)tv->tv_sec * 1000000ULL + tv->tv_usec;
+}
+
+static int __bench_cmp(const void *a, const void *b)
+{
+    u32     x = *(const u32 *)a, y = *(const u32 *)b;
+
+    return (x > y) - (x < y);
+}
+
+/*******************************************************************************
+ * Input source
+ ******************************************************************************/
+
+/* ...input buffer disposal function (returns buffer to the pool) */
+static gboolean __bench_buffer_dispose(GstMiniObject *obj)
+{
+    GstBuffer  *buffer = GST_BUFFER(obj);
+    bench_t    *bench = (bench_t *)buffer->pool;
+    int         i, j;
+
+    pthread_mutex_lock(&bench->lock);
+
+    /* ...resurrect the buffer and mark the slot is free */
+    gst_buffer_ref(buffer);
+
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+        for (j = 0; j < BENCH_POOL_SIZE; j++)
+            (bench->buffer[i][j] == buffer ? bench->free[i] |= 1 << j : 0);
+
+    pthread_cond_broadcast(&bench->wait);
+    pthread_mutex_unlock(&bench->lock);
+
+    return FALSE;
+}
+
+/* ...create input buffers pools */
+static int bench_source_init(bench_t *bench)
+{
+    int     i, j, k;
+
+    bench->size = __in_width * __in_height * 2;
+
+    /* ...map raw input file if given (UYVY frames of cameras 0..3 sequence) */
+    if (__input_file)
+    {
+        struct stat     st;
+        int             fd;
+
+        CHK_ERR((fd = open(__input_file, O_RDONLY)) >= 0, -errno);
+        CHK_ERR(fstat(fd, &st) == 0, -errno);
+        CHK_ERR((bench->file_sets = st.st_size / (bench->size * CAMERAS_NUMBER)) > 0, -(errno = EINVAL));
+        bench->file = mmap(NULL, bench->file_size = st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        CHK_ERR(bench->file != MAP_FAILED, -errno);
+
+        TRACE(INIT, _b("input file '%s': %u frame-sets"), __input_file, bench->file_sets);
+    }
+
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+    {
+        u8     *l;
+
+        /* ...synthetic pattern - per-camera luma gradient over neutral chroma (same for all lines) */
+        CHK_ERR(l = bench->line[i] = malloc(__in_width * 2), -(errno = ENOMEM));
+
+        for (k = 0; k < __in_width * 2; k += 2)
+        {
+            l[k] = 128, l[k + 1] = (u8)((k / 2) * 255 / __in_width + i * 32);
+        }
+
+        for (j = 0; j < BENCH_POOL_SIZE; j++)
+        {
+            GstBuffer      *buffer;
+            vsink_meta_t   *vmeta;
+            u8             *p;
+
+            CHK_ERR(buffer = gst_buffer_new(), -(errno = ENOMEM));
+            CHK_ERR(vmeta = gst_buffer_add_vsink_meta(buffer), -(errno = ENOMEM));
+            CHK_ERR(p = bench->plane[i][j] = malloc(bench->size), -(errno = ENOMEM));
+
+            for (k = 0; k < __in_height; k++)
+            {
+                memcpy(p + k * __in_width * 2, l, __in_width * 2);
+            }
+
+            bench->bar[i][j] = -1;
+
+            vmeta->width = __in_width;
+            vmeta->height = __in_height;
+            vmeta->format = GST_VIDEO_FORMAT_UYVY;
+            vmeta->plane[0] = p;
+
+            GST_MINI_OBJECT_CAST(buffer)->dispose = __bench_buffer_dispose;
+            (bench->buffer[i][j] = buffer)->pool = (void *)bench;
+        }
+
+        bench->free[i] = (1 << BENCH_POOL_SIZE) - 1;
+    }
+
+    return 0;
+}
+
+/* ...get free buffer of particular camera (returns buffer index; negative if terminated) */
+static int bench_source_get(bench_t *bench, int i)
+{
+    int     j;
+
+    pthread_mutex_lock(&bench->lock);
+
+    while (!bench->free[i] && !bench->done)
+    {
+        pthread_cond_wait(&bench->wait, &bench->lock);
+    }
+
+    if (bench->done)
+    {
+        pthread_mutex_unlock(&bench->lock);
+        return -1;
+    }
+
+    bench->free[i] &= ~(1 << (j = __builtin_ctz(bench->free[i])));
+
+    pthread_mutex_unlock(&bench->lock);
+
+    return j;
+}
+
+/* ...frames generation thread */
+static void * bench_source_thread(void *arg)
+{
+    bench_t    *bench = arg;
+    u64         period = (__fps > 0 ? (u64)(1e+6 / __fps) : 0);
+    u64         next = __bench_now();
+    u32         seq;
+
+    for (seq = 0; ; seq++)
+    {
+        GstBuffer  *buf[CAMERAS_NUMBER];
+        int         i;
+
+        /* ...pace input if requested */
+        if (period)
+        {
+            u64     now = __bench_now();
+
+            (next > now ? usleep((useconds_t)(next - now)) : 0);
+            next += period;
+        }
+
+        for (i = 0; i < CAMERAS_NUMBER; i++)
+        {
+            vsink_meta_t   *vmeta;
+            u64             ts;
+            int             j, *bar;
+            u8             *p;
+
+            if ((j = bench_source_get(bench, i)) < 0)
+            {
+                while (i--)     gst_buffer_unref(buf[i]);
+                return NULL;
+            }
+
+            buf[i] = bench->buffer[i][j], bar = &bench->bar[i][j];
+            vmeta = gst_buffer_get_vsink_meta(buf[i]);
+
+            /* ...point buffer to the recorded frame, or mark synthetic frame with a moving bar */
+            if (bench->file)
+            {
+                vmeta->plane[0] = bench->file + ((size_t)(seq % bench->file_sets) * CAMERAS_NUMBER + i) * bench->size;
+            }
+            else
+            {
+                p = vmeta->plane[0];
+
+                /* ...restore the line covered by the bar when the buffer was used last time */
+                if (*bar >= 0)
+                {
+                    memcpy(p + *bar * __in_width * 2, bench->line[i], __in_width * 2);
+                }
+
+                *bar = (int)(seq % __in_height);
+                memset(p + *bar * __in_width * 2, 0xFF, __in_width * 2);
+            }
+
+            /* ...set frame identity and capture time */
+            ts = __bench_now();
+            GST_BUFFER_DTS(buf[i]) = GST_BUFFER_PTS(buf[i]) = ts * 1000;
+            GST_BUFFER_OFFSET(buf[i]) = stamp_frame_id(i, seq);
+            stamp_frame(buf[i], i, seq, ts);
+        }
+
+        if (imr_sview_submit(bench->sv, buf) < 0)
+        {
+            TRACE(ERROR, _x("submission failed: %m"));
+        }
+
+        for (i = 0; i < CAMERAS_NUMBER; i++)
+        {
+            gst_buffer_unref(buf[i]);
+        }
+
+        __atomic_add_fetch(&bench->submitted, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/*******************************************************************************
+ * Offscreen renderer
+ ******************************************************************************/
+
+/* ...account displayed frame */
+static void bench_account(bench_t *bench, GstBuffer *buffer)
+{
+    imr_meta_t     *meta = gst_buffer_get_imr_meta(buffer);
+    u64            *t = meta->stamps;
+    u32             n = bench->displayed++ - BENCH_WARMUP;
+    int             k, prev;
+
+    /* ...start measurement once warm-up is complete */
+    if (bench->displayed == BENCH_WARMUP)
+    {
+        bench->t0 = __bench_now();
+        getrusage(RUSAGE_SELF, &bench->ru0);
+        return;
+    }
+
+    if (bench->displayed <= BENCH_WARMUP)   return;
+
+    /* ...collect stages intervals (missing stages are accounted to the next one) */
+    for (prev = STAMP_CAPTURE, k = STAMP_VIN; k < STAMP_NUMBER; k++)
+    {
+        u32     d = (t[k] >= t[prev] ? (u32)(t[k] - t[prev]) : 0);
+
+        bench->sample[k - STAMP_VIN][n] = d;
+        (t[k] ? prev = k : 0);
+    }
+
+    bench->sample[BENCH_TOTAL][n] = (t[STAMP_DISPLAY] >= t[STAMP_CAPTURE] ? (u32)(t[STAMP_DISPLAY] - t[STAMP_CAPTURE]) : 0);
+
+    /* ...stop measurement */
+    if (n + 1 == (u32)__frames)
+    {
+        bench->t1 = __bench_now();
+        getrusage(RUSAGE_SELF, &bench->ru1);
+
+        pthread_mutex_lock(&bench->lock);
+        bench->done = 1;
+        pthread_cond_broadcast(&bench->wait);
+        pthread_mutex_unlock(&bench->lock);
+    }
+}
+
+/* ...present composed frame */
+static void bench_present(bench_t *bench, GstBuffer *buffer)
+{
+    imr_meta_t     *meta = gst_buffer_get_imr_meta(buffer);
+    texture_data_t *texture = meta->priv2;
+
+    stamp_buffer(buffer, STAMP_REDRAW);
+
+    /* ..."scan-out" the frame into offscreen surface */
+    memcpy(bench->surface, texture->data[0], (size_t)meta->width * meta->height * 4);
+
+    stamp_buffer(buffer, STAMP_DISPLAY);
+    stamp_trace_frame(buffer);
+
+    bench_account(bench, buffer);
+}
+
+/* ...renderer thread */
+static void * bench_render_thread(void *arg)
+{
+    bench_t    *bench = arg;
+    GstBuffer  *buffer;
+
+    pthread_mutex_lock(&bench->lock);
+
+    while (!bench->done)
+    {
+        if ((buffer = ring_pop(&bench->output)) == NULL)
+        {
+            pthread_cond_wait(&bench->wait, &bench->lock);
+            continue;
+        }
+
+        pthread_mutex_unlock(&bench->lock);
+        bench_present(bench, buffer);
+        gst_buffer_unref(buffer);
+        pthread_mutex_lock(&bench->lock);
+    }
+
+    pthread_mutex_unlock(&bench->lock);
+
+    return NULL;
+}
+
+/* ...composed frame readiness callback (called from compositor thread) */
+static void bench_ready(void *cdata, GstBuffer **buf)
+{
+    bench_t    *bench = cdata;
+    GstBuffer  *buffer = imr_sview_buf_output(buf);
+
+    if (ring_push(&bench->output, gst_buffer_ref(buffer)) < 0)
+    {
+        /* ...renderer is late; drop the frame */
+        gst_buffer_unref(buffer);
+        bench->dropped++;
+        return;
+    }
+
+    pthread_mutex_lock(&bench->lock);
+    pthread_cond_broadcast(&bench->wait);
+    pthread_mutex_unlock(&bench->lock);
+}
+
+static const imr_sview_cb_t     bench_callback = {
+    .ready = bench_ready,
+};
+
+/*******************************************************************************
+ * Report
+ ******************************************************************************/
+
+static void bench_report(bench_t *bench)
+{
+    double      wall = (bench->t1 - bench->t0) / 1e+6;
+    double      user = (__bench_cpu(&bench->ru1.ru_utime) - __bench_cpu(&bench->ru0.ru_utime)) / 1e+6;
+    double      sys = (__bench_cpu(&bench->ru1.ru_stime) - __bench_cpu(&bench->ru0.ru_stime)) / 1e+6;
+    int         k;
+
+    printf("frames:     %d in %.3f s (%d*%d -> %d*%d, %s input)\n", __frames, wall,
+           __in_width, __in_height, __out_width, __out_height, (bench->file ? "file" : "synthetic"));
+    printf("throughput: %.2f fps (submitted: %u, dropped: %u)\n", __frames / wall, bench->submitted, bench->dropped);
+    printf("cpu:        user %.1f%%, system %.1f%% of one core (%ld cores online)\n",
+           100 * user / wall, 100 * sys / wall, sysconf(_SC_NPROCESSORS_ONLN));
+    printf("%-12s %10s %10s %10s %10s  (us)\n", "stage", "p50", "p90", "p99", "max");
+
+    for (k = 0; k < BENCH_NUMBER; k++)
+    {
+        u32    *s = bench->sample[k];
+        int     n = __frames;
+
+        qsort(s, n, sizeof(*s), __bench_cmp);
+        printf("%-12s %10u %10u %10u %10u\n", __bench_names[k], s[(n - 1) * 50 / 100], s[(n - 1) * 90 / 100], s[(n - 1) * 99 / 100], s[n - 1]);
+    }
+}
+
+/*******************************************************************************
+ * Parameters parsing
+ ******************************************************************************/
+
+static const struct option    options[] = {
+    {   "debug",    required_argument,  NULL,   'd' },
+    {   "frames",   required_argument,  NULL,   'n' },
+    {   "fps",      required_argument,  NULL,   'r' },
+    {   "input",    required_argument,  NULL,   'i' },
+    {   "width",    required_argument,  NULL,   'w' },
+    {   "height",   required_argument,  NULL,   'h' },
+    {   "WIDTH",    required_argument,  NULL,   'W' },
+    {   "HEIGHT",   required_argument,  NULL,   'H' },
+    {   "car-x",    required_argument,  NULL,   'X' },
+    {   "car-y",    required_argument,  NULL,   'Y' },
+    {   "mesh",     required_argument,  NULL,   'M' },
+    {   "model",    required_argument,  NULL,   'm' },
+    {   "latency",  required_argument,  NULL,   'L' },
+    {   NULL,       0,                  NULL,   0   },
+};
+
+static int parse_cmdline(int argc, char **argv)
+{
+    int     index = 0;
+    int     opt;
+
+    while ((opt = getopt_long(argc, argv, "d:n:r:i:w:h:W:H:X:Y:M:m:L:", options, &index)) >= 0)
+    {
+        switch (opt)
+        {
+        case 'd':
+            LOG_LEVEL = atoi(optarg);
+            break;
+
+        case 'n':
+            CHK_ERR((__frames = atoi(optarg)) > 0, -(errno = EINVAL));
+            break;
+
+        case 'r':
+            CHK_ERR((__fps = atof(optarg)) >= 0, -(errno = EINVAL));
+            break;
+
+        case 'i':
+            __input_file = optarg;
+            break;
+
+        case 'w':
+            CHK_ERR((u32)(__in_width = atoi(optarg)) < 4096, -(errno = EINVAL));
+            break;
+
+        case 'h':
+            CHK_ERR((u32)(__in_height = atoi(optarg)) < 4096, -(errno = EINVAL));
+            break;
+
+        case 'W':
+            CHK_ERR((u32)(__out_width = atoi(optarg)) < 4096, -(errno = EINVAL));
+            break;
+
+        case 'H':
+            CHK_ERR((u32)(__out_height = atoi(optarg)) < 4096, -(errno = EINVAL));
+            break;
+
+        case 'X':
+            CHK_ERR((u32)(__car_width = atoi(optarg)) < 4096, -(errno = EINVAL));
+            break;
+
+        case 'Y':
+            CHK_ERR((u32)(__car_height = atoi(optarg)) < 4096, -(errno = EINVAL));
+            break;
+
+        case 'M':
+            __mesh_file_name = optarg;
+            break;
+
+        case 'm':
+            __model = optarg;
+            break;
+
+        case 'L':
+            __trace_file = optarg;
+            break;
+
+        default:
+            return -EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Entry point
+ ******************************************************************************/
+
+int main(int argc, char **argv)
+{
+    bench_t         bench;
+    pthread_t       source, render;
+    int             k;
+
+    TRACE_INIT("Surround-view pipeline benchmark");
+
+    gst_init(&argc, &argv);
+
+    CHK_API(parse_cmdline(argc, argv));
+
+    memset(&bench, 0, sizeof(bench));
+    pthread_mutex_init(&bench.lock, NULL);
+    pthread_cond_init(&bench.wait, NULL);
+
+    /* ...stages times are carried in buffers metadata */
+    stamp_collect(1);
+    CHK_API(__trace_file ? stamp_trace_open(__trace_file) : 0);
+
+    for (k = 0; k < BENCH_NUMBER; k++)
+    {
+        CHK_ERR(bench.sample[k] = calloc(__frames, sizeof(u32)), -(errno = ENOMEM));
+    }
+
+    CHK_ERR(bench.surface = malloc((size_t)__out_width * __out_height * 4), -(errno = ENOMEM));
+    CHK_API(ring_init(&bench.output, BENCH_RING_SIZE));
+    CHK_API(pool_init(0));
+    CHK_API(bench_source_init(&bench));
+
+    /* ...create surround-view engine on top of emulated IMR/VSP */
+    CHK_ERR(bench.sv = imr_sview_init(&bench_callback, &bench, __in_width, __in_height, V4L2_PIX_FMT_UYVY,
+                                      __out_width, __out_height, __car_width, __car_height, __shadow_rect), -errno);
+
+    CHK_API(pthread_create(&render, NULL, bench_render_thread, &bench));
+    CHK_API(pthread_create(&source, NULL, bench_source_thread, &bench));
+
+    /* ...wait for measurement completion */
+    pthread_mutex_lock(&bench.lock);
+    while (!bench.done)     pthread_cond_wait(&bench.wait, &bench.lock);
+    pthread_mutex_unlock(&bench.lock);
+
+    pthread_join(source, NULL);
+    pthread_join(render, NULL);
+
+    bench_report(&bench);
+    stamp_trace_close();
+
+    /* ...engine has no teardown interface; leave remaining threads to process exit */
+    return 0;
+}
@@ -0,0 +1,449 @@
+/*******************************************************************************
+ * utest-car-atlas.c
+ *
+ * Packed car sprite atlas
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      ATLAS
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-png.h"
+#include "utest-car-atlas.h"
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...sprite data alignment within the file */
+#define CAR_ATLAS_ALIGN                 64
+
+/*******************************************************************************
+ * Local typedefs
+ ******************************************************************************/
+
+/* ...decoded sprite cache slot */
+typedef struct car_atlas_slot
+{
+    /* ...index entry (negative - slot is empty) */
+    int                     entry;
+
+    /* ...last access tick */
+    u32                     tick;
+
+    /* ...decoded pixels */
+    void                   *data;
+
+}   car_atlas_slot_t;
+
+/* ...atlas reader */
+struct car_atlas
+{
+    /* ...mapped file */
+    void                   *map;
+    size_t                  size;
+
+    /* ...header and index (point into mapping) */
+    const car_atlas_header_t   *hdr;
+    const car_atlas_entry_t    *index;
+
+    /* ...decoded sprites cache */
+    car_atlas_slot_t       *slot;
+    int                     slots;
+
+    /* ...access tick, cache hits and misses */
+    u32                     tick, hits, misses;
+
+    /* ...cache access lock */
+    pthread_mutex_t         lock;
+};
+
+/* ...atlas writer */
+struct car_atlas_writer
+{
+    /* ...output file */
+    FILE                   *fp;
+
+    /* ...file header */
+    car_atlas_header_t      hdr;
+
+    /* ...index being collected */
+    car_atlas_entry_t      *index;
+    u32                     capacity;
+
+    /* ...current data offset */
+    u64                     offset;
+};
+
+/*******************************************************************************
+ * Helpers
+ ******************************************************************************/
+
+/* ...derive sprite name from image path (basename without extension) */
+static int __atlas_name(const char *image, char *name)
+{
+    const char     *s = strrchr(image, '/');
+    const char     *e;
+    size_t          n;
+
+    s = (s ? s + 1 : image);
+    n = ((e = strrchr(s, '.')) ? (size_t)(e - s) : strlen(s));
+
+    CHK_ERR(n > 0 && n < CAR_ATLAS_NAME_MAX, -(errno = ENAMETOOLONG));
+    memcpy(name, s, n), name[n] = '\0';
+
+    return 0;
+}
+
+/* ...index entries comparison */
+static int __atlas_cmp(const void *a, const void *b)
+{
+    return strncmp(((const car_atlas_entry_t *)a)->name, ((const car_atlas_entry_t *)b)->name, CAR_ATLAS_NAME_MAX);
+}
+
+/* ...bytes per pixel of supported formats */
+static inline int __atlas_bpp(int format)
+{
+    switch (format)
+    {
+    case GST_VIDEO_FORMAT_ARGB:     return 4;
+    case GST_VIDEO_FORMAT_RGB:      return 3;
+    case GST_VIDEO_FORMAT_GRAY8:    return 1;
+    default:                        return 0;
+    }
+}
+
+/*******************************************************************************
+ * Atlas reading
+ ******************************************************************************/
+
+/* ...lookup decoded sprite in a cache and copy it out (called with a lock held) */
+static int __atlas_cache_get(car_atlas_t *atlas, int k, void *data, u32 length)
+{
+    int     i;
+
+    for (i = 0; i < atlas->slots; i++)
+    {
+        car_atlas_slot_t   *slot = &atlas->slot[i];
+
+        if (slot->entry != k)       continue;
+
+        slot->tick = ++atlas->tick;
+        memcpy(data, slot->data, length);
+        return 1;
+    }
+
+    return 0;
+}
+
+/* ...put decoded sprite into a cache evicting least recently used one (called with a lock held) */
+static void __atlas_cache_put(car_atlas_t *atlas, int k, const void *data, u32 length)
+{
+    car_atlas_slot_t   *slot = NULL;
+    int                 i;
+
+    for (i = 0; i < atlas->slots; i++)
+    {
+        car_atlas_slot_t   *s = &atlas->slot[i];
+
+        /* ...sprite has been inserted concurrently */
+        if (s->entry == k)      return;
+
+        (!slot || s->tick < slot->tick ? slot = s : 0);
+    }
+
+    /* ...slot memory is allocated on first use */
+    if (!slot || (!slot->data && (slot->data = malloc(length)) == NULL))
+    {
+        return;
+    }
+
+    memcpy(slot->data, data, length);
+    slot->entry = k, slot->tick = ++atlas->tick;
+}
+
+/* ...load sprite into caller-provided plane */
+int car_atlas_load(car_atlas_t *atlas, const char *image, void *data, int width, int height, int format)
+{
+    const car_atlas_header_t   *hdr = atlas->hdr;
+    const car_atlas_entry_t    *e;
+    car_atlas_entry_t           key;
+    u32                         length;
+    const void                 *src;
+    int                         k, hit;
+
+    CHK_API(__atlas_name(image, key.name));
+
+    /* ...atlas must match destination plane */
+    CHK_ERR((u32)width == hdr->width && (u32)height == hdr->height && (u32)format == hdr->format, -(errno = EINVAL));
+
+    CHK_ERR(e = bsearch(&key, atlas->index, hdr->count, sizeof(*e), __atlas_cmp), -(errno = ENOENT));
+    k = (int)(e - atlas->index);
+    src = (const u8 *)atlas->map + e->offset;
+    length = (u32)(width * height * __atlas_bpp(format));
+
+    /* ...pre-converted sprite is copied straight from the mapping */
+    if (e->encoding == CAR_ATLAS_RAW)
+    {
+        CHK_ERR(e->length == length, -(errno = EBADF));
+        memcpy(data, src, length);
+        return 0;
+    }
+
+    CHK_ERR(e->encoding == CAR_ATLAS_PNG, -(errno = EBADF));
+
+    pthread_mutex_lock(&atlas->lock);
+    ((hit = __atlas_cache_get(atlas, k, data, length)) ? atlas->hits++ : atlas->misses++);
+    pthread_mutex_unlock(&atlas->lock);
+
+    if (hit)    return 0;
+
+    /* ...decode directly into the plane; cache keeps a copy */
+    CHK_API(decode_png_mem(src, e->length, e->name, &width, &height, &format, data, width * __atlas_bpp(format), 0));
+
+    pthread_mutex_lock(&atlas->lock);
+    __atlas_cache_put(atlas, k, data, length);
+    pthread_mutex_unlock(&atlas->lock);
+
+    TRACE(DEBUG, _b("sprite '%s' decoded (hits: %u, misses: %u)"), e->name, atlas->hits, atlas->misses);
+
+    return 0;
+}
+
+/* ...open atlas file */
+car_atlas_t * car_atlas_open(const char *path, int cache)
+{
+    car_atlas_t        *atlas;
+    struct stat         st;
+    int                 fd, i;
+
+    CHK_ERR(atlas = calloc(1, sizeof(*atlas)), (errno = ENOMEM, NULL));
+
+    /* ...map the whole file (sprites are paged in on demand) */
+    if ((fd = open(path, O_RDONLY | O_CLOEXEC)) < 0 || fstat(fd, &st) < 0)
+    {
+        TRACE(ERROR, _x("failed to open atlas '%s': %m"), path);
+        goto error;
+    }
+
+    atlas->size = (size_t)st.st_size;
+
+    if (atlas->size < sizeof(car_atlas_header_t) ||
+        (atlas->map = mmap(NULL, atlas->size, PROT_READ, MAP_SHARED, fd, 0)) == MAP_FAILED)
+    {
+        TRACE(ERROR, _x("failed to map atlas '%s': %m"), path);
+        atlas->map = NULL;
+        goto error;
+    }
+
+    close(fd), fd = -1;
+
+    /* ...validate header and index placement */
+    atlas->hdr = atlas->map;
+    if (atlas->hdr->magic != CAR_ATLAS_MAGIC || atlas->hdr->version != CAR_ATLAS_VERSION ||
+        atlas->hdr->index > atlas->size ||
+        (atlas->size - atlas->hdr->index) / sizeof(car_atlas_entry_t) < atlas->hdr->count)
+    {
+        TRACE(ERROR, _x("invalid atlas '%s'"), path);
+        errno = EBADF;
+        goto error;
+    }
+
+    atlas->index = (const car_atlas_entry_t *)((const u8 *)atlas->map + atlas->hdr->index);
+
+    /* ...make sure sprites data is within the file */
+    for (i = 0; i < (int)atlas->hdr->count; i++)
+    {
+        const car_atlas_entry_t    *e = &atlas->index[i];
+
+        if (e->offset > atlas->size || atlas->size - e->offset < e->length)
+        {
+            TRACE(ERROR, _x("invalid atlas '%s': sprite '%.*s' is truncated"), path, CAR_ATLAS_NAME_MAX, e->name);
+            errno = EBADF;
+            goto error;
+        }
+    }
+
+    /* ...create decoded sprites cache */
+    if (cache > 0 && (atlas->slot = calloc(atlas->slots = cache, sizeof(*atlas->slot))) == NULL)
+    {
+        errno = ENOMEM;
+        goto error;
+    }
+
+    for (i = 0; i < atlas->slots; i++)
+    {
+        atlas->slot[i].entry = -1;
+    }
+
+    pthread_mutex_init(&atlas->lock, NULL);
+
+    TRACE(INIT, _b("atlas '%s': %u sprites %u*%u, cache: %d"), path, atlas->hdr->count, atlas->hdr->width, atlas->hdr->height, atlas->slots);
+
+    return atlas;
+
+error:
+    (fd >= 0 ? close(fd) : 0);
+    (atlas->map ? munmap(atlas->map, atlas->size) : 0);
+    free(atlas);
+    return NULL;
+}
+
+/* ...close atlas */
+void car_atlas_close(car_atlas_t *atlas)
+{
+    int     i;
+
+    TRACE(INIT, _b("atlas closed: hits=%u, misses=%u"), atlas->hits, atlas->misses);
+
+    for (i = 0; i < atlas->slots; i++)
+    {
+        free(atlas->slot[i].data);
+    }
+
+    pthread_mutex_destroy(&atlas->lock);
+    munmap(atlas->map, atlas->size);
+    free(atlas->slot);
+    free(atlas);
+}
+
+/*******************************************************************************
+ * Atlas creation
+ ******************************************************************************/
+
+/* ...create atlas file */
+car_atlas_writer_t * car_atlas_writer_open(const char *path, int width, int height, int format)
+{
+    car_atlas_writer_t     *writer;
+
+    CHK_ERR(__atlas_bpp(format), (errno = EINVAL, NULL));
+    CHK_ERR(writer = calloc(1, sizeof(*writer)), (errno = ENOMEM, NULL));
+
+    if ((writer->fp = fopen(path, "wb")) == NULL)
+    {
+        TRACE(ERROR, _x("failed to create atlas '%s': %m"), path);
+        free(writer);
+        return NULL;
+    }
+
+    writer->hdr.magic = CAR_ATLAS_MAGIC;
+    writer->hdr.version = CAR_ATLAS_VERSION;
+    writer->hdr.width = (u32)width, writer->hdr.height = (u32)height, writer->hdr.format = (u32)format;
+
+    /* ...header is rewritten once index is complete */
+    writer->offset = sizeof(writer->hdr);
+
+    return writer;
+}
+
+/* ...append sprite */
+int car_atlas_writer_add(car_atlas_writer_t *writer, const char *image, int encoding, const void *data, u32 length)
+{
+    car_atlas_entry_t  *e;
+    u64                 offset = (writer->offset + CAR_ATLAS_ALIGN - 1) & ~(u64)(CAR_ATLAS_ALIGN - 1);
+
+    CHK_ERR(encoding == CAR_ATLAS_PNG || encoding == CAR_ATLAS_RAW, -(errno = EINVAL));
+    CHK_ERR(encoding == CAR_ATLAS_PNG || length == writer->hdr.width * writer->hdr.height * __atlas_bpp(writer->hdr.format), -(errno = EINVAL));
+
+    /* ...grow index if needed */
+    if (writer->hdr.count == writer->capacity)
+    {
+        u32     n = (writer->capacity ? 2 * writer->capacity : 256);
+
+        CHK_ERR(e = realloc(writer->index, n * sizeof(*e)), -(errno = ENOMEM));
+        writer->index = e, writer->capacity = n;
+    }
+
+    e = &writer->index[writer->hdr.count];
+    memset(e, 0, sizeof(*e));
+    CHK_API(__atlas_name(image, e->name));
+    e->encoding = (u32)encoding, e->length = length, e->offset = offset;
+
+    /* ...write sprite data */
+    CHK_API(fseeko(writer->fp, (off_t)offset, SEEK_SET));
+    CHK_ERR(fwrite(data, 1, length, writer->fp) == length, -errno);
+
+    writer->offset = offset + length, writer->hdr.count++;
+
+    TRACE(DEBUG, _b("sprite '%s' added: %s, %u bytes"), e->name, (encoding == CAR_ATLAS_RAW ? "raw" : "png"), length);
+
+    return 0;
+}
+
+/* ...write index and close atlas file */
+int car_atlas_writer_close(car_atlas_writer_t *writer)
+{
+    car_atlas_header_t *hdr = &writer->hdr;
+    u32                 i;
+    int                 r = 0;
+
+    /* ...sort index for binary search */
+    qsort(writer->index, hdr->count, sizeof(*writer->index), __atlas_cmp);
+
+    for (i = 1; i < hdr->count; i++)
+    {
+        if (__atlas_cmp(&writer->index[i - 1], &writer->index[i]) == 0)
+        {
+            TRACE(ERROR, _x("duplicate sprite '%s'"), writer->index[i].name);
+            r = -(errno = EEXIST);
+        }
+    }
+
+    hdr->index = (writer->offset + CAR_ATLAS_ALIGN - 1) & ~(u64)(CAR_ATLAS_ALIGN - 1);
+
+    /* ...write index and final header */
+    if (r == 0 &&
+        (fseeko(writer->fp, (off_t)hdr->index, SEEK_SET) < 0 ||
+         fwrite(writer->index, sizeof(*writer->index), hdr->count, writer->fp) != hdr->count ||
+         fseeko(writer->fp, 0, SEEK_SET) < 0 ||
+         fwrite(hdr, sizeof(*hdr), 1, writer->fp) != 1))
+    {
+        TRACE(ERROR, _x("failed to write atlas index: %m"));
+        r = -errno;
+    }
+
+    (fclose(writer->fp) != 0 && r == 0 ? r = -errno : 0);
+
+    TRACE(INIT, _b("atlas written: %u sprites, %llu bytes"), hdr->count, (unsigned long long)(hdr->index + hdr->count * sizeof(*writer->index)));
+
+    free(writer->index);
+    free(writer);
+
+    return r;
+}
@@ -0,0 +1,114 @@
+/*******************************************************************************
+ * utest-car-atlas.h
+ *
+ * Packed car sprite atlas
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#ifndef __UTEST_CAR_ATLAS_H
+#define __UTEST_CAR_ATLAS_H
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "utest-common.h"
+
+/*******************************************************************************
+ * File layout
+ *
+ * Atlas holds all car views of a model in a single file: a header, sprites
+ * data and an index sorted by sprite name (the name of the PNG file the view
+ * would otherwise be loaded from, without directory and extension). Sprites
+ * are stored either as PNG streams or pre-converted into the car plane format
+ * (width * height ARGB pixels), in which case loading is a plain copy from the
+ * mapped file. All fields are little-endian.
+ ******************************************************************************/
+
+/* ...file signature and revision */
+#define CAR_ATLAS_MAGIC                 0x41435653      /* "SVCA" */
+#define CAR_ATLAS_VERSION               1
+
+/* ...maximal sprite name length (including terminator) */
+#define CAR_ATLAS_NAME_MAX              48
+
+/* ...sprite encoding */
+enum {
+    CAR_ATLAS_PNG,
+    CAR_ATLAS_RAW,
+};
+
+/* ...file header */
+typedef struct car_atlas_header
+{
+    /* ...signature and revision */
+    u32                 magic, version;
+
+    /* ...sprite dimensions and pixel format (GstVideoFormat) */
+    u32                 width, height, format;
+
+    /* ...number of sprites and index offset */
+    u32                 count;
+    u64                 index;
+
+}   car_atlas_header_t;
+
+/* ...index entry */
+typedef struct car_atlas_entry
+{
+    /* ...sprite name */
+    char                name[CAR_ATLAS_NAME_MAX];
+
+    /* ...encoding and data length */
+    u32                 encoding, length;
+
+    /* ...data offset */
+    u64                 offset;
+
+}   car_atlas_entry_t;
+
+/*******************************************************************************
+ * Opaque handles
+ ******************************************************************************/
+
+typedef struct car_atlas            car_atlas_t;
+typedef struct car_atlas_writer     car_atlas_writer_t;
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/* ...atlas reading */
+extern car_atlas_t * car_atlas_open(const char *path, int cache);
+
+extern void car_atlas_close(car_atlas_t *atlas);
+
+extern int car_atlas_load(car_atlas_t *atlas, const char *image, void *data, int width, int height, int format);
+
+/* ...atlas creation */
+extern car_atlas_writer_t * car_atlas_writer_open(const char *path, int width, int height, int format);
+
+extern int car_atlas_writer_add(car_atlas_writer_t *writer, const char *image, int encoding, const void *data, u32 length);
+
+extern int car_atlas_writer_close(car_atlas_writer_t *writer);
+
+#endif  /* __UTEST_CAR_ATLAS_H */
@@ -0,0 +1,524 @@
+/*******************************************************************************
+ * utest-car-gen.c
+ *
+ * Car sprites generator
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      CAR_GEN
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-display.h"
+#include "utest-math.h"
+#include "utest-png.h"
+#include <getopt.h>
+#include <sys/stat.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Car renderer interface (utest-car.c)
+ ******************************************************************************/
+
+typedef struct car_renderer car_renderer_t;
+extern car_renderer_t * car_renderer_init(char *file, int w, int h);
+extern void car_renderer_destroy(car_renderer_t *car);
+extern int car_render(car_renderer_t *car, texture_data_t *texture, const __mat4x4 P, const __mat4x4 V, const __mat4x4 M, u32 cb_color);
+
+/*******************************************************************************
+ * Local types definitions
+ ******************************************************************************/
+
+/* ...view state */
+#define CAR_GEN_VIEW_VALID              0
+#define CAR_GEN_VIEW_PENDING            1
+#define CAR_GEN_VIEW_DONE               2
+#define CAR_GEN_VIEW_FAILED             3
+
+/* ...quantized view descriptor */
+typedef struct car_gen_view
+{
+    /* ...output image path */
+    char                name[256];
+
+    /* ...position in a steps grid */
+    int                 step[3];
+
+    /* ...rendering parameters hash */
+    u32                 key;
+
+    /* ...current state */
+    int                 state;
+
+}   car_gen_view_t;
+
+/* ...rendering worker */
+typedef struct car_gen_worker
+{
+    /* ...worker thread handle */
+    pthread_t           thread;
+
+    /* ...number of views rendered / failed */
+    int                 rendered, failed;
+
+    /* ...initialization result */
+    int                 error;
+
+}   car_gen_worker_t;
+
+/*******************************************************************************
+ * Global variables definitions
+ ******************************************************************************/
+
+/* ...log level (coordinate axes are drawn into the images above 1) */
+int     LOG_LEVEL = 1;
+
+/* ...car model file and output images prefix */
+static char    *__obj = "Car.obj";
+static char    *__model = "./data/model";
+
+/* ...number of steps for model positions */
+static int      __steps[3] = { 8, 32, 8 };
+
+/* ...sprite dimensions */
+static int      __car_width = 1920, __car_height = 1080;
+
+/* ...shadow colour (zero - no shadow) */
+static u32      __color = 0x404040FF;
+
+/* ...number of rendering threads (zero - number of online CPUs) */
+static int      __jobs = 0;
+
+/* ...ignore previous results */
+static int      __force = 0;
+
+/* ...views array and indices of views to render */
+static car_gen_view_t  *__views;
+static int             *__pending;
+static int              __views_num, __pending_num;
+
+/* ...next pending view to take by a worker */
+static int              __next;
+
+/* ...view matrix (same as surround-view scene uses) */
+static const __mat4x4 __v_matrix = {
+    __MATH_FLOAT(1),    __MATH_FLOAT(0),    __MATH_FLOAT(0),    __MATH_FLOAT(0),
+    __MATH_FLOAT(0),    __MATH_FLOAT(1),    __MATH_FLOAT(0),    __MATH_FLOAT(0),
+    __MATH_FLOAT(0),    __MATH_FLOAT(0),    __MATH_FLOAT(1),    __MATH_FLOAT(0),
+    __MATH_FLOAT(0),    __MATH_FLOAT(0),    __MATH_FLOAT(-1),   __MATH_FLOAT(1),
+};
+
+/*******************************************************************************
+ * Views enumeration
+ ******************************************************************************/
+
+/* ...model matrix of a quantized view (must match surround-view position snapping) */
+static void __view_matrix(const int *step, __mat4x4 m)
+{
+    __vec3      rot;
+    __scalar    scl;
+
+    rot[0] = -80.0 * step[0] / __steps[0];
+    rot[1] = 0;
+    rot[2] = 180.0 - 360.0 * step[1] / __steps[1];
+    scl = 0.75 + 0.75 * step[2] / __steps[2];
+
+    __mat4x4_rotation(m, rot, scl);
+}
+
+/* ...FNV-1a hash accumulation */
+static inline u32 __hash(u32 h, const void *data, size_t size)
+{
+    const u8   *p = data;
+
+    while (size--)
+    {
+        h = (h ^ *p++) * 16777619u;
+    }
+
+    return h;
+}
+
+/* ...key of a view - everything that affects resulting image */
+static u32 __view_key(const int *step, const struct stat *st)
+{
+    __mat4x4    m;
+    u32         h = 2166136261u;
+    s64         t = (s64)st->st_mtime, size = (s64)st->st_size;
+
+    __view_matrix(step, m);
+
+    h = __hash(h, m, sizeof(m));
+    h = __hash(h, &__car_width, sizeof(__car_width));
+    h = __hash(h, &__car_height, sizeof(__car_height));
+    h = __hash(h, &__color, sizeof(__color));
+    h = __hash(h, &t, sizeof(t));
+    h = __hash(h, &size, sizeof(size));
+
+    return h;
+}
+
+/* ...enumerate all views of the steps grid */
+static int views_init(void)
+{
+    struct stat     st;
+    car_gen_view_t *v;
+    int             s[3];
+
+    /* ...model timestamp and size are part of each view key */
+    if (stat(__obj, &st) < 0)
+    {
+        TRACE(ERROR, _x("car model '%s' not found: %m"), __obj);
+        return -errno;
+    }
+
+    __views_num = __steps[0] * __steps[1] * __steps[2];
+
+    CHK_ERR(__views = calloc(__views_num, sizeof(*__views)), -(errno = ENOMEM));
+    CHK_ERR(__pending = calloc(__views_num, sizeof(*__pending)), -(errno = ENOMEM));
+
+    for (v = __views, s[0] = 0; s[0] < __steps[0]; s[0]++)
+    for (s[1] = 0; s[1] < __steps[1]; s[1]++)
+    for (s[2] = 0; s[2] < __steps[2]; s[2]++, v++)
+    {
+        snprintf(v->name, sizeof(v->name), "%s-%d-%d-%d.png", __model, s[0], s[1], s[2]);
+        memcpy(v->step, s, sizeof(v->step));
+        v->key = __view_key(s, &st);
+        v->state = CAR_GEN_VIEW_PENDING;
+    }
+
+    return 0;
+}
+
+/* ...lookup view by image name */
+static car_gen_view_t * __view_find(const char *name)
+{
+    int     i;
+
+    for (i = 0; i < __views_num; i++)
+    {
+        if (!strcmp(__views[i].name, name))     return &__views[i];
+    }
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * Manifest ("<prefix>.gen" - image name and key of every rendered view)
+ ******************************************************************************/
+
+/* ...mark views that are up to date */
+static void manifest_load(void)
+{
+    char            path[256], name[256];
+    FILE           *fp;
+    car_gen_view_t *v;
+    u32             key;
+
+    snprintf(path, sizeof(path), "%s.gen", __model);
+
+    /* ...no manifest - everything is rendered */
+    if (__force || (fp = fopen(path, "r")) == NULL)     return;
+
+    while (fscanf(fp, "%255s %x", name, &key) == 2)
+    {
+        /* ...view is valid if parameters have not changed and image is present */
+        if ((v = __view_find(name)) != NULL && v->key == key && access(name, R_OK) == 0)
+        {
+            v->state = CAR_GEN_VIEW_VALID;
+        }
+    }
+
+    fclose(fp);
+}
+
+/* ...store manifest of all valid views */
+static int manifest_store(void)
+{
+    char            path[256], tmp[256 + 4];
+    FILE           *fp;
+    int             i;
+
+    snprintf(path, sizeof(path), "%s.gen", __model);
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    if ((fp = fopen(tmp, "w")) == NULL)
+    {
+        TRACE(ERROR, _x("failed to create '%s': %m"), tmp);
+        return -errno;
+    }
+
+    for (i = 0; i < __views_num; i++)
+    {
+        car_gen_view_t     *v = &__views[i];
+
+        if (v->state == CAR_GEN_VIEW_VALID || v->state == CAR_GEN_VIEW_DONE)
+        {
+            fprintf(fp, "%s %08X\n", v->name, v->key);
+        }
+    }
+
+    /* ...replace previous manifest atomically */
+    if (fclose(fp) != 0 || rename(tmp, path) < 0)
+    {
+        TRACE(ERROR, _x("failed to store '%s': %m"), path);
+        unlink(tmp);
+        return -errno;
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Rendering workers
+ ******************************************************************************/
+
+/* ...rendering thread (private EGL context and car renderer) */
+static void * car_gen_thread(void *arg)
+{
+    car_gen_worker_t   *w = arg;
+    int                 W = __car_width, H = __car_height;
+    car_renderer_t     *car;
+    texture_data_t     *texture;
+    void               *data[3] = { NULL };
+    __mat4x4            P, M;
+    int                 i;
+
+    if ((w->error = egl_headless_bind()) < 0)
+    {
+        return NULL;
+    }
+
+    if ((car = car_renderer_init(__obj, W, H)) == NULL)
+    {
+        w->error = -errno;
+        goto out;
+    }
+
+    if ((data[0] = malloc((size_t)W * H * 4)) == NULL || (texture = texture_create(W, H, data, GST_VIDEO_FORMAT_ARGB)) == NULL)
+    {
+        w->error = -(errno = ENOMEM);
+        goto out_car;
+    }
+
+    /* ...same projection as surround-view scene uses */
+    __mat4x4_perspective(P, 45.0, (float)W / H, 0.1, 10.0);
+
+    /* ...take pending views until none left */
+    while ((i = __atomic_fetch_add(&__next, 1, __ATOMIC_RELAXED)) < __pending_num)
+    {
+        car_gen_view_t     *v = &__views[__pending[i]];
+
+        __view_matrix(v->step, M);
+
+        if (car_render(car, texture, P, __v_matrix, M, __color) < 0 || store_png(v->name, W, H, GST_VIDEO_FORMAT_ARGB, data[0]) < 0)
+        {
+            TRACE(ERROR, _x("view '%s' failed: %m"), v->name);
+            v->state = CAR_GEN_VIEW_FAILED, w->failed++;
+        }
+        else
+        {
+            TRACE(INFO, _b("view '%s' rendered (%d/%d)"), v->name, i + 1, __pending_num);
+            v->state = CAR_GEN_VIEW_DONE, w->rendered++;
+        }
+    }
+
+    texture_destroy(texture);
+
+out_car:
+    free(data[0]);
+    car_renderer_destroy(car);
+
+out:
+    egl_headless_unbind();
+    return NULL;
+}
+
+/* ...render all pending views */
+static int car_gen_run(void)
+{
+    car_gen_worker_t   *workers;
+    int                 n = __jobs, i, r;
+
+    (n <= 0 ? n = (int)sysconf(_SC_NPROCESSORS_ONLN) : 0);
+    (n > __pending_num ? n = __pending_num : 0);
+    (n < 1 ? n = 1 : 0);
+
+    CHK_ERR(workers = calloc(n, sizeof(*workers)), -(errno = ENOMEM));
+
+    TRACE(INIT, _b("render %d of %d views using %d threads"), __pending_num, __views_num, n);
+
+    for (i = 0; i < n; i++)
+    {
+        if ((r = thread_create(&workers[i].thread, "car-gen", 0, NULL, car_gen_thread, &workers[i])) < 0)
+        {
+            TRACE(ERROR, _x("failed to create worker #%d: %m"), i);
+            break;
+        }
+    }
+
+    /* ...wait for completion; remaining views are taken by running workers */
+    for (n = i, r = 0, i = 0; i < n; i++)
+    {
+        pthread_join(workers[i].thread, NULL);
+
+        TRACE(INFO, _b("worker #%d: rendered %d, failed %d (error: %d)"), i, workers[i].rendered, workers[i].failed, workers[i].error);
+
+        (workers[i].error < 0 ? r = workers[i].error : 0);
+    }
+
+    free(workers);
+
+    return (n > 0 ? r : -errno);
+}
+
+/*******************************************************************************
+ * Parameters parsing
+ ******************************************************************************/
+
+static const struct option    options[] = {
+    {   "debug",    required_argument,  NULL,   'd' },
+    {   "width",    required_argument,  NULL,   'w' },
+    {   "height",   required_argument,  NULL,   'h' },
+    {   "color",    required_argument,  NULL,   'c' },
+    {   "output",   required_argument,  NULL,   'o' },
+    {   "steps",    required_argument,  NULL,   's' },
+    {   "model",    required_argument,  NULL,   'm' },
+    {   "jobs",     required_argument,  NULL,   'j' },
+    {   "force",    no_argument,        NULL,   'f' },
+    {   NULL,       0,                  NULL,   0   },
+};
+
+static int parse_cmdline(int argc, char **argv)
+{
+    int     index = 0;
+    int     opt;
+
+    while ((opt = getopt_long(argc, argv, "d:w:h:c:o:s:m:j:f", options, &index)) >= 0)
+    {
+        switch (opt)
+        {
+        case 'd':
+            LOG_LEVEL = atoi(optarg);
+            break;
+
+        case 'w':
+            CHK_ERR((__car_width = atoi(optarg)) > 0, -(errno = EINVAL));
+            break;
+
+        case 'h':
+            CHK_ERR((__car_height = atoi(optarg)) > 0, -(errno = EINVAL));
+            break;
+
+        case 'c':
+            __color = (u32)strtoul(optarg, NULL, 0);
+            break;
+
+        case 'o':
+            __model = optarg;
+            break;
+
+        case 's':
+            CHK_ERR(sscanf(optarg, "%d:%d:%d", &__steps[0], &__steps[1], &__steps[2]) == 3, -(errno = EINVAL));
+            CHK_ERR(__steps[0] > 0 && __steps[1] > 0 && __steps[2] > 0, -(errno = EINVAL));
+            break;
+
+        case 'm':
+            __obj = optarg;
+            break;
+
+        case 'j':
+            __jobs = atoi(optarg);
+            break;
+
+        case 'f':
+            __force = 1;
+            break;
+
+        default:
+            return -EINVAL;
+        }
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Entry point
+ ******************************************************************************/
+
+int main(int argc, char **argv)
+{
+    u32     t0, t1;
+    int     i, r;
+
+    TRACE_INIT("Car sprites generator");
+
+    CHK_API(parse_cmdline(argc, argv));
+
+    CHK_API(views_init());
+
+    /* ...drop views that are up to date */
+    manifest_load();
+
+    for (i = 0; i < __views_num; i++)
+    {
+        (__views[i].state == CAR_GEN_VIEW_PENDING ? __pending[__pending_num++] = i : 0);
+    }
+
+    if (__pending_num == 0)
+    {
+        TRACE(INIT, _b("all %d views are up to date"), __views_num);
+        return 0;
+    }
+
+    CHK_API(egl_headless_init());
+
+    t0 = __get_time_usec();
+    r = car_gen_run();
+    t1 = __get_time_usec();
+
+    /* ...manifest is updated even if some views failed */
+    CHK_API(manifest_store());
+
+    egl_headless_fini();
+
+    TRACE(INIT, _b("%d views processed in %u ms"), __pending_num, (t1 - t0) / 1000);
+
+    for (i = 0; i < __views_num; i++)
+    {
+        (__views[i].state == CAR_GEN_VIEW_FAILED ? r = -(errno = EIO) : 0);
+    }
+
+    return r;
+}
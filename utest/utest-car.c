@@ -860,6 +860,33 @@ error:
     return NULL;
 }
 
+/* ...destroy car renderer (called in the rendering context) */
+void car_renderer_destroy(car_renderer_t *car)
+{
+    int     n = (car->wheels ? obj_set_subsets_number(car->wheels) : 0);
+    int     m = (car->wheels ? obj_set_textures_number(car->wheels) : 0);
+
+    /* ...release GL objects */
+    if (car->tex)   glDeleteTextures(m, car->tex);
+    if (car->ibo)   glDeleteBuffers(n, car->ibo);
+    glDeleteBuffers(1, &car->vbo);
+
+    /* ...destroy shaders */
+    shader_destroy(car->shader_cb);
+    shader_destroy(car->shader_vbo);
+    shader_destroy(car->shader);
+
+    /* ...destroy framebuffer */
+    fbo_destroy(car->fbo);
+
+    /* ...destroy car model */
+    if (car->wheels)    obj_set_destroy(car->wheels);
+    obj_destroy(car->obj);
+
+    free(car->tex), free(car->ibo), free(car->tex_map);
+    free(car);
+}
+
 /* ...render car image into texture */
 int car_render(car_renderer_t *car, texture_data_t *texture, const __mat4x4 P, const __mat4x4 V, const __mat4x4 M, u32 cb_color)
 {
@@ -922,7 +949,7 @@ int car_render(car_renderer_t *car, texture_data_t *texture, const __mat4x4 P, c
     /* ...render image */
     render(car, pvm, vm, vmn);
 
-    if (LOG_LEVEL > 0)
+    if (LOG_LEVEL > 1)
     {
         /* ...add coordinate system indication */
         __mat4x4_mul(P, V, t1);
@@ -30,6 +30,8 @@
  * Includes
  ******************************************************************************/
 
+#define _GNU_SOURCE
+
 #include "sv/trace.h"
 #include "utest-common.h"
 
@@ -68,6 +70,7 @@
  * Tracing configuration
  ******************************************************************************/
 
+TRACE_TAG(INIT, 1);
 TRACE_TAG(DEBUG, 0);
 
 #if 0
@@ -507,6 +510,109 @@ int timer_source_is_active(timer_source_t *tsrc)
     return (tsrc->tag != NULL);
 }
 
+/*******************************************************************************
+ * Threads configuration
+ ******************************************************************************/
+
+/* ...maximal number of configured threads */
+#define THREAD_CFG_MAX                  32
+
+/* ...registered threads configuration */
+static thread_cfg_t     __thread_cfg[THREAD_CFG_MAX];
+static int              __thread_cfg_num;
+
+/* ...register scheduling parameters of named thread */
+int thread_cfg_add(const thread_cfg_t *cfg)
+{
+    CHK_ERR(__thread_cfg_num < THREAD_CFG_MAX, -(errno = ENOMEM));
+
+    __thread_cfg[__thread_cfg_num++] = *cfg;
+
+    return 0;
+}
+
+/* ...find thread configuration (exact name takes precedence over a name class) */
+static const thread_cfg_t * __thread_cfg_find(const char *name)
+{
+    const thread_cfg_t     *cfg = NULL;
+    int                     i;
+
+    for (i = 0; i < __thread_cfg_num; i++)
+    {
+        const char     *t = __thread_cfg[i].name;
+        size_t          n = strlen(t);
+
+        if (!strcmp(name, t))                               return &__thread_cfg[i];
+        else if (!strncmp(name, t, n) && name[n] == '-')    cfg = &__thread_cfg[i];
+    }
+
+    return cfg;
+}
+
+/* ...create named thread */
+int thread_create(pthread_t *thread, const char *name, size_t stack, const thread_cfg_t *cfg, void * (*fn)(void *), void *arg)
+{
+    pthread_attr_t      attr;
+    struct sched_param  param;
+    char                tname[16];
+    int                 r;
+
+    /* ...use registered parameters if not given explicitly */
+    (!cfg ? cfg = __thread_cfg_find(name) : 0);
+
+    /* ...initialize thread attributes (joinable, given stack size) */
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
+    (stack ? pthread_attr_setstacksize(&attr, stack) : 0);
+
+    /* ...set scheduling policy if requested */
+    if (cfg && cfg->policy != SCHED_OTHER)
+    {
+        param.sched_priority = cfg->priority;
+        pthread_attr_setinheritsched(&attr, PTHREAD_EXPLICIT_SCHED);
+        pthread_attr_setschedpolicy(&attr, cfg->policy);
+        pthread_attr_setschedparam(&attr, &param);
+    }
+
+    if ((r = pthread_create(thread, &attr, fn, arg)) == EPERM && cfg && cfg->policy != SCHED_OTHER)
+    {
+        /* ...not enough privileges for requested policy; fallback to default scheduling */
+        TRACE(ERROR, _x("%s: failed to set policy %d, priority %d"), name, cfg->policy, cfg->priority);
+        pthread_attr_setinheritsched(&attr, PTHREAD_INHERIT_SCHED);
+        r = pthread_create(thread, &attr, fn, arg);
+    }
+
+    pthread_attr_destroy(&attr);
+
+    /* ...check thread creation result */
+    CHK_ERR(r == 0, -(errno = r));
+
+    /* ...set thread name (truncated to kernel limit) */
+    snprintf(tname, sizeof(tname), "%s", name);
+    pthread_setname_np(*thread, tname);
+
+    if (!cfg)       return 0;
+
+    /* ...bind the thread to the specified CPUs */
+    if (cfg->cpus)
+    {
+        cpu_set_t   set;
+        int         k;
+
+        CPU_ZERO(&set);
+        for (k = 0; k < 32; k++)
+        {
+            (cfg->cpus & (1U << k) ? CPU_SET(k, &set) : 0);
+        }
+
+        ((r = pthread_setaffinity_np(*thread, sizeof(set), &set)) != 0 ? TRACE(ERROR, _x("%s: failed to set affinity: %s"), name, strerror(r)) : 0);
+    }
+
+    TRACE(INIT, _b("%s: cpus=%X, policy=%d, priority=%d"), name, cfg->cpus, cfg->policy, cfg->priority);
+
+    return 0;
+}
+
 /* ...tracing lock */
 static pthread_mutex_t  intern_trace_mutex;
 
@@ -133,6 +133,31 @@ extern void timer_source_start(timer_source_t *tsrc, u32 interval, u32 period);
 extern void timer_source_stop(timer_source_t *tsrc);
 extern int timer_source_is_active(timer_source_t *tsrc);
 
+/*******************************************************************************
+ * Threads configuration
+ ******************************************************************************/
+
+/* ...thread scheduling parameters */
+typedef struct thread_cfg
+{
+    /* ...thread name, or name class matching all "<class>-<index>" threads */
+    char                name[16];
+
+    /* ...CPU affinity mask (zero - no affinity) */
+    u32                 cpus;
+
+    /* ...scheduling policy and priority */
+    int                 policy;
+    int                 priority;
+
+}   thread_cfg_t;
+
+/* ...register scheduling parameters of named thread */
+extern int thread_cfg_add(const thread_cfg_t *cfg);
+
+/* ...create named thread (NULL configuration - use registered parameters) */
+extern int thread_create(pthread_t *thread, const char *name, size_t stack, const thread_cfg_t *cfg, void * (*fn)(void *), void *arg);
+
 /*******************************************************************************
  * Camera support
  ******************************************************************************/
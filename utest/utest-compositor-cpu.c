@@ -0,0 +1,428 @@
+/*******************************************************************************
+ * utest-compositor-cpu.c
+ *
+ * VSP compositor emulation on CPU (benchmark stand-in)
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      VSP-CPU
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-compositor.h"
+#include <linux/videodev2.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...job input planes (two camera planes, their alpha-planes and a car image) */
+#define VSP_CPU_CAMERA_0                0
+#define VSP_CPU_CAMERA_1                2
+#define VSP_CPU_ALPHA_0                 4
+#define VSP_CPU_ALPHA_1                 6
+#define VSP_CPU_CAR                     8
+#define VSP_CPU_INPUTS                  9
+
+/*******************************************************************************
+ * Local types definitions
+ ******************************************************************************/
+
+/* ...pending composition job */
+typedef struct vsp_job
+{
+    /* ...input planes (indexed as in submission array) */
+    vsp_mem_t              *input[VSP_CPU_INPUTS];
+
+    /* ...output plane */
+    vsp_mem_t              *output;
+
+}   vsp_job_t;
+
+typedef struct vsp_compositor
+{
+    /* ...camera planes dimensions and format */
+    int                     w, h;
+    u32                     format;
+
+    /* ...car image dimensions */
+    int                     cw, ch;
+
+    /* ...output plane dimensions */
+    int                     W, H;
+
+    /* ...pending jobs queue */
+    GQueue                  jobs;
+
+    /* ...processing thread activity flag */
+    int                     active;
+
+    /* ...queue access lock */
+    pthread_mutex_t         lock;
+
+    /* ...job submission condition */
+    pthread_cond_t          wait;
+
+    /* ...processing thread */
+    pthread_t               thread;
+
+    /* ...processing callback */
+    vsp_callback_t          cb;
+
+    /* ...callback client data */
+    void                   *cdata;
+
+}   vsp_compositor_t;
+
+/* ...memory descriptor */
+struct vsp_mem
+{
+    /* ...user-accessible pointer */
+    void                   *data;
+
+    /* ...size of a chunk */
+    u32                     size;
+
+    /* ...planes offsets */
+    u32                     offset[3];
+};
+
+/*******************************************************************************
+ * Memory allocation
+ ******************************************************************************/
+
+/* ...allocate memory block */
+vsp_mem_t * vsp_mem_alloc(u32 size)
+{
+    vsp_mem_t      *mem;
+
+    CHK_ERR(mem = calloc(1, sizeof(*mem)), (errno = ENOMEM, NULL));
+
+    /* ...keep blocks page-size aligned as the hardware allocator does */
+    size = (size + 4095) & ~4095;
+
+    if ((errno = posix_memalign(&mem->data, 4096, size)) != 0)
+    {
+        TRACE(ERROR, _x("failed to allocate %u bytes"), size);
+        free(mem);
+        return NULL;
+    }
+
+    memset(mem->data, 0, mem->size = size);
+
+    return mem;
+}
+
+/* ...destroy memory block */
+void vsp_mem_free(vsp_mem_t *mem)
+{
+    free(mem->data);
+    free(mem);
+}
+
+/* ...memory buffer accessor */
+void * vsp_mem_ptr(vsp_mem_t *mem)
+{
+    return mem->data;
+}
+
+/* ...memory size */
+u32 vsp_mem_size(vsp_mem_t *mem)
+{
+    return mem->size;
+}
+
+/* ...DMA export is not available for regular memory */
+vsp_dmabuf_t * vsp_dmabuf_export(vsp_mem_t *mem, u32 offset, u32 size)
+{
+    return (errno = ENOTSUP, NULL);
+}
+
+int vsp_dmabuf_fd(vsp_dmabuf_t *dmabuf)
+{
+    return -1;
+}
+
+void vsp_dmabuf_unexport(vsp_dmabuf_t *dmabuf)
+{
+}
+
+int vsp_buffer_export(vsp_mem_t *mem, int w, int h, u32 format, int *dmafd, u32 *offset, u32 *stride)
+{
+    return -(errno = ENOTSUP);
+}
+
+/*******************************************************************************
+ * Composition
+ ******************************************************************************/
+
+static inline u8 __vsp_sat(int v)
+{
+    return (u8)(v < 0 ? 0 : (v > 255 ? 255 : v));
+}
+
+/* ...fetch camera pixel as premultiplied RGB scaled by alpha (BT.601 full-range) */
+static inline void __vsp_fetch(vsp_compositor_t *vsp, vsp_mem_t *mem, int x, int y, int a, int *rgb)
+{
+    const u8   *p = mem->data;
+    int         Y, U, V;
+
+    switch (vsp->format)
+    {
+    case V4L2_PIX_FMT_UYVY:
+        p += (y * vsp->w + (x & ~1)) * 2;
+        Y = p[1 + 2 * (x & 1)], U = p[0], V = p[2];
+        break;
+
+    case V4L2_PIX_FMT_YUYV:
+        p += (y * vsp->w + (x & ~1)) * 2;
+        Y = p[2 * (x & 1)], U = p[1], V = p[3];
+        break;
+
+    default:
+        /* ...NV16 - luma and interleaved chroma planes */
+        Y = p[y * vsp->w + x];
+        p += mem->offset[1] + y * vsp->w + (x & ~1);
+        U = p[0], V = p[1];
+    }
+
+    U -= 128, V -= 128;
+    rgb[0] += __vsp_sat(Y + ((359 * V) >> 8)) * a;
+    rgb[1] += __vsp_sat(Y - ((88 * U + 183 * V) >> 8)) * a;
+    rgb[2] += __vsp_sat(Y + ((454 * U) >> 8)) * a;
+}
+
+/* ...blend camera planes with their alpha-planes and put car image on top */
+static void __vsp_compose(vsp_compositor_t *vsp, vsp_job_t *job)
+{
+    const u8   *a0 = vsp_mem_ptr(job->input[VSP_CPU_ALPHA_0]);
+    const u8   *a1 = vsp_mem_ptr(job->input[VSP_CPU_ALPHA_1]);
+    const u32  *car = vsp_mem_ptr(job->input[VSP_CPU_CAR]);
+    u32        *out = vsp_mem_ptr(job->output);
+    int         cx = (vsp->W - vsp->cw) / 2, cy = (vsp->H - vsp->ch) / 2;
+    int         x, y;
+
+    for (y = 0; y < vsp->H; y++)
+    {
+        for (x = 0; x < vsp->W; x++, out++)
+        {
+            int     k = y * vsp->w + x;
+            int     rgb[3] = { 0, 0, 0 };
+            int     a = a0[k] + a1[k];
+            int     X = x - cx, Y = y - cy;
+
+            /* ...sum of camera planes weighted by respective alpha-levels */
+            (a0[k] ? __vsp_fetch(vsp, job->input[VSP_CPU_CAMERA_0], x, y, a0[k], rgb) : 0);
+            (a1[k] ? __vsp_fetch(vsp, job->input[VSP_CPU_CAMERA_1], x, y, a1[k], rgb) : 0);
+
+            *out = ((u32)__vsp_sat(a) << 24) | ((u32)__vsp_sat(rgb[0] >> 8) << 16) | ((u32)__vsp_sat(rgb[1] >> 8) << 8) | __vsp_sat(rgb[2] >> 8);
+
+            /* ...car image is blended using its own alpha channel */
+            if ((u32)X < (u32)vsp->cw && (u32)Y < (u32)vsp->ch)
+            {
+                u32     c = car[Y * vsp->cw + X], ca = c >> 24, d = *out;
+                u32     r = (((c >> 16) & 0xFF) * ca + ((d >> 16) & 0xFF) * (255 - ca)) / 255;
+                u32     g = (((c >> 8) & 0xFF) * ca + ((d >> 8) & 0xFF) * (255 - ca)) / 255;
+                u32     b = ((c & 0xFF) * ca + (d & 0xFF) * (255 - ca)) / 255;
+
+                *out = ((ca > (d >> 24) ? ca : d >> 24) << 24) | (r << 16) | (g << 8) | b;
+            }
+        }
+    }
+}
+
+/* ...processing thread */
+static void * vsp_thread(void *arg)
+{
+    vsp_compositor_t   *vsp = arg;
+
+    pthread_mutex_lock(&vsp->lock);
+
+    while (1)
+    {
+        vsp_job_t  *job;
+
+        while (vsp->active && g_queue_is_empty(&vsp->jobs))
+        {
+            pthread_cond_wait(&vsp->wait, &vsp->lock);
+        }
+
+        if (!vsp->active)   break;
+
+        job = g_queue_pop_head(&vsp->jobs);
+
+        /* ...process job and notify application with no lock held */
+        pthread_mutex_unlock(&vsp->lock);
+        __vsp_compose(vsp, job);
+        free(job);
+        vsp->cb(vsp->cdata, 0);
+        pthread_mutex_lock(&vsp->lock);
+    }
+
+    pthread_mutex_unlock(&vsp->lock);
+
+    return NULL;
+}
+
+/* ...job submission */
+int vsp_job_submit(vsp_compositor_t *vsp, vsp_mem_t **input, vsp_mem_t *output)
+{
+    vsp_job_t  *job;
+
+    CHK_ERR(job = malloc(sizeof(*job)), -(errno = ENOMEM));
+
+    memcpy(job->input, input, sizeof(job->input));
+    job->output = output;
+
+    pthread_mutex_lock(&vsp->lock);
+    g_queue_push_tail(&vsp->jobs, job);
+    pthread_cond_signal(&vsp->wait);
+    pthread_mutex_unlock(&vsp->lock);
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Buffers allocation
+ ******************************************************************************/
+
+/* ...determine planes sizes for a given format */
+static inline int __vsp_pixfmt_planes(int w, int h, u32 fmt, u32 *size)
+{
+    int     N = w * h;
+
+    switch (fmt)
+    {
+    case V4L2_PIX_FMT_GREY:     return size[0] = N, 1;
+    case V4L2_PIX_FMT_UYVY:
+    case V4L2_PIX_FMT_YUYV:     return size[0] = N * 2, 1;
+    case V4L2_PIX_FMT_NV16:     return size[0] = size[1] = N, 2;
+    case V4L2_PIX_FMT_ARGB32:   return size[0] = N * 4, 1;
+    default:                    return 0;
+    }
+}
+
+/* ...allocate memory buffer pool */
+int vsp_allocate_buffers(int w, int h, u32 fmt, vsp_mem_t **output, int num)
+{
+    u32     psize[3], offset[3] = { 0, 0, 0 };
+    int     i, n;
+
+    if ((n = __vsp_pixfmt_planes(w, h, fmt, psize)) == 0)
+    {
+        TRACE(ERROR, _x("unsupported format '%c%c%c%c'"), __v4l2_fmt(fmt));
+        return -(errno = EINVAL);
+    }
+
+    for (i = 1; i < n; i++)
+    {
+        offset[i] = offset[i - 1] + psize[i - 1];
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        if ((output[i] = vsp_mem_alloc(offset[n - 1] + psize[n - 1])) == NULL)
+        {
+            TRACE(ERROR, _x("failed to allocate buffer pool"));
+            goto error;
+        }
+
+        memcpy(output[i]->offset, offset, sizeof(offset));
+    }
+
+    return 0;
+
+error:
+    while (i--)
+    {
+        vsp_mem_free(output[i]), output[i] = NULL;
+    }
+
+    return -(errno = ENOMEM);
+}
+
+/*******************************************************************************
+ * Entry points
+ ******************************************************************************/
+
+/* ...module initialization function */
+vsp_compositor_t * compositor_init(int w, int h, u32 ifmt, int W, int H, u32 ofmt, int cw, int ch, vsp_callback_t cb, void *cdata)
+{
+    vsp_compositor_t   *vsp;
+
+    /* ...only same-size composition of YUV cameras into ARGB plane is emulated */
+    CHK_ERR(w == W && h == H && cw <= W && ch <= H, (errno = EINVAL, NULL));
+    CHK_ERR(ifmt == V4L2_PIX_FMT_UYVY || ifmt == V4L2_PIX_FMT_YUYV || ifmt == V4L2_PIX_FMT_NV16, (errno = EINVAL, NULL));
+    CHK_ERR(ofmt == V4L2_PIX_FMT_ARGB32, (errno = EINVAL, NULL));
+
+    CHK_ERR(vsp = calloc(1, sizeof(*vsp)), (errno = ENOMEM, NULL));
+
+    vsp->w = w, vsp->h = h, vsp->format = ifmt;
+    vsp->W = W, vsp->H = H, vsp->cw = cw, vsp->ch = ch;
+    vsp->cb = cb, vsp->cdata = cdata;
+    g_queue_init(&vsp->jobs);
+    pthread_mutex_init(&vsp->lock, NULL);
+    pthread_cond_init(&vsp->wait, NULL);
+    vsp->active = 1;
+
+    if ((errno = pthread_create(&vsp->thread, NULL, vsp_thread, vsp)) != 0)
+    {
+        TRACE(ERROR, _x("failed to create thread: %m"));
+        free(vsp);
+        return NULL;
+    }
+
+    TRACE(INIT, _b("CPU compositor initialized: %d*%d[%c%c%c%c] -> %d*%d"), w, h, __v4l2_fmt(ifmt), W, H);
+
+    return vsp;
+}
+
+/* ...module destruction */
+void compositor_destroy(vsp_compositor_t *vsp)
+{
+    pthread_mutex_lock(&vsp->lock);
+    vsp->active = 0;
+    pthread_cond_signal(&vsp->wait);
+    pthread_mutex_unlock(&vsp->lock);
+    pthread_join(vsp->thread, NULL);
+
+    while (!g_queue_is_empty(&vsp->jobs))
+    {
+        free(g_queue_pop_head(&vsp->jobs));
+    }
+
+    pthread_cond_destroy(&vsp->wait);
+    pthread_mutex_destroy(&vsp->lock);
+    free(vsp);
+}
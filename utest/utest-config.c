@@ -30,6 +30,8 @@
  * Includes
  ******************************************************************************/
 
+#define _GNU_SOURCE
+
 #include "sv/trace.h"
 #include "utest-app.h"
 
@@ -329,6 +331,87 @@ static int parse_border(app_border_cfg_t *cfg, cfg_parser_t *p)
     return 0;
 }
 
+/* ...parse thread scheduling configuration */
+static int parse_thread(cfg_parser_t *p)
+{
+    thread_cfg_t    cfg;
+    char           *t;
+
+    memset(&cfg, 0, sizeof(cfg));
+
+    /* ...thread name or name class */
+    if ((t = read_token(p)) == NULL)        return -1;
+    if (strlen(t) >= sizeof(cfg.name))      return -1;
+    strcpy(cfg.name, t);
+
+    /* ...scheduling policy */
+    if ((t = read_token(p)) == NULL)        return -1;
+    if (!strcmp(t, "other"))                cfg.policy = SCHED_OTHER;
+    else if (!strcmp(t, "fifo"))            cfg.policy = SCHED_FIFO;
+    else if (!strcmp(t, "rr"))              cfg.policy = SCHED_RR;
+    else if (!strcmp(t, "batch"))           cfg.policy = SCHED_BATCH;
+    else if (!strcmp(t, "idle"))            cfg.policy = SCHED_IDLE;
+    else                                    return -1;
+
+    /* ...scheduling priority (zero for non-real-time policies) */
+    if ((t = read_token(p)) == NULL)        return -1;
+    if (STRTOU(t, cfg.priority))            return -1;
+    if ((cfg.policy == SCHED_FIFO || cfg.policy == SCHED_RR) != (cfg.priority > 0))   return -1;
+
+    /* ...optional CPU affinity mask */
+    if ((t = read_token(p)) != NULL && STRTOU(t, cfg.cpus))     return -1;
+
+    /* ...make sure we have reached end of line */
+    if ((t = read_token(p)) != NULL)        return -1;
+
+    TRACE(INIT, _b("thread '%s': policy=%d, priority=%d, cpus=%X"), cfg.name, cfg.policy, cfg.priority, cfg.cpus);
+
+    return thread_cfg_add(&cfg);
+}
+
+/* ...parse camera topology entry */
+static int parse_topology(app_cfg_t *cfg, cfg_parser_t *p)
+{
+    app_topology_cfg_t  *c;
+    char                *t;
+    int                  role;
+
+    /* ...camera role */
+    if ((t = read_token(p)) == NULL)        return -1;
+    if (!strcmp(t, "sv"))                   role = APP_CAMERA_SV;
+    else if (!strcmp(t, "dm"))              role = APP_CAMERA_DM;
+    else if (!strcmp(t, "sc"))              role = APP_CAMERA_SC;
+    else                                    return -1;
+
+    /* ...make sure we have a room in the topology array */
+    if (cfg->topology_alloc == cfg->topology_number)
+    {
+        CHK_ERR(cfg->topology = realloc(cfg->topology, (cfg->topology_alloc += 4) * sizeof(*cfg->topology)), -(errno = ENOMEM));
+    }
+
+    c = &cfg->topology[cfg->topology_number], c->role = role, c->imr = NULL;
+
+    /* ...capture device name */
+    if ((t = read_token(p)) == NULL)        return -1;
+    CHK_ERR(c->vin = strdup(t), -(errno = ENOMEM));
+
+    /* ...optional correction engine device name */
+    if ((t = read_token(p)) != NULL)
+    {
+        if (role != APP_CAMERA_SC)          return -1;
+        CHK_ERR(c->imr = strdup(t), -(errno = ENOMEM));
+    }
+
+    /* ...make sure we have reached end of line */
+    if ((t = read_token(p)) != NULL)        return -1;
+
+    TRACE(INIT, _b("camera #%d: role=%d, vin='%s', imr='%s'"), cfg->topology_number, role, c->vin, (c->imr ? : "-"));
+
+    cfg->topology_number++;
+
+    return 0;
+}
+
 /*******************************************************************************
  * Parsing function
  ******************************************************************************/
@@ -343,6 +426,8 @@ enum {
     CFG_SV_BORDER,
     CFG_SC_ACTIVE_BORDER,
     CFG_SC_INACTIVE_BORDER,
+    CFG_THREAD,
+    CFG_TOPOLOGY,
 };
 
 /* ...parameter name parsing */
@@ -357,6 +442,8 @@ static inline int cfg_parameter(char *t)
     else if (!strcmp(t, "sc_active_border"))    return CFG_SC_ACTIVE_BORDER;
     else if (!strcmp(t, "sc_inactive_border"))  return CFG_SC_INACTIVE_BORDER;
     else if (!strcmp(t, "sv_border"))           return CFG_SV_BORDER;
+    else if (!strcmp(t, "thread"))              return CFG_THREAD;
+    else if (!strcmp(t, "camera"))              return CFG_TOPOLOGY;
     else                                        return -1;
 }
 
@@ -421,6 +508,14 @@ int config_parse(char *fname)
             if (parse_border(&cfg->sv_border, &p) < 0)    goto error;
             break;
 
+        case CFG_THREAD:
+            if (parse_thread(&p) < 0)   goto error;
+            break;
+
+        case CFG_TOPOLOGY:
+            if (parse_topology(cfg, &p) < 0)    goto error;
+            break;
+
         default:
             /* ...unrecognized command; ignore */
             TRACE(INFO, _b("unrecognized parameter: '%s'"), t);
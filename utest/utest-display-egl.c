@@ -0,0 +1,560 @@
+/*******************************************************************************
+ * utest-display-egl.c
+ *
+ * Headless EGL rendering backend (offscreen car sprites generation)
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      HEADLESS
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-display.h"
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 0);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * EGL extensions (resolved at initialization; multisampling is optional)
+ ******************************************************************************/
+
+#ifndef EGL_PLATFORM_SURFACELESS_MESA
+#define EGL_PLATFORM_SURFACELESS_MESA   0x31DD
+#endif
+
+PFNGLMAPBUFFEROESPROC glMapBufferOES;
+PFNGLUNMAPBUFFEROESPROC glUnmapBufferOES;
+PFNGLRENDERBUFFERSTORAGEMULTISAMPLEEXTPROC glRenderbufferStorageMultisampleEXT;
+PFNGLFRAMEBUFFERTEXTURE2DMULTISAMPLEEXTPROC glFramebufferTexture2DMultisampleEXT;
+PFNGLDISCARDFRAMEBUFFEREXTPROC glDiscardFramebufferEXT;
+
+/*******************************************************************************
+ * Local types definitions
+ ******************************************************************************/
+
+/* ...shader data */
+typedef struct shader_data
+{
+    /* ...shader program */
+    GLuint          program;
+
+    /* ...vertex/fragment shaders */
+    GLuint          v_shader, f_shader;
+
+    /* ...array of uniforms */
+    GLint           uniform[];
+
+}   shader_data_t;
+
+/* ...framebuffer data */
+struct fbo_data
+{
+    /* ...GL framebuffer / renderbuffer objects */
+    GLuint              fbo, rbo;
+
+    /* ...framebuffer dimensions */
+    int                 width, height;
+
+    /* ...number of samples (zero if multisampling is not available) */
+    GLint               samples;
+
+    /* ...texture attached as colour-attachment #0 (read back on release) */
+    texture_data_t     *texture;
+};
+
+/*******************************************************************************
+ * Static data
+ ******************************************************************************/
+
+/* ...EGL display and configuration shared by all rendering threads */
+static egl_data_t           __egl;
+
+/* ...per-thread rendering context and (optional) pbuffer surface */
+static __thread EGLContext  __egl_ctx = EGL_NO_CONTEXT;
+static __thread EGLSurface  __egl_surface = EGL_NO_SURFACE;
+
+/* ...surfaceless context support flag */
+static int                  __egl_surfaceless;
+
+/*******************************************************************************
+ * Headless EGL context
+ ******************************************************************************/
+
+/* ...initialize EGL without a display server */
+int egl_headless_init(void)
+{
+    PFNEGLGETPLATFORMDISPLAYEXTPROC     get_platform_display;
+    const char                         *ext;
+    EGLint                              major, minor, n;
+
+    static const EGLint     attr[] = {
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_DEPTH_SIZE, 16,
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES2_BIT,
+        EGL_NONE
+    };
+
+    /* ...prefer surfaceless platform (software rasterizer works without any device) */
+    get_platform_display = (void *)eglGetProcAddress("eglGetPlatformDisplayEXT");
+    ext = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+    if (get_platform_display && ext && strstr(ext, "EGL_MESA_platform_surfaceless"))
+    {
+        __egl.dpy = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+    }
+    else
+    {
+        __egl.dpy = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    CHK_ERR(__egl.dpy != EGL_NO_DISPLAY, -(errno = ENODEV));
+
+    if (!eglInitialize(__egl.dpy, &major, &minor))
+    {
+        TRACE(ERROR, _x("failed to initialize EGL: %X"), eglGetError());
+        return -(errno = ENODEV);
+    }
+
+    /* ...select OpenGL ES API */
+    if (!eglBindAPI(EGL_OPENGL_ES_API))
+    {
+        TRACE(ERROR, _x("OpenGL ES API is not supported: %X"), eglGetError());
+        goto error;
+    }
+
+    /* ...choose configuration (pbuffer is needed only without surfaceless contexts) */
+    if (!eglChooseConfig(__egl.dpy, attr, &__egl.conf, 1, &n) || n == 0)
+    {
+        TRACE(ERROR, _x("no suitable configuration: %X"), eglGetError());
+        goto error;
+    }
+
+    ext = eglQueryString(__egl.dpy, EGL_EXTENSIONS);
+    __egl_surfaceless = (ext && strstr(ext, "EGL_KHR_surfaceless_context") != NULL);
+
+    /* ...resolve GL extensions */
+    glMapBufferOES = (void *)eglGetProcAddress("glMapBufferOES");
+    glUnmapBufferOES = (void *)eglGetProcAddress("glUnmapBufferOES");
+    glRenderbufferStorageMultisampleEXT = (void *)eglGetProcAddress("glRenderbufferStorageMultisampleEXT");
+    glFramebufferTexture2DMultisampleEXT = (void *)eglGetProcAddress("glFramebufferTexture2DMultisampleEXT");
+    glDiscardFramebufferEXT = (void *)eglGetProcAddress("glDiscardFramebufferEXT");
+
+    /* ...buffer mapping is required by the car renderer */
+    if (!glMapBufferOES || !glUnmapBufferOES)
+    {
+        TRACE(ERROR, _x("GL_OES_mapbuffer is not supported"));
+        goto error;
+    }
+
+    TRACE(INIT, _b("headless EGL %d.%d initialized: %s (surfaceless: %d)"), major, minor, eglQueryString(__egl.dpy, EGL_VENDOR), __egl_surfaceless);
+
+    return 0;
+
+error:
+    eglTerminate(__egl.dpy);
+    return -(errno = ENODEV);
+}
+
+/* ...shutdown EGL */
+void egl_headless_fini(void)
+{
+    eglTerminate(__egl.dpy);
+    eglReleaseThread();
+}
+
+/* ...create private rendering context and make it current in calling thread */
+int egl_headless_bind(void)
+{
+    static const EGLint     ctx_attr[] = { EGL_CONTEXT_CLIENT_VERSION, 2, EGL_NONE };
+    static const EGLint     pb_attr[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+
+    /* ...context is private to a thread; no locking is needed afterwards */
+    BUG(__egl_ctx != EGL_NO_CONTEXT, _x("context is bound already"));
+
+    if ((__egl_ctx = eglCreateContext(__egl.dpy, __egl.conf, EGL_NO_CONTEXT, ctx_attr)) == EGL_NO_CONTEXT)
+    {
+        TRACE(ERROR, _x("failed to create context: %X"), eglGetError());
+        return -(errno = ENOMEM);
+    }
+
+    /* ...rendering always goes to framebuffer objects; dummy surface is needed for old drivers */
+    if (!__egl_surfaceless && (__egl_surface = eglCreatePbufferSurface(__egl.dpy, __egl.conf, pb_attr)) == EGL_NO_SURFACE)
+    {
+        TRACE(ERROR, _x("failed to create pbuffer: %X"), eglGetError());
+        goto error;
+    }
+
+    if (!eglMakeCurrent(__egl.dpy, __egl_surface, __egl_surface, __egl_ctx))
+    {
+        TRACE(ERROR, _x("failed to set context: %X"), eglGetError());
+        goto error_surface;
+    }
+
+    TRACE(INFO, _b("context %p bound (renderer: %s)"), __egl_ctx, glGetString(GL_RENDERER));
+
+    return 0;
+
+error_surface:
+    (__egl_surface != EGL_NO_SURFACE ? eglDestroySurface(__egl.dpy, __egl_surface) : 0);
+    __egl_surface = EGL_NO_SURFACE;
+
+error:
+    eglDestroyContext(__egl.dpy, __egl_ctx);
+    __egl_ctx = EGL_NO_CONTEXT;
+    return -(errno = EBADFD);
+}
+
+/* ...release calling thread rendering context */
+void egl_headless_unbind(void)
+{
+    eglMakeCurrent(__egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    (__egl_surface != EGL_NO_SURFACE ? eglDestroySurface(__egl.dpy, __egl_surface) : 0);
+    eglDestroyContext(__egl.dpy, __egl_ctx);
+    eglReleaseThread();
+
+    TRACE(INFO, _b("context %p released"), __egl_ctx);
+
+    __egl_ctx = EGL_NO_CONTEXT, __egl_surface = EGL_NO_SURFACE;
+}
+
+/*******************************************************************************
+ * Shaders support
+ ******************************************************************************/
+
+/* ...shader compilation code */
+static inline GLuint compile_shader(GLenum type, int count, const char * const *sources, char *msg, int len)
+{
+    GLuint      s;
+    GLint       status;
+
+    CHK_ERR(s = glCreateShader(type), GL_NONE);
+    glShaderSource(s, count, sources, NULL);
+    glCompileShader(s);
+    glGetShaderiv(s, GL_COMPILE_STATUS, &status);
+    if (!status)
+    {
+        glGetShaderInfoLog(s, len, NULL, msg);
+        glDeleteShader(s);
+        TRACE(ERROR, _b("shader compilation error: %s"), msg);
+        return GL_NONE;
+    }
+    else
+    {
+        return s;
+    }
+}
+
+/* ...create shader object (in current thread context) */
+shader_data_t * shader_create(const shader_desc_t *desc)
+{
+    shader_data_t      *shader;
+    char                msg[512];
+    GLint               status;
+    GLuint              program;
+    int                 i;
+
+    /* ...sanity check */
+    CHK_ERR(desc && desc->attr && desc->uni && desc->v_src && desc->f_src, (errno = EINVAL, NULL));
+
+    /* ...make sure we have active context */
+    BUG(eglGetCurrentContext() == EGL_NO_CONTEXT, _x("invalid context"));
+
+    /* ...allocate shader data structure */
+    CHK_ERR(shader = calloc(1, sizeof(*shader) + sizeof(GLint) * desc->uni_num), (errno = ENOMEM, NULL));
+
+    /* ...vertex/fragment shaders compilation (single source) */
+    if ((shader->v_shader = compile_shader(GL_VERTEX_SHADER, 1, desc->v_src, msg, sizeof(msg))) == GL_NONE)
+    {
+        TRACE(ERROR, _x("failed to compile vertex shader"));
+        goto error;
+    }
+    else if ((shader->f_shader = compile_shader(GL_FRAGMENT_SHADER, 1, desc->f_src, msg, sizeof(msg))) == GL_NONE)
+    {
+        TRACE(ERROR, _x("failed to compile fragment shader"));
+        goto error;
+    }
+
+    /* ...create a program and attach shaders */
+    if ((shader->program = program = glCreateProgram()) == GL_NONE)
+    {
+        TRACE(ERROR, _x("failed to create a program: %X"), glGetError());
+        goto error;
+    }
+
+    glAttachShader(program, shader->v_shader);
+    glAttachShader(program, shader->f_shader);
+
+    /* ...bind all user-supplied attributes */
+    for (i = 0; i < desc->attr_num; i++)
+    {
+        glBindAttribLocation(program, i, desc->attr[i]);
+    }
+
+    /* ...link a program */
+    glLinkProgram(program);
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status)
+    {
+        glGetProgramInfoLog(program, sizeof(msg), NULL, msg);
+        TRACE(ERROR, _x("program link error: %s"), msg);
+        goto error;
+    }
+
+    /* ...locate user-provided uniforms */
+    for (i = 0; i < desc->uni_num; i++)
+    {
+        if ((shader->uniform[i] = glGetUniformLocation(program, desc->uni[i])) < 0)
+        {
+            TRACE(WARNING, _b("uniform #%d ('%s') not found"), i, desc->uni[i]);
+        }
+    }
+
+    TRACE(INFO, _b("shader[%p] created (%d attributes, %d uniforms)"), shader, desc->attr_num, desc->uni_num);
+
+    return shader;
+
+error:
+    /* ...destroy shaders and program as needed */
+    (shader->v_shader ? glDeleteShader(shader->v_shader) : 0);
+    (shader->f_shader ? glDeleteShader(shader->f_shader) : 0);
+    (shader->program ? glDeleteProgram(shader->program) : 0);
+    free(shader);
+    errno = EINVAL;
+    return NULL;
+}
+
+/* ...shader destruction */
+void shader_destroy(shader_data_t *shader)
+{
+    glDeleteShader(shader->v_shader);
+    glDeleteShader(shader->f_shader);
+    glDeleteProgram(shader->program);
+    free(shader);
+}
+
+/* ...get shader program */
+GLuint shader_program(shader_data_t *shader)
+{
+    return shader->program;
+}
+
+/* ...get shader uniforms locations array */
+const GLint * shader_uniforms(shader_data_t *shader)
+{
+    return shader->uniform;
+}
+
+/*******************************************************************************
+ * Textures support
+ ******************************************************************************/
+
+/* ...create render-target texture backed by user memory (BGRA, filled on framebuffer release) */
+texture_data_t * texture_create(int w, int h, void **data, int format)
+{
+    texture_data_t     *texture;
+
+    /* ...only car-plane format is supported */
+    CHK_ERR(format == GST_VIDEO_FORMAT_ARGB, (errno = EINVAL, NULL));
+
+    /* ...make sure we have active context */
+    BUG(eglGetCurrentContext() == EGL_NO_CONTEXT, _x("invalid context"));
+
+    CHK_ERR(texture = calloc(1, sizeof(*texture)), (errno = ENOMEM, NULL));
+
+    /* ...save planes buffers pointers */
+    memcpy(texture->data, data, sizeof(texture->data));
+
+    /* ...allocate GL texture storage */
+    glGenTextures(1, &texture->tex);
+    glBindTexture(GL_TEXTURE_2D, texture->tex);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    TRACE(INFO, _b("texture[%p]: %d*%d, tex=%u, data=%p"), texture, w, h, texture->tex, texture->data[0]);
+
+    return texture;
+}
+
+/* ...destroy texture data */
+void texture_destroy(texture_data_t *texture)
+{
+    glDeleteTextures(1, &texture->tex);
+    free(texture);
+}
+
+/*******************************************************************************
+ * Framebuffer support
+ ******************************************************************************/
+
+/* ...create framebuffer for off-screen rendering */
+fbo_data_t * fbo_create(int w, int h)
+{
+    fbo_data_t         *fbo;
+
+    /* ...make sure we have active context */
+    BUG(eglGetCurrentContext() == EGL_NO_CONTEXT, _x("invalid context"));
+
+    CHK_ERR(fbo = calloc(1, sizeof(*fbo)), (errno = ENOMEM, NULL));
+
+    fbo->width = w, fbo->height = h;
+
+    /* ...use multisampled rendering if implementation has it */
+    if (glFramebufferTexture2DMultisampleEXT && glRenderbufferStorageMultisampleEXT)
+    {
+        glGetIntegerv(GL_MAX_SAMPLES_EXT, &fbo->samples);
+    }
+
+    /* ...create framebuffer/renderbuffer objects */
+    glGenFramebuffers(1, &fbo->fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo->fbo);
+    glGenRenderbuffers(1, &fbo->rbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, fbo->rbo);
+
+    /* ...specify depth buffer parameters */
+    if (fbo->samples > 0)
+    {
+        glRenderbufferStorageMultisampleEXT(GL_RENDERBUFFER, fbo->samples, GL_DEPTH_COMPONENT16, w, h);
+    }
+    else
+    {
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT16, w, h);
+    }
+
+    /* ...attach depth buffer to the framebuffer */
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, fbo->rbo);
+
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    TRACE(INFO, _b("framebuffer object created: %p (%d*%d, samples: %d)"), fbo, w, h, fbo->samples);
+
+    return fbo;
+}
+
+/* ...acquire framebuffer (context is always current in a rendering thread) */
+int fbo_get(fbo_data_t *fbo)
+{
+    GLenum      err;
+
+    BUG(eglGetCurrentContext() == EGL_NO_CONTEXT, _x("invalid context"));
+
+    glBindFramebuffer(GL_FRAMEBUFFER, fbo->fbo);
+    glBindRenderbuffer(GL_RENDERBUFFER, fbo->rbo);
+
+    if ((err = glGetError()) != GL_NO_ERROR)
+    {
+        TRACE(ERROR, _x("failed to acquire framebuffer: %x"), err);
+        return -(errno = EBADFD);
+    }
+
+    return 0;
+}
+
+/* ...release framebuffer; read rendered image into attached texture memory */
+void fbo_put(fbo_data_t *fbo)
+{
+    texture_data_t     *texture = fbo->texture;
+    GLenum              attach[1] = { GL_DEPTH_ATTACHMENT };
+
+    /* ...depth buffer is not needed any longer */
+    if (glDiscardFramebufferEXT)
+    {
+        glDiscardFramebufferEXT(GL_FRAMEBUFFER, 1, attach);
+    }
+
+    if (texture && texture->data[0])
+    {
+        u8     *p = texture->data[0];
+        int     n = fbo->width * fbo->height;
+
+        /* ...read back as RGBA and convert into native BGRA layout */
+        glReadPixels(0, 0, fbo->width, fbo->height, GL_RGBA, GL_UNSIGNED_BYTE, p);
+
+        for (; n > 0; n--, p += 4)
+        {
+            u8  t = p[0];
+
+            p[0] = p[2], p[2] = t;
+        }
+    }
+
+    /* ...detach texture and unbind framebuffer/renderbuffer objects */
+    fbo->texture = NULL;
+    glBindRenderbuffer(GL_RENDERBUFFER, 0);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    TRACE(DEBUG, _b("framebuffer %p released"), fbo);
+}
+
+/* ...attach texture to the framebuffer as a colour-attachment #n */
+int fbo_attach_texture(fbo_data_t *fbo, texture_data_t *texture, int n)
+{
+    GLenum      status;
+
+    /* ...image is read back into a single texture only */
+    CHK_ERR(n == 0, -(errno = EINVAL));
+
+    if (fbo->samples > 0)
+    {
+        glFramebufferTexture2DMultisampleEXT(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->tex, 0, fbo->samples);
+    }
+    else
+    {
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture->tex, 0);
+    }
+
+    /* ...check the status of the framebuffer */
+    if ((status = glCheckFramebufferStatus(GL_FRAMEBUFFER)) != GL_FRAMEBUFFER_COMPLETE)
+    {
+        TRACE(ERROR, _x("framebuffer %p state error: %x"), fbo, status);
+        return -(errno = EINVAL);
+    }
+
+    fbo->texture = texture;
+
+    TRACE(DEBUG, _b("fbo[%p]: texture[%p] attached"), fbo, texture);
+
+    return 0;
+}
+
+/* ...destroy framebuffer */
+void fbo_destroy(fbo_data_t *fbo)
+{
+    glDeleteRenderbuffers(1, &fbo->rbo);
+    glDeleteFramebuffers(1, &fbo->fbo);
+    free(fbo);
+}
@@ -0,0 +1,68 @@
+/*******************************************************************************
+ * utest-display-offscreen.c
+ *
+ * Offscreen textures stand-in (headless benchmark)
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      OFFSCREEN
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-display.h"
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 0);
+
+/*******************************************************************************
+ * External textures handling
+ ******************************************************************************/
+
+/* ...create texture wrapping user memory (no GL objects are created) */
+texture_data_t * texture_create(int w, int h, void **data, int format)
+{
+    texture_data_t     *texture;
+
+    CHK_ERR(texture = calloc(1, sizeof(*texture)), (errno = ENOMEM, NULL));
+
+    /* ...save planes buffers pointers */
+    memcpy(texture->data, data, sizeof(texture->data));
+    texture->gray = (format == GST_VIDEO_FORMAT_GRAY8);
+
+    TRACE(INFO, _b("offscreen texture: %d*%d, format=%d, data=%p"), w, h, format, texture->data[0]);
+
+    return texture;
+}
+
+/* ...destroy texture data */
+void texture_destroy(texture_data_t *texture)
+{
+    free(texture);
+}
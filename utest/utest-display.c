@@ -146,6 +146,33 @@ typedef struct shader_data
 
 }   shader_data_t;
 
+/* ...input motion events coalesced until next delivery */
+typedef struct display_motion
+{
+    /* ...pointer motion source and its latest position */
+    input_data_t               *pointer;
+    int                         pointer_x, pointer_y;
+
+    /* ...touch motion source, contact identifier and its latest position */
+    input_data_t               *touch;
+    int                         touch_id, touch_x, touch_y;
+
+    /* ...accumulated spacenav motion (pending if type is non-zero) */
+    spnav_event                 spnav;
+
+    /* ...joystick axes with pending values and their latest values */
+    u32                         js_axes;
+    struct js_event             js[32];
+
+    /* ...time of last delivery (us) */
+    u32                         ts;
+
+    /* ...received / delivered events counters, their values and time of last report */
+    u32                         received, delivered;
+    u32                         received_last, delivered_last, report_ts;
+
+}   display_motion_t;
+
 /* ...display data */
 struct display_data
 {
@@ -194,6 +221,9 @@ struct display_data
     /* ...dispatch thread handle */
     pthread_t                   thread;
 
+    /* ...coalesced input motion */
+    display_motion_t            motion;
+
     /* ...display lock (need that really? - tbd) */
     pthread_mutex_t             lock;
 };
@@ -377,6 +407,122 @@ static inline int display_remove_poll_source(display_data_t *display, int fd)
     return epoll_ctl(display->efd, EPOLL_CTL_DEL, fd, NULL);
 }
 
+/*******************************************************************************
+ * Input motion coalescing
+ ******************************************************************************/
+
+/* ...motion delivery period (one merged event per frame at 60 fps, us) */
+#define DISPLAY_MOTION_PERIOD   16667
+
+/* ...motion statistics reporting period (us) */
+#define DISPLAY_MOTION_REPORT   5000000
+
+/* ...pass event to root widgets of all windows until it is consumed */
+static void display_broadcast_event(display_data_t *display, widget_event_t *event)
+{
+    window_data_t  *window;
+
+    wl_list_for_each(window, &display->windows, link)
+    {
+        widget_data_t  *widget = &window->widget;
+        widget_info_t  *info = widget->info;
+
+        /* ...ignore window if no input event is registered */
+        if (!info || !info->event)      continue;
+
+        /* ...pass event to root widget (only one consumer?) */
+        if (info->event(widget, window->cdata, event) != NULL)   break;
+    }
+}
+
+/* ...check if any motion is waiting for delivery */
+static inline int display_motion_pending(display_data_t *display)
+{
+    display_motion_t   *m = &display->motion;
+
+    return (m->pointer || m->touch || m->spnav.type || m->js_axes);
+}
+
+/* ...deliver coalesced motion events (called from dispatch thread) */
+static void display_motion_flush(display_data_t *display)
+{
+    display_motion_t   *m = &display->motion;
+    input_data_t       *input;
+    widget_data_t      *focus;
+    widget_event_t      event;
+    u32                 now;
+    int                 k;
+
+    if (!display_motion_pending(display))   return;
+
+    /* ...pointer position */
+    if ((input = m->pointer) != NULL)
+    {
+        m->pointer = NULL;
+
+        if ((focus = input->pointer_focus) != NULL && focus->info && focus->info->event)
+        {
+            event.type = WIDGET_EVENT_MOUSE_MOVE;
+            event.mouse.x = m->pointer_x;
+            event.mouse.y = m->pointer_y;
+            input->pointer_focus = focus->info->event(focus, focus->cdata, &event);
+            m->delivered++;
+        }
+    }
+
+    /* ...touch contact position */
+    if ((input = m->touch) != NULL)
+    {
+        m->touch = NULL;
+
+        if ((focus = input->touch_focus) != NULL && focus->info && focus->info->event)
+        {
+            event.type = WIDGET_EVENT_TOUCH_MOVE;
+            event.touch.x = m->touch_x;
+            event.touch.y = m->touch_y;
+            event.touch.id = m->touch_id;
+            input->touch_focus = focus->info->event(focus, focus->cdata, &event);
+            m->delivered++;
+
+            if (!input->touch_focus)    TRACE(DEBUG, _x("touch focus lost!"));
+        }
+    }
+
+    /* ...accumulated spacenav motion */
+    if (m->spnav.type)
+    {
+        event.type = WIDGET_EVENT_SPNAV;
+        event.spnav.e = &m->spnav;
+        display_broadcast_event(display, &event);
+        m->spnav.type = 0;
+        m->delivered++;
+    }
+
+    /* ...latest joystick axes values */
+    while (m->js_axes)
+    {
+        m->js_axes &= ~(1U << (k = __builtin_ctz(m->js_axes)));
+        event.type = WIDGET_EVENT_JOYSTICK;
+        event.js.e = &m->js[k];
+        display_broadcast_event(display, &event);
+        m->delivered++;
+    }
+
+    m->ts = now = __get_time_usec();
+
+    /* ...report incoming versus delivered rate */
+    if ((u32)(now - m->report_ts) >= DISPLAY_MOTION_REPORT)
+    {
+        u32     dt = now - m->report_ts;
+
+        TRACE(INFO, _b("input-motion: received=%u (%u/s), delivered=%u (%u/s)"),
+              m->received, (u32)((u64)(m->received - m->received_last) * 1000000 / dt),
+              m->delivered, (u32)((u64)(m->delivered - m->delivered_last) * 1000000 / dt));
+
+        m->received_last = m->received, m->delivered_last = m->delivered, m->report_ts = now;
+    }
+}
+
 /* ...display dispatch thread */
 static void * dispatch_thread(void *arg)
 {
@@ -390,6 +536,7 @@ static void * dispatch_thread(void *arg)
     while (1)
     {
         int     disp = 0;
+        int     timeout = -1;
         int     i, r;
 
         /* ...as we are preparing to poll Wayland display, add polling prologue */
@@ -406,8 +553,16 @@ static void * dispatch_thread(void *arg)
             goto error;
         }
 
+        /* ...wake up at next delivery slot if some motion is pending */
+        if (display_motion_pending(display))
+        {
+            s32     d = DISPLAY_MOTION_PERIOD - (s32)(__get_time_usec() - display->motion.ts);
+
+            timeout = (d > 0 ? (d + 999) / 1000 : 0);
+        }
+
         /* ...wait for an event */
-        if ((r = epoll_wait(display->efd, event, DISPLAY_EVENTS_NUM, -1)) < 0)
+        if ((r = epoll_wait(display->efd, event, DISPLAY_EVENTS_NUM, timeout)) < 0)
         {
             /* ...ignore soft interruptions */
             if (errno != EINTR)
@@ -455,6 +610,12 @@ static void * dispatch_thread(void *arg)
             /* ...if nothing was read from display, cancel initiated reading */
             wl_display_cancel_read(display->display);
         }
+
+        /* ...deliver coalesced motion at most once per frame period */
+        if ((u32)(__get_time_usec() - display->motion.ts) >= DISPLAY_MOTION_PERIOD)
+        {
+            display_motion_flush(display);
+        }
     }
 
     TRACE(INIT, _b("display dispatch thread terminated"));
@@ -551,6 +712,9 @@ static void pointer_handle_enter(void *data, struct wl_pointer *pointer,
     widget_event_t  event;
 
     TRACE(0, _b("input[%p]-enter: surface: %p, serial: %u, sx: %d, sy: %d"), input, surface, serial, sx, sy);
+
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(&__display);
     
     /* ...check the surface is valid */
     if (!(window = __window_lookup(surface)))   return;
@@ -582,6 +746,9 @@ static void pointer_handle_leave(void *data, struct wl_pointer *pointer,
 
     TRACE(0, _b("input[%p]-leave: surface: %p, serial: %u"), input, surface, serial);
 
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(&__display);
+
     /* ...check the surface is valid */
     if (!(window = __window_lookup(surface)))   return;
 
@@ -607,12 +774,12 @@ static void pointer_handle_leave(void *data, struct wl_pointer *pointer,
 static void pointer_handle_motion(void *data, struct wl_pointer *pointer,
             uint32_t time, wl_fixed_t sx_w, wl_fixed_t sy_w)
 {
-    input_data_t   *input = data;
-    int             sx = wl_fixed_to_int(sx_w);
-    int             sy = wl_fixed_to_int(sy_w);
-    widget_data_t  *focus;
-    widget_info_t  *info;
-    widget_event_t  event;
+    input_data_t       *input = data;
+    int                 sx = wl_fixed_to_int(sx_w);
+    int                 sy = wl_fixed_to_int(sy_w);
+    display_motion_t   *m = &__display.motion;
+    widget_data_t      *focus;
+    widget_info_t      *info;
 
     TRACE(0, _b("input[%p]: motion: sx=%d, sy=%d"), input, sx, sy);
 
@@ -625,11 +792,10 @@ static void pointer_handle_motion(void *data, struct wl_pointer *pointer,
     /* ...drop event if no processing hook set */
     if (!(info = focus->info) || !info->event)  return;
 
-    /* ...pass event to current widget */
-    event.type = WIDGET_EVENT_MOUSE_MOVE;
-    event.mouse.x = sx;
-    event.mouse.y = sy;
-    input->pointer_focus = info->event(focus, focus->cdata, &event);
+    /* ...keep latest position until next delivery */
+    (m->pointer && m->pointer != input ? display_motion_flush(&__display) : 0);
+    m->pointer = input, m->pointer_x = sx, m->pointer_y = sy;
+    m->received++;
 }
 
 /* ...button press/release processing */
@@ -643,6 +809,9 @@ static void pointer_handle_button(void *data, struct wl_pointer *pointer, uint32
 
     TRACE(0, _b("input[%p]: serial=%u, button=%u, state=%u"), input, serial, button, state);
 
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(&__display);
+
     /* ...drop event if no current focus set */
     if (!(focus = input->pointer_focus))    return;
     
@@ -670,6 +839,9 @@ static void pointer_handle_axis(void *data, struct wl_pointer *pointer,
 
     TRACE(0, _x("input[%p]: axis=%u, value=%d"), input, axis, v);
 
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(&__display);
+
     /* ...drop event if no current focus set */
     if (!(focus = input->pointer_focus))    return;
     
@@ -710,6 +882,9 @@ static void touch_handle_down(void *data, struct wl_touch *wl_touch,
     widget_event_t  event;
  
     TRACE(0, _b("input[%p]-touch-down: surface=%p, id=%u, sx=%d, sy=%d"), input, surface, id, sx, sy);
+
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(&__display);
     
     /* ...get window associated with a surface */
     if (!(window = __window_lookup(surface)))   return;
@@ -742,6 +917,9 @@ static void touch_handle_up(void *data, struct wl_touch *wl_touch,
     
     TRACE(0, _b("input[%p]-touch-up: serial=%u, id=%u"), input, serial, id);
 
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(&__display);
+
     /* ...drop event if no focus defined */
     if (!(focus = input->touch_focus))      return;
 
@@ -763,12 +941,12 @@ static void touch_handle_up(void *data, struct wl_touch *wl_touch,
 static void touch_handle_motion(void *data, struct wl_touch *wl_touch,
             uint32_t time, int32_t id, wl_fixed_t x_w, wl_fixed_t y_w)
 {
-    input_data_t   *input = data;
-    int             sx = wl_fixed_to_int(x_w);
-    int             sy = wl_fixed_to_int(y_w);
-    widget_data_t  *focus;
-    widget_info_t  *info;
-    widget_event_t  event;
+    input_data_t       *input = data;
+    int                 sx = wl_fixed_to_int(x_w);
+    int                 sy = wl_fixed_to_int(y_w);
+    display_motion_t   *m = &__display.motion;
+    widget_data_t      *focus;
+    widget_info_t      *info;
     
     TRACE(0, _b("input[%p]-move: id=%u, sx=%d, sy=%d (focus: %p)"), input, id, sx, sy, input->touch_focus);
 
@@ -778,14 +956,10 @@ static void touch_handle_motion(void *data, struct wl_touch *wl_touch,
     /* ...drop event if no processing is registered */
     if (!(info = focus->info) || !info->event)  return;
 
-    /* ...pass event to current widget */
-    event.type = WIDGET_EVENT_TOUCH_MOVE;
-    event.touch.x = sx;
-    event.touch.y = sy;
-    event.touch.id = id;
-    input->touch_focus = info->event(focus, focus->cdata, &event);
-
-    if (!input->touch_focus)    TRACE(DEBUG, _x("touch focus lost!"));
+    /* ...keep latest position of the contact until next delivery */
+    (m->touch && (m->touch != input || m->touch_id != id) ? display_motion_flush(&__display) : 0);
+    m->touch = input, m->touch_id = id, m->touch_x = sx, m->touch_y = sy;
+    m->received++;
 }
 
 /* ...end of touch frame (gestures recognition?) */
@@ -840,6 +1014,9 @@ static void keyboard_handle_enter(void *data, struct wl_keyboard *keyboard,
 
     TRACE(DEBUG, _b("input[%p]: key-enter: surface: %p"), input, surface);
 
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(&__display);
+
     /* ...get window associated with a surface */
     if (!(window = __window_lookup(surface)))   return;
 
@@ -868,6 +1045,9 @@ static void keyboard_handle_leave(void *data, struct wl_keyboard *keyboard,
 
     TRACE(DEBUG, _b("input[%p]: key-leave: surface: %p"), input, surface);
 
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(&__display);
+
     /* ...find a target widget */
     if (!(window = __window_lookup(surface)))   return;
 
@@ -896,6 +1076,9 @@ static void keyboard_handle_key(void *data, struct wl_keyboard *keyboard,
 
     TRACE(DEBUG, _b("input[%p]: key-press: key=%u, state=%u"), input, key, state);
 
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(&__display);
+
     /* ...ignore event if no focus defined */
     if (!(focus = input->keyboard_focus))   return;
     
@@ -922,6 +1105,9 @@ static void keyboard_handle_modifiers(void *data, struct wl_keyboard *keyboard,
 
     TRACE(DEBUG, _b("input[%p]: mods-press: press=%X, latched=%X, locked=%X, group=%X"), input, mods_depressed, mods_latched, mods_locked, group);
 
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(&__display);
+
     /* ...ignore event if no focus defined */
     if (!(focus = input->keyboard_focus))   return;
     
@@ -1038,9 +1224,9 @@ static inline void display_add_input(display_data_t *display, struct wl_registry
 /* ...spacenav input event processing */
 static int input_spacenav_event(display_data_t *display, display_source_cb_t *cb, u32 events)
 {
-    widget_event_t  event;
-    spnav_event     e;
-    window_data_t  *window;
+    display_motion_t   *m = &display->motion;
+    widget_event_t      event;
+    spnav_event         e;
     
     /* ...drop event if no reading flag set */
     if ((events & EPOLLIN) == 0)        return 0;
@@ -1048,22 +1234,33 @@ static int input_spacenav_event(display_data_t *display, display_source_cb_t *cb
     /* ...retrieve poll event */
     if (CHK_API(spnav_poll_event(&e)) == 0)     return 0;
 
+    /* ...accumulate motion deltas until next delivery */
+    if (e.type == SPNAV_EVENT_MOTION)
+    {
+        if (!m->spnav.type)
+        {
+            m->spnav = e;
+        }
+        else
+        {
+            m->spnav.motion.x += e.motion.x, m->spnav.motion.y += e.motion.y, m->spnav.motion.z += e.motion.z;
+            m->spnav.motion.rx += e.motion.rx, m->spnav.motion.ry += e.motion.ry, m->spnav.motion.rz += e.motion.rz;
+            m->spnav.motion.period += e.motion.period;
+        }
+
+        m->received++;
+        return 0;
+    }
+
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(display);
+
     /* ...preare widget event */
     event.type = WIDGET_EVENT_SPNAV;
     event.spnav.e = &e;
 
     /* ...pass to all windows */
-    wl_list_for_each(window, &display->windows, link)
-    {
-        widget_data_t  *widget = &window->widget;
-        widget_info_t  *info = widget->info;
-
-        /* ...ignore window if no input event is registered */
-        if (!info || !info->event)      continue;
-
-        /* ...pass event to root widget (only one consumer?) */
-        if (info->event(widget, window->cdata, &event) != NULL)   break;
-    }
+    display_broadcast_event(display, &event);
 
     return 0;
 }
@@ -1128,9 +1325,9 @@ typedef struct joystick_data
 static int input_joystick_event(display_data_t *display, display_source_cb_t *cb, u32 events)
 {
     joystick_data_t    *js = (joystick_data_t *)cb;
+    display_motion_t   *m = &display->motion;
     widget_event_t      event;
     struct js_event     e;
-    window_data_t      *window;
     
     /* ...drop event if no reading flag set */
     if ((events & EPOLLIN) == 0)        return 0;
@@ -1138,24 +1335,25 @@ static int input_joystick_event(display_data_t *display, display_source_cb_t *cb
     /* ...retrieve poll event */
     CHK_ERR(read(js->fd, &e, sizeof(e)) == sizeof(e), -errno);
 
+    TRACE(DEBUG, _b("joystick event: type=%x, value=%x, number=%x"), e.type & ~JS_EVENT_INIT, e.value, e.number);    
+
+    /* ...keep latest axis position until next delivery */
+    if (e.type == JS_EVENT_AXIS && e.number < 32)
+    {
+        m->js[e.number] = e, m->js_axes |= 1U << e.number;
+        m->received++;
+        return 0;
+    }
+
+    /* ...deliver pending motion first to keep events order */
+    display_motion_flush(display);
+
     /* ...preare widget event */
     event.type = WIDGET_EVENT_JOYSTICK;
     event.js.e = &e;
 
-    TRACE(DEBUG, _b("joystick event: type=%x, value=%x, number=%x"), e.type & ~JS_EVENT_INIT, e.value, e.number);    
-
     /* ...pass to all windows */
-    wl_list_for_each(window, &display->windows, link)
-    {
-        widget_data_t  *widget = &window->widget;
-        widget_info_t  *info = widget->info;
-        
-        /* ...ignore window if no input event is registered */
-        if (!info || !info->event)      continue;
-
-        /* ...pass event to root widget (only one consumer?) */
-        if (info->event(widget, window->cdata, &event) != NULL)   break;
-    }
+    display_broadcast_event(display, &event);
 
     return 0;
 }
@@ -2134,7 +2332,8 @@ window_data_t * window_create(display_data_t *display, window_info_t *info, widg
     output_data_t      *output;
     window_data_t      *window;
     struct wl_region   *region;
-    pthread_attr_t      attr;
+    static int          index;
+    char                name[16];
     int                 r;
 
     /* ...make sure we have a valid output device */
@@ -2236,13 +2435,9 @@ window_data_t * window_create(display_data_t *display, window_info_t *info, widg
     /* ...releaset window EGL context */
     eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
 
-    /* ...initialize thread attributes (joinable, default stack size) */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
     /* ...create rendering thread */
-    r = pthread_create(&window->thread, &attr, window_thread, window);
-    pthread_attr_destroy(&attr);
+    sprintf(name, "window-%d", __atomic_fetch_add(&index, 1, __ATOMIC_RELAXED));
+    r = thread_create(&window->thread, name, 0, NULL, window_thread, window);
     if (r != 0)
     {
         TRACE(ERROR, _x("thread creation failed: %m"));
@@ -2469,7 +2664,6 @@ void window_put_cairo(window_data_t *window, cairo_t *cr)
 display_data_t * display_create(void)
 {
     display_data_t     *display = &__display;
-    pthread_attr_t      attr;
     int                 r;
 
     /* ...reset display data */
@@ -2542,13 +2736,8 @@ display_data_t * display_create(void)
     /* ...release display EGL context */
     eglMakeCurrent(display->egl.dpy, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
 
-    /* ...initialize thread attributes (joinable, default stack size) */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-
     /* ...create Wayland dispatch thread */
-    r = pthread_create(&display->thread, &attr, dispatch_thread, display);
-    pthread_attr_destroy(&attr);
+    r = thread_create(&display->thread, "dispatch", 0, NULL, dispatch_thread, display);
     if (r != 0)
     {
         TRACE(ERROR, _x("thread creation failed: %m"));
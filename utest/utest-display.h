@@ -329,6 +329,18 @@ extern void fbo_put(fbo_data_t *fbo);
 /* ...attach texture as color-attachment #n */
 extern int fbo_attach_texture(fbo_data_t *fbo, texture_data_t *texture, int n);
 
+/*******************************************************************************
+ * Headless rendering (utest-display-egl.c; no display server)
+ ******************************************************************************/
+
+/* ...initialize/shutdown EGL on surfaceless platform (or default display) */
+extern int egl_headless_init(void);
+extern void egl_headless_fini(void);
+
+/* ...create private context current in a calling thread / release it */
+extern int egl_headless_bind(void);
+extern void egl_headless_unbind(void);
+
 /*******************************************************************************
  * Public API
  ******************************************************************************/
@@ -0,0 +1,719 @@
+/*******************************************************************************
+ * utest-imr-cpu.c
+ *
+ * IMR device emulation on CPU (benchmark stand-in)
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      IMR-CPU
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "imr-v4l2-api.h"
+#include <fcntl.h>
+#include <math.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/time.h>
+#include <linux/videodev2.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...prefix of device names served by emulation */
+#define IMR_CPU_PREFIX                  "imr-cpu:"
+
+/* ...maximal number of emulated devices */
+#define IMR_CPU_DEVICES                 16
+
+/* ...maximal number of buffer-pairs per device */
+#define IMR_CPU_BUFFERS                 32
+
+/* ...destination coordinates fractional bits in sub-pixel mode */
+#define IMR_CPU_DDP_SHIFT               2
+
+/* ...buffer-pair slot state */
+#define IMR_CPU_INPUT                   (1 << 0)
+#define IMR_CPU_OUTPUT                  (1 << 1)
+
+/*******************************************************************************
+ * Local types definitions
+ ******************************************************************************/
+
+/* ...triangle vertex in pixel units */
+typedef struct imr_cpu_vertex
+{
+    /* ...destination coordinates */
+    float                   x, y;
+
+    /* ...source coordinates */
+    float                   u, v;
+
+}   imr_cpu_vertex_t;
+
+/* ...buffer-pair slot */
+typedef struct imr_cpu_slot
+{
+    /* ...user-provided input/output memory */
+    void                   *input, *output;
+
+    /* ...queueing state */
+    u32                     flags;
+
+    /* ...processing start/end timestamps */
+    struct timeval          t0, t1;
+
+}   imr_cpu_slot_t;
+
+/* ...emulated device instance */
+typedef struct imr_cpu_device
+{
+    /* ...event descriptor exposed as a device handle (readable if job is complete) */
+    int                     fd;
+
+    /* ...input/output dimensions */
+    int                     w, h, W, H;
+
+    /* ...input/output pixel formats */
+    u32                     ifmt, ofmt;
+
+    /* ...number of allocated buffer-pairs */
+    int                     num;
+
+    /* ...buffer-pairs */
+    imr_cpu_slot_t          slot[IMR_CPU_BUFFERS];
+
+    /* ...pending and completed jobs (slot indices) */
+    GQueue                  pending, done;
+
+    /* ...current mapping (triangles list) */
+    imr_cpu_vertex_t       *vbo;
+
+    /* ...number of triangles in a mapping */
+    int                     vbo_num;
+
+    /* ...streaming and processing state */
+    int                     streaming, busy, active;
+
+    /* ...device access lock */
+    pthread_mutex_t         lock;
+
+    /* ...worker wakeup / job completion condition */
+    pthread_cond_t          wait;
+
+    /* ...processing thread */
+    pthread_t               thread;
+
+}   imr_cpu_device_t;
+
+/*******************************************************************************
+ * Real system calls (resolved through linker wrapping)
+ ******************************************************************************/
+
+extern int __real_open(const char *path, int flags, ...);
+extern int __real_close(int fd);
+extern int __real_ioctl(int fd, unsigned long request, ...);
+
+/*******************************************************************************
+ * Static data
+ ******************************************************************************/
+
+/* ...emulated devices table */
+static imr_cpu_device_t    *__imr_cpu[IMR_CPU_DEVICES];
+
+/* ...table access lock */
+static pthread_mutex_t      __imr_cpu_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/*******************************************************************************
+ * Internal helpers
+ ******************************************************************************/
+
+/* ...locate emulated device by descriptor */
+static inline imr_cpu_device_t * __imr_cpu_device(int fd)
+{
+    imr_cpu_device_t   *dev = NULL;
+    int                 i;
+
+    pthread_mutex_lock(&__imr_cpu_lock);
+
+    for (i = 0; i < IMR_CPU_DEVICES; i++)
+    {
+        if (__imr_cpu[i] && __imr_cpu[i]->fd == fd)
+        {
+            dev = __imr_cpu[i];
+            break;
+        }
+    }
+
+    pthread_mutex_unlock(&__imr_cpu_lock);
+
+    return dev;
+}
+
+/* ...bytes per pixel of supported formats */
+static inline int __imr_cpu_bpp(u32 fmt)
+{
+    switch (fmt)
+    {
+    case V4L2_PIX_FMT_GREY:         return 1;
+    case V4L2_PIX_FMT_UYVY:
+    case V4L2_PIX_FMT_YUYV:
+    case V4L2_PIX_FMT_YVYU:
+    case V4L2_PIX_FMT_RGB565:
+    case V4L2_PIX_FMT_RGB555:       return 2;
+    case V4L2_PIX_FMT_ARGB32:       return 4;
+    default:                        return 0;
+    }
+}
+
+/* ...copy single pixel (packed YUV 4:2:2 chroma is taken from the macro-pixel) */
+static inline void __imr_cpu_pixel(u32 fmt, u8 *d, int X, const u8 *s, int x)
+{
+    switch (fmt)
+    {
+    case V4L2_PIX_FMT_GREY:
+        d[X] = s[x];
+        break;
+
+    case V4L2_PIX_FMT_UYVY:
+        d[2 * X + 1] = s[2 * x + 1];
+        d[2 * X] = s[4 * (x >> 1) + 2 * (X & 1)];
+        break;
+
+    case V4L2_PIX_FMT_YUYV:
+    case V4L2_PIX_FMT_YVYU:
+        d[2 * X] = s[2 * x];
+        d[2 * X + 1] = s[4 * (x >> 1) + 1 + 2 * (X & 1)];
+        break;
+
+    case V4L2_PIX_FMT_RGB565:
+    case V4L2_PIX_FMT_RGB555:
+        memcpy(d + 2 * X, s + 2 * x, 2);
+        break;
+
+    default:
+        memcpy(d + 4 * X, s + 4 * x, 4);
+    }
+}
+
+/* ...signed doubled area of a triangle */
+static inline float __imr_cpu_edge(float x0, float y0, float x1, float y1, float x, float y)
+{
+    return (x1 - x0) * (y - y0) - (y1 - y0) * (x - x0);
+}
+
+/* ...render single triangle with nearest-neighbour sampling */
+static void __imr_cpu_triangle(imr_cpu_device_t *dev, const imr_cpu_vertex_t *t, const u8 *in, u8 *out)
+{
+    int     bpp = __imr_cpu_bpp(dev->ofmt);
+    float   area, x0, x1, y0, y1;
+    int     X0, X1, Y0, Y1, X, Y;
+
+    /* ...discard degenerated triangles */
+    if ((area = __imr_cpu_edge(t[0].x, t[0].y, t[1].x, t[1].y, t[2].x, t[2].y)) > -1e-3f && area < 1e-3f)   return;
+
+    /* ...determine bounding box clipped by destination plane */
+    x0 = fminf(t[0].x, fminf(t[1].x, t[2].x)), x1 = fmaxf(t[0].x, fmaxf(t[1].x, t[2].x));
+    y0 = fminf(t[0].y, fminf(t[1].y, t[2].y)), y1 = fmaxf(t[0].y, fmaxf(t[1].y, t[2].y));
+    X0 = (x0 < 0 ? 0 : (int)x0), X1 = (x1 >= dev->W ? dev->W - 1 : (int)x1);
+    Y0 = (y0 < 0 ? 0 : (int)y0), Y1 = (y1 >= dev->H ? dev->H - 1 : (int)y1);
+
+    for (Y = Y0; Y <= Y1; Y++)
+    {
+        u8     *d = out + (size_t)Y * dev->W * bpp;
+        float   y = Y + 0.5f;
+
+        for (X = X0; X <= X1; X++)
+        {
+            float   x = X + 0.5f, b0, b1, b2;
+            int     u, v;
+
+            /* ...calculate barycentric coordinates; skip pixels outside of triangle */
+            if ((b0 = __imr_cpu_edge(t[1].x, t[1].y, t[2].x, t[2].y, x, y) / area) < 0)     continue;
+            if ((b1 = __imr_cpu_edge(t[2].x, t[2].y, t[0].x, t[0].y, x, y) / area) < 0)     continue;
+            if ((b2 = 1.0f - b0 - b1) < 0)                                                  continue;
+
+            /* ...interpolate source coordinates */
+            u = (int)(b0 * t[0].u + b1 * t[1].u + b2 * t[2].u);
+            v = (int)(b0 * t[0].v + b1 * t[1].v + b2 * t[2].v);
+            (u < 0 ? u = 0 : (u >= dev->w ? u = dev->w - 1 : 0));
+            (v < 0 ? v = 0 : (v >= dev->h ? v = dev->h - 1 : 0));
+
+            __imr_cpu_pixel(dev->ofmt, d, X, in + (size_t)v * dev->w * bpp, u);
+        }
+    }
+}
+
+/* ...process single buffer-pair */
+static void __imr_cpu_render(imr_cpu_device_t *dev, imr_cpu_slot_t *slot, const imr_cpu_vertex_t *vbo, int n)
+{
+    int     i;
+
+    /* ...areas not covered by the mapping are left black (zero) */
+    memset(slot->output, 0, (size_t)dev->W * dev->H * __imr_cpu_bpp(dev->ofmt));
+
+    for (i = 0; i < n; i++, vbo += 3)
+    {
+        __imr_cpu_triangle(dev, vbo, slot->input, slot->output);
+    }
+}
+
+/*******************************************************************************
+ * Processing thread
+ ******************************************************************************/
+
+static void * imr_cpu_thread(void *arg)
+{
+    imr_cpu_device_t   *dev = arg;
+    u64                 one = 1;
+
+    pthread_mutex_lock(&dev->lock);
+
+    while (1)
+    {
+        imr_cpu_slot_t     *slot;
+        imr_cpu_vertex_t   *vbo;
+        int                 j, n;
+
+        /* ...wait for a job submission */
+        while (dev->active && (!dev->streaming || g_queue_is_empty(&dev->pending)))
+        {
+            pthread_cond_wait(&dev->wait, &dev->lock);
+        }
+
+        if (!dev->active)   break;
+
+        /* ...get oldest job */
+        slot = &dev->slot[j = GPOINTER_TO_INT(g_queue_pop_head(&dev->pending))];
+        vbo = dev->vbo, n = dev->vbo_num, dev->busy = 1;
+        gettimeofday(&slot->t0, NULL);
+
+        /* ...mapping is applied without a lock held (it is replaced only in idle state) */
+        pthread_mutex_unlock(&dev->lock);
+        __imr_cpu_render(dev, slot, vbo, n);
+        pthread_mutex_lock(&dev->lock);
+
+        gettimeofday(&slot->t1, NULL);
+        dev->busy = 0;
+
+        /* ...put job into completion queue unless streaming has been stopped */
+        if (dev->streaming)
+        {
+            g_queue_push_tail(&dev->done, GINT_TO_POINTER(j));
+            (write(dev->fd, &one, sizeof(one)) < 0 ? TRACE(ERROR, _x("signal failed: %m")) : 0);
+        }
+
+        /* ...notify waiters about idle state */
+        pthread_cond_broadcast(&dev->wait);
+    }
+
+    pthread_mutex_unlock(&dev->lock);
+
+    return NULL;
+}
+
+/* ...wait until processing thread is idle (called with a lock held) */
+static inline void __imr_cpu_idle(imr_cpu_device_t *dev)
+{
+    while (dev->busy)
+    {
+        pthread_cond_wait(&dev->wait, &dev->lock);
+    }
+}
+
+/*******************************************************************************
+ * V4L2 interface emulation
+ ******************************************************************************/
+
+/* ...set format */
+static int imr_cpu_s_fmt(imr_cpu_device_t *dev, struct v4l2_format *fmt)
+{
+    struct v4l2_pix_format *pix = &fmt->fmt.pix;
+
+    /* ...check format is supported */
+    CHK_ERR(__imr_cpu_bpp(pix->pixelformat), -(errno = EINVAL));
+
+    if (fmt->type == V4L2_BUF_TYPE_VIDEO_OUTPUT)
+    {
+        dev->w = pix->width, dev->h = pix->height, dev->ifmt = pix->pixelformat;
+    }
+    else
+    {
+        dev->W = pix->width, dev->H = pix->height, dev->ofmt = pix->pixelformat;
+    }
+
+    /* ...format conversion is not supported */
+    CHK_ERR(!dev->ifmt || !dev->ofmt || dev->ifmt == dev->ofmt, -(errno = EINVAL));
+
+    return 0;
+}
+
+/* ...set mapping */
+static int imr_cpu_mesh(imr_cpu_device_t *dev, struct imr_map_desc *desc)
+{
+    float               us = 1.0f / (1 << ((desc->type & __IMR_MAP_UVDPOR_MASK) >> __IMR_MAP_UVDPOR_SHIFT));
+    float               xs = 1.0f / (desc->type & IMR_MAP_DDP ? 1 << IMR_CPU_DDP_SHIFT : 1);
+    imr_cpu_vertex_t   *vbo, *t;
+    int                 n, i;
+
+    /* ...only absolute coordinates are supported */
+    CHK_ERR(!(desc->type & IMR_MAP_AUTOSG), -(errno = EINVAL));
+
+    if (desc->type & IMR_MAP_MESH)
+    {
+        struct imr_mesh        *mesh = desc->data;
+        struct imr_src_coord   *c = (void *)(mesh + 1);
+        int                     r, k;
+
+        /* ...rectangular mesh with auto-generated destination coordinates */
+        CHK_ERR(desc->type & IMR_MAP_AUTODG, -(errno = EINVAL));
+        CHK_ERR(mesh->rows > 1 && mesh->columns > 1, -(errno = EINVAL));
+
+        /* ...split every cell into two triangles */
+        n = 2 * (mesh->rows - 1) * (mesh->columns - 1);
+        CHK_ERR(t = vbo = malloc(3 * n * sizeof(*vbo)), -(errno = ENOMEM));
+
+        for (r = 0; r < mesh->rows - 1; r++)
+        {
+            for (k = 0; k < mesh->columns - 1; k++)
+            {
+                static const int    o[6][2] = { {0, 0}, {0, 1}, {1, 0}, {1, 0}, {0, 1}, {1, 1} };
+                int                 m;
+
+                for (m = 0; m < 6; m++, t++)
+                {
+                    struct imr_src_coord   *s = &c[(r + o[m][0]) * mesh->columns + k + o[m][1]];
+
+                    t->x = (mesh->x0 + (k + o[m][1]) * mesh->dx) * xs;
+                    t->y = (mesh->y0 + (r + o[m][0]) * mesh->dy) * xs;
+                    t->u = s->u * us, t->v = s->v * us;
+                }
+            }
+        }
+    }
+    else
+    {
+        struct imr_vbo         *v = desc->data;
+        struct imr_abs_coord   *c = (void *)(v + 1);
+
+        /* ...triangles list with absolute coordinates */
+        n = v->num;
+        CHK_ERR(t = vbo = malloc(3 * n * sizeof(*vbo) + 1), -(errno = ENOMEM));
+
+        for (i = 0; i < 3 * n; i++, t++, c++)
+        {
+            t->x = c->X * xs, t->y = c->Y * xs;
+            t->u = c->u * us, t->v = c->v * us;
+        }
+    }
+
+    /* ...replace mapping once the engine is idle */
+    __imr_cpu_idle(dev);
+    free(dev->vbo), dev->vbo = vbo, dev->vbo_num = n;
+
+    TRACE(DEBUG, _b("device %d: mapping set (%d triangles)"), dev->fd, n);
+
+    return 0;
+}
+
+/* ...queue buffer */
+static int imr_cpu_qbuf(imr_cpu_device_t *dev, struct v4l2_buffer *buf)
+{
+    imr_cpu_slot_t     *slot;
+
+    CHK_ERR(buf->index < (u32)dev->num && buf->memory == V4L2_MEMORY_USERPTR, -(errno = EINVAL));
+
+    slot = &dev->slot[buf->index];
+
+    if (buf->type == V4L2_BUF_TYPE_VIDEO_OUTPUT)
+    {
+        CHK_ERR(buf->bytesused >= (u32)(dev->w * dev->h * __imr_cpu_bpp(dev->ifmt)), -(errno = EINVAL));
+        slot->input = (void *)(uintptr_t)buf->m.userptr, slot->flags |= IMR_CPU_INPUT;
+    }
+    else
+    {
+        CHK_ERR(buf->length >= (u32)(dev->W * dev->H * __imr_cpu_bpp(dev->ofmt)), -(errno = EINVAL));
+        slot->output = (void *)(uintptr_t)buf->m.userptr, slot->flags |= IMR_CPU_OUTPUT;
+    }
+
+    /* ...submit a job as soon as both buffers of a pair are queued */
+    if (slot->flags == (IMR_CPU_INPUT | IMR_CPU_OUTPUT))
+    {
+        slot->flags = 0;
+        g_queue_push_tail(&dev->pending, GINT_TO_POINTER((int)buf->index));
+        pthread_cond_broadcast(&dev->wait);
+    }
+
+    return 0;
+}
+
+/* ...dequeue buffer (input buffer of a pair is returned first) */
+static int imr_cpu_dqbuf(imr_cpu_device_t *dev, struct v4l2_buffer *buf)
+{
+    imr_cpu_slot_t     *slot;
+    u64                 value;
+    int                 j;
+
+    /* ...check if we have a completed job */
+    if (g_queue_is_empty(&dev->done))       return -(errno = EAGAIN);
+
+    slot = &dev->slot[j = GPOINTER_TO_INT(g_queue_peek_head(&dev->done))];
+    buf->index = j, buf->flags = 0;
+
+    if (buf->type == V4L2_BUF_TYPE_VIDEO_OUTPUT)
+    {
+        buf->timestamp = slot->t0;
+    }
+    else
+    {
+        buf->timestamp = slot->t1;
+        g_queue_pop_head(&dev->done);
+
+        /* ...consume completion event */
+        CHK_ERR(read(dev->fd, &value, sizeof(value)) == sizeof(value), -errno);
+    }
+
+    return 0;
+}
+
+/* ...start/stop streaming */
+static int imr_cpu_streaming(imr_cpu_device_t *dev, int enable)
+{
+    u64     value;
+
+    if (!(dev->streaming = enable))
+    {
+        /* ...drop all queued and completed jobs */
+        __imr_cpu_idle(dev);
+        g_queue_clear(&dev->pending);
+        g_queue_clear(&dev->done);
+        memset(dev->slot, 0, sizeof(dev->slot));
+
+        /* ...reset completion events counter */
+        while (read(dev->fd, &value, sizeof(value)) == sizeof(value))
+            ;
+    }
+    else
+    {
+        pthread_cond_broadcast(&dev->wait);
+    }
+
+    return 0;
+}
+
+/* ...process control command */
+static int imr_cpu_ioctl(imr_cpu_device_t *dev, unsigned long request, void *arg)
+{
+    switch (request)
+    {
+    case VIDIOC_QUERYCAP:
+    {
+        struct v4l2_capability *cap = arg;
+
+        memset(cap, 0, sizeof(*cap));
+        strcpy((char *)cap->driver, "imr-cpu");
+        cap->capabilities = cap->device_caps = V4L2_CAP_VIDEO_OUTPUT | V4L2_CAP_VIDEO_CAPTURE | V4L2_CAP_STREAMING;
+        return 0;
+    }
+
+    case VIDIOC_S_FMT:
+        return imr_cpu_s_fmt(dev, arg);
+
+    case VIDIOC_REQBUFS:
+    {
+        struct v4l2_requestbuffers *req = arg;
+
+        CHK_ERR(!dev->streaming, -(errno = EBUSY));
+        (req->count > IMR_CPU_BUFFERS ? req->count = IMR_CPU_BUFFERS : 0);
+        dev->num = req->count;
+        return 0;
+    }
+
+    case VIDIOC_STREAMON:
+        return imr_cpu_streaming(dev, 1);
+
+    case VIDIOC_STREAMOFF:
+        return imr_cpu_streaming(dev, 0);
+
+    case VIDIOC_QBUF:
+        return imr_cpu_qbuf(dev, arg);
+
+    case VIDIOC_DQBUF:
+        return imr_cpu_dqbuf(dev, arg);
+
+    case VIDIOC_IMR_MESH:
+        return imr_cpu_mesh(dev, arg);
+
+    default:
+        TRACE(ERROR, _x("unsupported request: %lX"), request);
+        return -(errno = ENOTTY);
+    }
+}
+
+/*******************************************************************************
+ * System calls interception
+ ******************************************************************************/
+
+/* ...open device (emulated devices are named "imr-cpu:<n>") */
+int __wrap_open(const char *path, int flags, ...)
+{
+    imr_cpu_device_t   *dev;
+    va_list             args;
+    mode_t              mode = 0;
+    int                 i;
+
+    if (strncmp(path, IMR_CPU_PREFIX, sizeof(IMR_CPU_PREFIX) - 1))
+    {
+        /* ...pass creation mode if specified */
+        if (flags & O_CREAT)
+        {
+            va_start(args, flags);
+            mode = va_arg(args, mode_t);
+            va_end(args);
+        }
+
+        return __real_open(path, flags, mode);
+    }
+
+    /* ...create device instance */
+    CHK_ERR(dev = calloc(1, sizeof(*dev)), -(errno = ENOMEM));
+
+    if ((dev->fd = eventfd(0, EFD_SEMAPHORE | EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+    {
+        TRACE(ERROR, _x("failed to create event descriptor: %m"));
+        goto error;
+    }
+
+    g_queue_init(&dev->pending);
+    g_queue_init(&dev->done);
+    pthread_mutex_init(&dev->lock, NULL);
+    pthread_cond_init(&dev->wait, NULL);
+    dev->active = 1;
+
+    if ((errno = pthread_create(&dev->thread, NULL, imr_cpu_thread, dev)) != 0)
+    {
+        TRACE(ERROR, _x("failed to create thread: %m"));
+        goto error_fd;
+    }
+
+    /* ...register device */
+    pthread_mutex_lock(&__imr_cpu_lock);
+    for (i = 0; i < IMR_CPU_DEVICES && __imr_cpu[i]; i++)
+        ;
+    (i < IMR_CPU_DEVICES ? __imr_cpu[i] = dev : NULL);
+    pthread_mutex_unlock(&__imr_cpu_lock);
+
+    if (i == IMR_CPU_DEVICES)
+    {
+        TRACE(ERROR, _x("too many devices"));
+        errno = EMFILE;
+        goto error_thread;
+    }
+
+    TRACE(INIT, _b("emulated device '%s' opened: fd=%d"), path, dev->fd);
+
+    return dev->fd;
+
+error_thread:
+    pthread_mutex_lock(&dev->lock);
+    dev->active = 0;
+    pthread_cond_broadcast(&dev->wait);
+    pthread_mutex_unlock(&dev->lock);
+    pthread_join(dev->thread, NULL);
+
+error_fd:
+    __real_close(dev->fd);
+
+error:
+    free(dev);
+    return -1;
+}
+
+/* ...close descriptor */
+int __wrap_close(int fd)
+{
+    imr_cpu_device_t   *dev = __imr_cpu_device(fd);
+    int                 i;
+
+    if (!dev)   return __real_close(fd);
+
+    /* ...unregister device */
+    pthread_mutex_lock(&__imr_cpu_lock);
+    for (i = 0; i < IMR_CPU_DEVICES; i++)
+    {
+        (__imr_cpu[i] == dev ? __imr_cpu[i] = NULL : NULL);
+    }
+    pthread_mutex_unlock(&__imr_cpu_lock);
+
+    /* ...terminate processing thread */
+    pthread_mutex_lock(&dev->lock);
+    dev->active = 0;
+    pthread_cond_broadcast(&dev->wait);
+    pthread_mutex_unlock(&dev->lock);
+    pthread_join(dev->thread, NULL);
+
+    g_queue_clear(&dev->pending);
+    g_queue_clear(&dev->done);
+    pthread_cond_destroy(&dev->wait);
+    pthread_mutex_destroy(&dev->lock);
+    free(dev->vbo);
+    __real_close(fd);
+    free(dev);
+
+    return 0;
+}
+
+/* ...control command */
+int __wrap_ioctl(int fd, unsigned long request, ...)
+{
+    imr_cpu_device_t   *dev = __imr_cpu_device(fd);
+    va_list             args;
+    void               *arg;
+    int                 r;
+
+    va_start(args, request);
+    arg = va_arg(args, void *);
+    va_end(args);
+
+    if (!dev)   return __real_ioctl(fd, request, arg);
+
+    pthread_mutex_lock(&dev->lock);
+    r = imr_cpu_ioctl(dev, request, arg);
+    pthread_mutex_unlock(&dev->lock);
+
+    return (r < 0 ? -1 : 0);
+}
@@ -34,6 +34,7 @@
 #include "utest-app.h"
 #include "utest-gui.h"
 #include "utest-png.h"
+#include "utest-pool.h"
 #include <math.h>
 
 /*******************************************************************************
@@ -48,6 +49,20 @@ TRACE_TAG(DEBUG, 1);
  * Local types definitions
  ******************************************************************************/
 
+/* ...thumbnail decoding descriptor */
+typedef struct carousel_cell
+{
+    /* ...owning menu */
+    carousel_t             *menu;
+
+    /* ...thumbnail position in the atlas */
+    int                     i, j;
+
+    /* ...image file name */
+    char                   *path;
+
+}   carousel_cell_t;
+
 struct carousel
 {
     /* ...viewport for menu visualization */
@@ -71,6 +86,13 @@ struct carousel
     /* ...texture containing the thumbnails */
     GLuint                  tex;
 
+    /* ...thumbnails being decoded into staging image (uploaded in one batch once all are ready) */
+    carousel_cell_t        *cell;
+    void                   *staging;
+
+    /* ...number of thumbnails not decoded yet */
+    int                     pending;
+
     /* ...menu configuration */
     const carousel_cfg_t   *cfg;
     
@@ -108,6 +130,9 @@ struct carousel
 
 #define RESOURCES_DIR   "."
 
+/* ...placeholder cell color shown until thumbnails are decoded (R, G, B, A bytes) */
+#define CAROUSEL_PLACEHOLDER            0x80303030
+
 /*******************************************************************************
  * Local constants
  ******************************************************************************/
@@ -608,6 +633,32 @@ static shader_data_t   *__carousel_shader;
 #define U(id)       u[UNIFORM(CAROUSEL, id)]
 #define A(id)       ATTRIBUTE(CAROUSEL, id)
 
+/* ...upload decoded thumbnails into the atlas (called from GL context) */
+static void carousel_upload(carousel_t *menu)
+{
+    const carousel_cfg_t   *cfg = menu->cfg;
+    int                     n = cfg->size, m = cfg->size_y;
+    int                     k;
+
+    /* ...wait until the whole set is decoded */
+    if (!menu->cell || __atomic_load_n(&menu->pending, __ATOMIC_ACQUIRE) > 0)     return;
+
+    /* ...cells that failed to decode keep a placeholder */
+    glBindTexture(GL_TEXTURE_2D, menu->tex);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, n * cfg->width, m * cfg->height, GL_RGBA, GL_UNSIGNED_BYTE, menu->staging);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    for (k = 0; k < n * m; k++)
+    {
+        free(menu->cell[k].path);
+    }
+
+    free(menu->cell), menu->cell = NULL;
+    free(menu->staging), menu->staging = NULL;
+
+    TRACE(INIT, _b("carousel thumbnails uploaded"));
+}
+
 /* ...widget rendering function */
 void carousel_draw(carousel_t *menu)
 {
@@ -620,6 +671,9 @@ void carousel_draw(carousel_t *menu)
     texture_crop_t  tcoord;
     GLint           saved_program = 0;
     float           delta, delta_y;
+
+    /* ...put thumbnails in place as soon as they are ready */
+    carousel_upload(menu);
     
     /* ...bail out if menu is inactive */
     if (menu->alpha <= 0)       return;
@@ -843,6 +897,30 @@ int carousel_spnav_event(carousel_t *menu, spnav_event *e)
     return 0;
 }
 
+/*******************************************************************************
+ * Thumbnails decoding
+ ******************************************************************************/
+
+/* ...thumbnail decoding task (runs on pool workers) */
+static void carousel_decode_task(void *arg)
+{
+    carousel_cell_t    *cell = arg;
+    carousel_t         *menu = cell->menu;
+    int                 w = menu->cfg->width, h = menu->cfg->height;
+    int                 stride = menu->cfg->size * w * 4;
+    int                 format = GST_VIDEO_FORMAT_ARGB;
+    u8                 *data = (u8 *)menu->staging + cell->i * h * stride + cell->j * w * 4;
+
+    /* ...decode rows straight into the cell of staging image (all thumbnails must have same dimensions) */
+    if (decode_png(cell->path, &w, &h, &format, data, stride, 0) != 0)
+    {
+        TRACE(ERROR, _x("failed to load thumbnail '%s': %m"), cell->path);
+    }
+
+    /* ...publish decoded image to the rendering thread */
+    __atomic_sub_fetch(&menu->pending, 1, __ATOMIC_RELEASE);
+}
+
 /*******************************************************************************
  * Entry points
  ******************************************************************************/
@@ -852,9 +930,8 @@ carousel_t * carousel_create(carousel_cfg_t *cfg, void *cdata)
 {
     carousel_t     *menu;
     int             n, m;
-    int             w, h, format;
+    int             w, h;
     float           x0, y0, x1, y1;
-    void           *data;
     GLuint          tex;
     int             i, j;
 
@@ -868,10 +945,7 @@ carousel_t * carousel_create(carousel_cfg_t *cfg, void *cdata)
     menu->cfg = cfg, menu->cdata = cdata;
 
     /* ...set menu parameters */
-    n = cfg->size, m = cfg->size_y, w = cfg->width, h = cfg->height, format = GST_VIDEO_FORMAT_ARGB;
-
-    /* ...force library to allocate buffer by its own */
-    data = NULL;
+    n = cfg->size, m = cfg->size_y, w = cfg->width, h = cfg->height;
 
     /* ...generate a texture (we are running from EGL context) */
     if (!CHK_GL(glGenTextures(1, &tex)))
@@ -896,38 +970,53 @@ carousel_t * carousel_create(carousel_cfg_t *cfg, void *cdata)
         goto error_tex;
     }
 
-    /* ...load thumbnails */
-    for (i = 0, data = NULL; i < m; i++)
+    /* ...fill staging image with a placeholder until thumbnails are decoded */
+    if ((menu->staging = malloc(n * w * m * h * 4)) == NULL || (menu->cell = calloc(n * m, sizeof(*menu->cell))) == NULL)
+    {
+        errno = ENOMEM;
+        goto error_tex;
+    }
+
+    for (i = 0; i < n * w * m * h; i++)
+    {
+        ((u32 *)menu->staging)[i] = CAROUSEL_PLACEHOLDER;
+    }
+
+    for (i = 0; i < m; i++)
     {
         for (j = 0; j < n; j++)
         {
-            const char  *path;
+            carousel_cell_t    *cell = &menu->cell[i * n + j];
+            const char         *path;
         
-            /* ...get name of the thumbnail */
-            if ((path = cfg->thumbnail(cdata, i, j)) == NULL)
+            /* ...get name of the thumbnail (accessor may return a transient string) */
+            if ((path = cfg->thumbnail(cdata, i, j)) == NULL || (cell->path = strdup(path)) == NULL)
             {
                 TRACE(ERROR, _x("failed to get a thumbnail-%d name: %m"), i);
                 goto error_tex;
             }
-        
-            /* ...load PNG (all thumbnails must have same dimensions) */
-            if (create_png(path, &w, &h, &format, &data) != 0)
-            {
-                TRACE(ERROR, _x("failed to load thumbnail '%s': %m"), path);
-                goto error_tex;
-            }
 
-            /* ...upload image to the texture */
-            if (!CHK_GL(glTexSubImage2D(GL_TEXTURE_2D, 0, j * w, i * h, w, h, GL_RGBA, GL_UNSIGNED_BYTE, data)))
-            {
-                errno = ENOMEM;
-                goto error_tex;
-            }
+            cell->menu = menu, cell->i = i, cell->j = j;
         }
     }
 
-    /* ...release data after all */
-    free(data), data = NULL;
+    /* ...show placeholders right away */
+    if (!CHK_GL(glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, n * w, m * h, GL_RGBA, GL_UNSIGNED_BYTE, menu->staging)))
+    {
+        errno = ENOMEM;
+        goto error_tex;
+    }
+
+    /* ...decode thumbnails in parallel; atlas is updated from rendering path */
+    menu->pending = n * m;
+
+    for (i = 0; i < n * m; i++)
+    {
+        if (pool_submit(POOL_PRIO_BACKGROUND, carousel_decode_task, &menu->cell[i]) < 0)
+        {
+            carousel_decode_task(&menu->cell[i]);
+        }
+    }
 
     /* ...release binding */
     glBindTexture(GL_TEXTURE_2D, 0);
@@ -958,8 +1047,13 @@ error_shader:
 #endif
 
 error_tex:
-    /* ...free image data buffer if needed */
-    (data ? free(data) : 0);
+    /* ...release thumbnails names */
+    for (i = 0; menu->cell && i < n * m; i++)
+    {
+        free(menu->cell[i].path);
+    }
+
+    free(menu->cell), free(menu->staging);
 
     /* ...destroy texture */
     glDeleteTextures(1, &tex);
@@ -37,11 +37,16 @@
 //#include "utest-app.h"
 #include "utest-vsink.h"
 #include "utest-imr.h"
+#include "utest-stamp.h"
+#include "utest-recorder.h"
+#include "utest-pool.h"
 #include "utest-mesh.h"
 #include "utest-compositor.h"
 #include "utest-png.h"
+#include "utest-car-atlas.h"
 #include "utest-math.h"
 #include <linux/videodev2.h>
+#include <unistd.h>
 
 /*******************************************************************************
  * To-be-removed
@@ -97,10 +102,84 @@ TRACE_TAG(DEBUG, 1);
 /* ...size of compositor buffers pool */
 #define VSP_POOL_SIZE                   2
 
+/* ...number of precompiled views kept in a cache */
+#define SV_VIEW_CACHE_SIZE              8
+
+/* ...number of decoded car sprites kept in memory */
+#define SV_CAR_CACHE_SIZE               4
+
+/* ...number of views whose alpha-planes are kept (two W*H planes per view) */
+#define SV_ALPHA_CACHE_SIZE             4
+
+/* ...number of distinct views predicted ahead of the current one */
+#define SV_VIEW_PREDICT                 2
+
+/* ...prediction horizon (input events or animation ticks) */
+#define SV_VIEW_HORIZON                 32
+
+/* ...maximal view quantization coarsening level */
+#define SV_VIEW_LOD_MAX                 2
+
 /*******************************************************************************
  * Local types definitions
  ******************************************************************************/
 
+/* ...precompiled view configuration */
+typedef struct sv_view
+{
+    /* ...owning engine */
+    struct imr_sview   *sv;
+
+    /* ...quantized view position and (not quantized) Y-axis rotation */
+    int                 step[3];
+    __scalar            ry;
+
+    /* ...camera and alpha-plane engines configurations */
+    imr_cfg_t          *cfg[IMR_NUMBER];
+
+    /* ...entry state and last access tick */
+    int                 state;
+    u32                 tick;
+
+}   sv_view_t;
+
+/* ...view cache entry states */
+#define SV_VIEW_EMPTY                   0
+#define SV_VIEW_QUEUED                  1
+#define SV_VIEW_BUSY                    2
+#define SV_VIEW_READY                   3
+
+/* ...alpha-planes of a view (do not depend on cameras content) */
+typedef struct sv_alpha
+{
+    /* ...owning engine */
+    struct imr_sview   *sv;
+
+    /* ...quantized view position and (not quantized) Y-axis rotation */
+    int                 step[3];
+    __scalar            ry;
+
+    /* ...planes copies (two sets hosting opposite cameras) */
+    vsp_mem_t          *plane[2];
+
+    /* ...compositor buffers referring to the planes (one per camera) */
+    GstBuffer          *buffer[CAMERAS_NUMBER];
+
+    /* ...IMR output buffers being copied */
+    GstBuffer          *src[CAMERAS_NUMBER];
+
+    /* ...entry state and last access tick */
+    int                 state;
+    u32                 tick;
+
+}   sv_alpha_t;
+
+/* ...alpha-planes cache entry states */
+#define SV_ALPHA_EMPTY                  0
+#define SV_ALPHA_RESERVED               1
+#define SV_ALPHA_COPY                   2
+#define SV_ALPHA_READY                  3
+
 typedef struct imr_sview
 {
     /* ...application callback */
@@ -145,6 +224,9 @@ typedef struct imr_sview
     /* ...last update sequence number */
     u32                 last_update;
 
+    /* ...view settling statistics: burst start time (us), started and superseded updates */
+    u32                 settle_t0, settle_updates, settle_coalesced;
+
     /* ...IMR output buffers (inputs to the compositor) */
     vsp_mem_t          *camera_plane[2][VSP_POOL_SIZE];
 
@@ -163,6 +245,13 @@ typedef struct imr_sview
     /* ...active alpha-plane output buffers */
     GstBuffer          *alpha_active[4];
 
+    /* ...alpha-planes cache and entry waiting for planes of current update */
+    sv_alpha_t          alpha[SV_ALPHA_CACHE_SIZE];
+    sv_alpha_t         *alpha_store;
+
+    /* ...alpha-planes cache statistics: access tick, hits and misses */
+    u32                 alpha_tick, alpha_hits, alpha_misses;
+
     /* ...car image buffers */
     GstBuffer          *car_buffer[2];
 
@@ -172,14 +261,8 @@ typedef struct imr_sview
     /* ...image to use for car rendering */
     char               *car_image;
 
-    /* ...mesh configuration update thread handle */
-    pthread_t           mesh_thread;
-
-    /* ...car model update thread handle */
-    pthread_t           car_thread;
-
-    /* ...conditional variable for update sequence */
-    pthread_cond_t      update;
+    /* ...packed car sprites (NULL - separate PNG files are used) */
+    car_atlas_t        *car_atlas;
 
     /* ...output buffers pool */
     GstBuffer          *buffer[VSP_POOL_SIZE];
@@ -214,6 +297,25 @@ typedef struct imr_sview
     /* ...current steps set for a model view */
     int                 step[3];
 
+    /* ...input velocity (smoothed accumulators change per input event) */
+    __vec3              vel;
+
+    /* ...precompiled views cache */
+    sv_view_t           view[SV_VIEW_CACHE_SIZE];
+
+    /* ...views cache access lock and prefetch completion condition */
+    pthread_mutex_t     view_lock;
+    pthread_cond_t      view_wait;
+
+    /* ...mesh translation lock (translated meshes are kept in shared buffers) */
+    pthread_mutex_t     mesh_lock;
+
+    /* ...views cache statistics: access tick, hits, misses and evictions */
+    u32                 view_tick, view_hits, view_misses, view_evicted;
+
+    /* ...view quantization coarsening (every 2^lod-th grid position is used) */
+    int                 lod;
+
     /* ...number of milliseconds since last update */
     u32                 spnav_delta;
 
@@ -256,9 +358,18 @@ typedef struct imr_sview
 /* ...car model update condition  */
 #define APP_FLAG_CAR_UPDATE             (1 << 14)
 
+/* ...view change requested while update sequence is in progress */
+#define APP_FLAG_UPDATE_PENDING         (1 << 15)
+
+/* ...view is moving towards the latest requested target */
+#define APP_FLAG_SETTLING               (1 << 17)
+
 /* ...buffer clearing mask */
 #define APP_FLAG_CLEAR_BUFFER           (1 << 16)
 
+/* ...car model rendering is disabled (transparent plane is composed) */
+#define APP_FLAG_CAR_DISABLE            (1 << 18)
+
 /*******************************************************************************
  * Mesh processing
  ******************************************************************************/
@@ -274,6 +385,12 @@ static __mat4x4 __v_matrix = {
     __MATH_FLOAT(0),    __MATH_FLOAT(0),    __MATH_FLOAT(-1),   __MATH_FLOAT(1),
 };
 
+/* ...process mesh rotation (called with a lock held) */
+static int __sv_map_update(imr_sview_t *sv);
+
+/* ...save alpha-planes of an applied update (called with a lock held) */
+static int __sv_alpha_store(imr_sview_t *sv, GstBuffer **buf);
+
 /*******************************************************************************
  * Compositor interface
  ******************************************************************************/
@@ -322,6 +439,7 @@ static int __vsp_compose(imr_sview_t *sv)
 
     /* ...submit a job to compositor */
     CHK_ERR(vsp_job_submit(sv->vsp, mem, mem[VSP_OUTPUT]) == 0, -(errno = EBADFD));
+    recorder_event(REC_VSP_SUBMIT, 0, gst_buffer_get_imr_meta(buf[VSP_OUTPUT])->index);
 
     TRACE(DEBUG, _b("job submitted..."));
 
@@ -355,13 +473,14 @@ static void vsp_callback(void *data, int result)
     imr_sview_t    *sv = data;
     GstBuffer     **buf = sv->vsp_buffers;
     u32             sequence = sv->sequence_out;
-    int             i;
+    int             i, k;
 
     /* ...lock application state */
     pthread_mutex_lock(&sv->lock);
 
     /* ...update output buffers sequence counter */
     sv->sequence_out = sequence + 1;
+    recorder_event(REC_VSP_DONE, 0, sequence);
 
     /* ...test if we need to update current alpha- and car-model buffers */
     if ((sv->flags & APP_FLAG_UPDATE) && (sequence == sv->last_update))
@@ -372,6 +491,9 @@ static void vsp_callback(void *data, int result)
             sv->alpha_active[i] = gst_buffer_ref(buf[VSP_ALPHA_0 + i]);
         }
 
+        /* ...keep a copy of alpha-planes produced for a new view */
+        (sv->alpha_store ? __sv_alpha_store(sv, buf) : 0);
+
         /* ...latch active car buffer */
         sv->car_active = gst_buffer_ref(buf[VSP_CAR]);
 
@@ -396,11 +518,44 @@ static void vsp_callback(void *data, int result)
 
         /* ...clear update sequence flag */
         sv->flags &= ~APP_FLAG_UPDATE;
+
+        /* ...start update towards the latest target requested meanwhile */
+        if (sv->flags & APP_FLAG_UPDATE_PENDING)
+        {
+            sv->flags &= ~APP_FLAG_UPDATE_PENDING;
+
+            TRACE(DEBUG, _b("view update applied after %u us; proceed to pending target"), (u32)(__get_time_usec() - sv->settle_t0));
+
+            __sv_map_update(sv);
+        }
+
+        /* ...report time-to-settle if no further update has been started */
+        if ((sv->flags & (APP_FLAG_UPDATE | APP_FLAG_SETTLING)) == APP_FLAG_SETTLING)
+        {
+            sv->flags &= ~APP_FLAG_SETTLING;
+
+            TRACE(INFO, _b("view settled in %u us (updates: %u, coalesced requests: %u)"),
+                  (u32)(__get_time_usec() - sv->settle_t0), sv->settle_updates, sv->settle_coalesced);
+        }
     }
 
     /* ...release the lock before passing control to the application */
     pthread_mutex_unlock(&sv->lock);
 
+    /* ...mark composition is complete for associated camera frames */
+    for (i = 0, k = VSP_NUMBER; i < CAMERAS_NUMBER; i++)
+    {
+        stamp_buffer(buf[VSP_NUMBER + i], STAMP_VSP);
+
+        /* ...pick the oldest frame as the one the composition latency is accounted to */
+        (GST_BUFFER_PTS(buf[VSP_NUMBER + i]) < GST_BUFFER_PTS(buf[k]) ? k = VSP_NUMBER + i : 0);
+    }
+
+    /* ...let composed image inherit identity and timing of the oldest source frame */
+    GST_BUFFER_OFFSET(buf[VSP_OUTPUT]) = GST_BUFFER_OFFSET(buf[k]);
+    GST_BUFFER_DTS(buf[VSP_OUTPUT]) = GST_BUFFER_PTS(buf[VSP_OUTPUT]) = GST_BUFFER_PTS(buf[k]);
+    stamp_copy(buf[VSP_OUTPUT], buf[k]);
+
     /* ...should I pass auxiliary buffers as well? ---everything at once? - tbd */
     sv->cb->ready(sv->cdata, buf);
 
@@ -429,30 +584,114 @@ static void vsp_callback(void *data, int result)
 
 extern __scalar     __sphere_gain;
 
-/* ...setup IMR engines for a processing (called with an application lock held) */
-static int __sv_map_setup(imr_sview_t *sv)
+/* ...release engines configurations set */
+static void __sv_view_release(imr_cfg_t **cfg)
+{
+    int     i;
+
+    for (i = 0; i < IMR_NUMBER; i++)
+    {
+        (cfg[i] ? imr_cfg_destroy(cfg[i]), cfg[i] = NULL : 0);
+    }
+}
+
+/* ...create IMR engines configurations for a given PVM matrix */
+static int __sv_view_compile(imr_sview_t *sv, const __mat4x4 pvm, imr_cfg_t **cfg)
 {
     __vec2     *uv[CAMERAS_NUMBER], *a[CAMERAS_NUMBER];
     __vec3     *xy[CAMERAS_NUMBER];
     int         n[CAMERAS_NUMBER];
-    int         i;
+    int         i, r;
 
-    /* ...calculate projection transformations of the points (single-threaded?) */
-    CHK_API(mesh_translate(sv->mesh, uv, a, xy, n, sv->pvm_matrix, __sphere_gain));
+    memset(cfg, 0, IMR_NUMBER * sizeof(*cfg));
+
+    /* ...translated meshes are placed into shared buffers; serialize compilations */
+    pthread_mutex_lock(&sv->mesh_lock);
+
+    /* ...calculate projection transformations of the points */
+    if ((r = mesh_translate(sv->mesh, uv, a, xy, n, pvm, __sphere_gain)) != 0)
+    {
+        goto out;
+    }
 
     /* ...setup individual engines */
     for (i = 0; i < CAMERAS_NUMBER; i++)
     {
-        TRACE(INFO, _b("engine-%d mesh setup: n = %d"), i, n[i]);
+        TRACE(DEBUG, _b("engine-%d mesh setup: n = %d"), i, n[i]);
 
         /* ...create new configuration - tbd - not that simple */
-        CHK_ERR(sv->imr_cfg[i + IMR_CAMERA_0] = imr_cfg_create(sv->imr, i + IMR_CAMERA_0, uv[i][0], xy[i][0], n[i]), -errno);
-        CHK_ERR(sv->imr_cfg[i + IMR_ALPHA_0] = imr_cfg_create(sv->imr, i + IMR_ALPHA_0, a[i][0], xy[i][0], n[i]), -errno);
+        if ((cfg[i + IMR_CAMERA_0] = imr_cfg_create(sv->imr, i + IMR_CAMERA_0, uv[i][0], xy[i][0], n[i])) == NULL ||
+            (cfg[i + IMR_ALPHA_0] = imr_cfg_create(sv->imr, i + IMR_ALPHA_0, a[i][0], xy[i][0], n[i])) == NULL)
+        {
+            r = -errno;
+            break;
+        }
+    }
+
+out:
+    pthread_mutex_unlock(&sv->mesh_lock);
+
+    /* ...drop partially created set */
+    (r != 0 ? __sv_view_release(cfg) : 0);
+
+    return CHK_API(r);
+}
+
+/* ...find view in a cache (called with a cache lock held) */
+static sv_view_t * __sv_view_lookup(imr_sview_t *sv, const int *step, __scalar ry)
+{
+    sv_view_t  *v;
 
-        TRACE(INFO, _b("engine-%d configured"), i);
+    for (v = sv->view; v < sv->view + SV_VIEW_CACHE_SIZE; v++)
+    {
+        if (v->state != SV_VIEW_EMPTY && !memcmp(v->step, step, sizeof(v->step)) && v->ry == ry)
+        {
+            return v;
+        }
     }
 
-    return 0;
+    return NULL;
+}
+
+/* ...setup IMR engines for a processing (called with an application lock held) */
+static int __sv_map_setup(imr_sview_t *sv)
+{
+    sv_view_t  *v;
+    u32         total;
+
+    pthread_mutex_lock(&sv->view_lock);
+
+    /* ...wait for a prefetch of the same view if it is being compiled already */
+    while ((v = __sv_view_lookup(sv, sv->step, sv->rot_acc[1])) != NULL && v->state == SV_VIEW_BUSY)
+    {
+        pthread_cond_wait(&sv->view_wait, &sv->view_lock);
+    }
+
+    if (v && v->state == SV_VIEW_READY)
+    {
+        /* ...take precompiled configuration (move ownership) */
+        memcpy(sv->imr_cfg, v->cfg, sizeof(sv->imr_cfg));
+        memset(v->cfg, 0, sizeof(v->cfg));
+        v->state = SV_VIEW_EMPTY;
+        sv->view_hits++;
+    }
+    else
+    {
+        /* ...prefetch task has not started yet; let it discard the entry */
+        (v ? v->state = SV_VIEW_EMPTY, v = NULL : 0);
+        sv->view_misses++;
+    }
+
+    total = sv->view_hits + sv->view_misses;
+
+    pthread_mutex_unlock(&sv->view_lock);
+
+    TRACE(INFO, _b("view %d/%d/%d: %s; cache hit-rate: %u%% (%u/%u), evicted: %u"),
+          sv->step[0], sv->step[1], sv->step[2], (v ? "precompiled" : "compile"),
+          sv->view_hits * 100 / total, sv->view_hits, total, sv->view_evicted);
+
+    /* ...calculate configuration in-place if view has not been predicted */
+    return (v ? 0 : __sv_view_compile(sv, sv->pvm_matrix, sv->imr_cfg));
 }
 
 /* ...submit new input job to IMR engines (function called with a lock held) */
@@ -515,10 +754,160 @@ static int __sv_job_submit(imr_sview_t *sv)
     return 0;
 }
 
+/* ...check if compositor still refers to cached planes */
+static inline int __sv_alpha_busy(sv_alpha_t *a)
+{
+    int     i;
+
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+    {
+        if (GST_MINI_OBJECT_REFCOUNT(a->buffer[i]) > 1)   return 1;
+    }
+
+    return 0;
+}
+
+/* ...find alpha-planes of current view; reserve an entry on miss (called with a lock held) */
+static sv_alpha_t * __sv_alpha_lookup(imr_sview_t *sv)
+{
+    sv_alpha_t     *a, *e = NULL;
+    u32             tick = ++sv->alpha_tick;
+
+    /* ...previous update did not deliver the planes; drop reservation */
+    (sv->alpha_store ? sv->alpha_store->state = SV_ALPHA_EMPTY, sv->alpha_store = NULL : 0);
+
+    for (a = sv->alpha; a < sv->alpha + SV_ALPHA_CACHE_SIZE; a++)
+    {
+        if (a->state == SV_ALPHA_EMPTY || memcmp(a->step, sv->step, sizeof(a->step)) || a->ry != sv->rot_acc[1])
+        {
+            continue;
+        }
+
+        /* ...planes of the view are being copied already; do not cache it twice */
+        if (a->state != SV_ALPHA_READY)
+        {
+            sv->alpha_misses++;
+            return NULL;
+        }
+
+        a->tick = tick, sv->alpha_hits++;
+        return a;
+    }
+
+    sv->alpha_misses++;
+
+    /* ...use empty entry or evict least recently used one that is not referenced */
+    for (a = sv->alpha; a < sv->alpha + SV_ALPHA_CACHE_SIZE; a++)
+    {
+        if (a->state == SV_ALPHA_EMPTY)
+        {
+            e = a;
+            break;
+        }
+
+        (a->state == SV_ALPHA_READY && !__sv_alpha_busy(a) && (!e || (s32)(a->tick - e->tick) < 0) ? e = a : 0);
+    }
+
+    /* ...planes are saved when the update completes */
+    if (e)
+    {
+        memcpy(e->step, sv->step, sizeof(e->step));
+        e->ry = sv->rot_acc[1], e->tick = tick;
+        e->state = SV_ALPHA_RESERVED;
+        sv->alpha_store = e;
+    }
+
+    return NULL;
+}
+
+/* ...alpha-planes copy task (runs on idle workers) */
+static void sv_alpha_task(void *arg)
+{
+    sv_alpha_t     *a = arg;
+    imr_sview_t    *sv = a->sv;
+    int             k, i;
+
+    /* ...opposite cameras share a plane; IMR output buffers are referenced until copied */
+    for (k = 0; k < 2; k++)
+    {
+        vsp_mem_t  *mem = gst_buffer_get_imr_meta(a->src[k * 2])->priv;
+
+        memcpy(vsp_mem_ptr(a->plane[k]), vsp_mem_ptr(mem), vsp_mem_size(a->plane[k]));
+    }
+
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+    {
+        gst_buffer_unref(a->src[i]), a->src[i] = NULL;
+    }
+
+    pthread_mutex_lock(&sv->lock);
+    a->state = SV_ALPHA_READY;
+    pthread_mutex_unlock(&sv->lock);
+
+    TRACE(DEBUG, _b("view %d/%d/%d: alpha-planes cached"), a->step[0], a->step[1], a->step[2]);
+}
+
+/* ...save alpha-planes of an applied update (called with a lock held) */
+static int __sv_alpha_store(imr_sview_t *sv, GstBuffer **buf)
+{
+    sv_alpha_t     *a = sv->alpha_store;
+    int             i;
+
+    sv->alpha_store = NULL;
+
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+    {
+        a->src[i] = gst_buffer_ref(buf[VSP_ALPHA_0 + i]);
+    }
+
+    a->state = SV_ALPHA_COPY;
+
+    /* ...copying is not urgent; alpha engines are not used until next view update */
+    if (pool_submit(POOL_PRIO_BACKGROUND, sv_alpha_task, a) != 0)
+    {
+        TRACE(ERROR, _x("alpha-planes copy submission failed: %m"));
+
+        for (i = 0; i < CAMERAS_NUMBER; i++)
+        {
+            gst_buffer_unref(a->src[i]), a->src[i] = NULL;
+        }
+
+        a->state = SV_ALPHA_EMPTY;
+        return -errno;
+    }
+
+    return 0;
+}
+
 /* ...trigger update of alpha-plane (called with a lock held) */
 static inline int __sv_alpha_update(imr_sview_t *sv)
 {
-    int     i;
+    sv_alpha_t *a = __sv_alpha_lookup(sv);
+    int         i;
+
+    TRACE(INFO, _b("view %d/%d/%d: alpha-planes %s; hits: %u, misses: %u"),
+          sv->step[0], sv->step[1], sv->step[2], (a ? "cached" : "rendered"), sv->alpha_hits, sv->alpha_misses);
+
+    if (a)
+    {
+        pthread_mutex_lock(&sv->vsp_lock);
+
+        for (i = 0; i < CAMERAS_NUMBER; i++)
+        {
+            /* ...make sure there is no active buffer */
+            BUG(sv->alpha_active[i], _x("alpha-%d: invalid state: %p"), i, sv->alpha_active[i]);
+
+            /* ...alpha engine stays idle; drop its configuration */
+            (sv->imr_cfg[IMR_ALPHA_0 + i] ? imr_cfg_destroy(sv->imr_cfg[IMR_ALPHA_0 + i]), sv->imr_cfg[IMR_ALPHA_0 + i] = NULL : 0);
+
+            /* ...pass cached planes to compositor as if IMR produced them */
+            __vsp_submit_buffer(sv, VSP_ALPHA_0 + i, a->buffer[i]);
+        }
+
+        pthread_mutex_unlock(&sv->vsp_lock);
+
+        return 0;
+    }
 
     for (i = 0; i < CAMERAS_NUMBER; i++)
     {
@@ -555,44 +944,107 @@ static void __sv_matrix_set(imr_sview_t *sv, __scalar rx, __scalar ry, __scalar
     sv->scl_acc = s;
 }
 
+/* ...clamp rotation/scaling accumulators */
+static inline void __sv_matrix_clamp(__vec3 rot, __scalar *scl)
+{
+    (rot[0] > 0 ? rot[0] = 0 : (rot[0] < -80 ? rot[0] = -80 : 0));
+    ((rot[1] = fmodf(rot[1], 360)) < 0 ? rot[1] += 360 : 0);
+    ((rot[2] = fmodf(rot[2], 360)) < 0 ? rot[2] += 360 : 0);
+    *scl = (*scl < 0.75 ? 0.75 : (*scl > 1.5 ? 1.5 : *scl));
+}
+
 /* ...rotate/scale model matrix (called with a lock held) */
 static void __sv_matrix_update(imr_sview_t *sv, int rx, int ry, int rz, int ts)
 {
     static const float  speed = 1.0 / 360;
+    __vec3              d = { -speed * rx, speed * rz, -4 * speed * speed * ts };
+    int                 i;
 
     /* ...update accumulators */
-    sv->rot_acc[0] -= speed * rx;
+    sv->rot_acc[0] += d[0];
     sv->rot_acc[1] += 0 * speed * ry;
-    sv->rot_acc[2] += speed * rz;
-    sv->scl_acc -= 4 * speed * speed * ts;
+    sv->rot_acc[2] += d[1];
+    sv->scl_acc += d[2];
 
     /* ...clamp components */
-    (sv->rot_acc[0] > 0 ? sv->rot_acc[0] = 0 : (sv->rot_acc[0] < -80 ? sv->rot_acc[0] = -80 : 0));
-    ((sv->rot_acc[1] = fmodf(sv->rot_acc[1], 360)) < 0 ? sv->rot_acc[1] += 360 : 0);
-    ((sv->rot_acc[2] = fmodf(sv->rot_acc[2], 360)) < 0 ? sv->rot_acc[2] += 360 : 0);
-    sv->scl_acc = (sv->scl_acc < 0.75 ? 0.75 : (sv->scl_acc > 1.5 ? 1.5 : sv->scl_acc));
+    __sv_matrix_clamp(sv->rot_acc, &sv->scl_acc);
+
+    /* ...track input velocity (used for a view prediction) */
+    for (i = 0; i < 3; i++)
+    {
+        sv->vel[i] = (sv->vel[i] + d[i]) / 2;
+    }
 }
 
-static inline int __sv_map_changed(imr_sview_t *sv)
+/* ...move accumulators one step towards default view (animated transition) */
+static void __sv_matrix_animate(__vec3 rot, __scalar *scl)
+{
+    (rot[0] > 180 ? rot[0] -= 360 : 0);
+    (rot[1] > 180 ? rot[1] -= 360 : 0);
+    (rot[2] > 180 ? rot[2] -= 360 : 0);
+
+    rot[0] -= (rot[0] - __MATH_ZERO) / 2;
+    rot[1] -= (rot[1] - __MATH_ZERO) / 2;
+    rot[2] -= (rot[2] - __MATH_ZERO) / 2;
+
+    (rot[0] > 0 ? rot[0] -= 360 : 0);
+    (rot[1] < 0 ? rot[1] += 360 : 0);
+    (rot[2] < 0 ? rot[2] += 360 : 0);
+
+    *scl -= (*scl - __MATH_ONE) / 2;
+}
+
+/* ...quantize view position (coarsened grid keeps every 2^lod-th position) */
+static void __sv_view_step(const __vec3 rot, __scalar scl, int lod, int *step)
 {
-    int                 step[3];
-    char                buffer[256];
     extern int          __steps[3];
-    extern char        *__model;
+    int                 n[3], k;
+
+    /* ...number of positions of the coarsened grid along each axis */
+    for (k = 0; k < 3; k++)
+    {
+        ((n[k] = __steps[k] >> lod) < 1 ? n[k] = 1 : 0);
+    }
 
     /* ...check out if we crossed the boundaries */
-    step[0] = (int)floor(sv->rot_acc[0] / -80 * __steps[0] + 0.5);
-    step[1] = (int)floor(sv->rot_acc[2] / 360 * __steps[1] + 0.5);
-    step[2] = (int)floor((sv->scl_acc - 0.75) * __steps[2] / 0.75 + 0.5);
+    step[0] = (int)floor(rot[0] / -80 * n[0] + 0.5);
+    step[1] = (int)floor(rot[2] / 360 * n[1] + 0.5);
+    step[2] = (int)floor((scl - 0.75) * n[2] / 0.75 + 0.5);
 
-    BUG(step[0] < 0, _x("invalid step[0]: %d (%d)"), step[0], __steps[0]);
-    BUG(step[1] < 0, _x("invalid step[1]: %d (%d)"), step[1], __steps[1]);
-    BUG(step[2] < 0, _x("invalid step[2]: %d (%d)"), step[2], __steps[2]);
+    BUG(step[0] < 0, _x("invalid step[0]: %d (%d)"), step[0], n[0]);
+    BUG(step[1] < 0, _x("invalid step[1]: %d (%d)"), step[1], n[1]);
+    BUG(step[2] < 0, _x("invalid step[2]: %d (%d)"), step[2], n[2]);
 
     /* ...saturate steps */
-    (step[0] >= __steps[0] ? step[0] = __steps[0] - 1 : 0);
-    (step[1] >= __steps[1] ? step[1] -= __steps[1] : 0);
-    (step[2] >= __steps[2] ? step[2] = __steps[2] - 1 : 0);
+    (step[0] >= n[0] ? step[0] = n[0] - 1 : 0);
+    (step[1] >= n[1] ? step[1] -= n[1] : 0);
+    (step[2] >= n[2] ? step[2] = n[2] - 1 : 0);
+
+    /* ...map coarsened position back to the full grid */
+    for (k = 0; k < 3; k++)
+    {
+        step[k] *= __steps[k] / n[k];
+    }
+}
+
+/* ...align rotation/scaling accumulators with a quantized view position */
+static void __sv_view_snap(const int *step, __vec3 rot, __scalar *scl)
+{
+    extern int          __steps[3];
+
+    rot[0] = -80.0 * step[0] / __steps[0];
+    rot[2] = 360.0 * step[1] / __steps[1];
+    *scl = 0.75 + 0.75 * step[2] / __steps[2];
+}
+
+static inline int __sv_map_changed(imr_sview_t *sv)
+{
+    int                 step[3];
+    char                buffer[256];
+    extern char        *__model;
+
+    /* ...check out if we crossed the boundaries */
+    __sv_view_step(sv->rot_acc, sv->scl_acc, sv->lod, step);
 
     TRACE(DEBUG, _b("angles: %.1f/%.1f/%.2f -> %d/%d/%d"), sv->rot_acc[0], sv->rot_acc[2], sv->scl_acc, step[0], step[1], step[2]);
 
@@ -603,9 +1055,7 @@ static inline int __sv_map_changed(imr_sview_t *sv)
     memcpy(sv->step, step, sizeof(sv->step));
 
     /* ...update rotation vectors */
-    sv->rot_acc[0] = -80.0 * step[0] / __steps[0];
-    sv->rot_acc[2] = 360.0 * step[1] / __steps[1];
-    sv->scl_acc = 0.75 + 0.75 * step[2] / __steps[2];
+    __sv_view_snap(step, sv->rot_acc, &sv->scl_acc);
 
     /* ...drop previous image */
     (sv->car_image ? free(sv->car_image) : 0);
@@ -621,74 +1071,237 @@ static inline int __sv_map_changed(imr_sview_t *sv)
     return 1;
 }
 
-/* ...mesh update thread */
-static void * mesh_update_thread(void *arg)
+/* ...car image update task */
+static void sv_car_task(void *arg);
+
+/* ...mesh update task (input path is disabled until it completes) */
+static void sv_map_task(void *arg)
 {
     imr_sview_t     *sv = arg;
 
     /* ...protect intenal app data */
     pthread_mutex_lock(&sv->lock);
 
-    /* ...wait for an update event */
-    while (1)
+    /* ...update IMR mappings */
+    if (__sv_map_setup(sv) != 0)
     {
-        /* ...wait for a mesh update flag */
-        while ((sv->flags & (APP_FLAG_MAP_UPDATE | APP_FLAG_EOS)) == 0)
-        {
-            pthread_cond_wait(&sv->update, &sv->lock);
-        }
+        TRACE(ERROR, _x("maps update failed: %m"));
+        goto out;
+    }
 
-        /* ...process termination request */
-        if (sv->flags & APP_FLAG_EOS)
-        {
-            TRACE(INIT, _b("termination request received"));
-            goto out;
-        }
+    /* ...clear mesh update command condition */
+    sv->flags &= ~APP_FLAG_MAP_UPDATE;
+
+    /* ...start alpha-plane processing */
+    __sv_alpha_update(sv);
 
-        /* ...update IMR mappings */
-        if (__sv_map_setup(sv) != 0)
+    /* ...re-enable input */
+    if ((sv->input_ready &= ~(1 << CAMERAS_NUMBER)) == 0)
+    {
+        /* ...force job submission */
+        if (__sv_job_submit(sv) != 0)
         {
-            TRACE(ERROR, _x("maps update failed: %m"));
-            goto out;
+            TRACE(ERROR, _b("job submission failed: %m"));
         }
+    }
 
-        /* ...clear mesh update command condition */
-        sv->flags &= ~APP_FLAG_MAP_UPDATE;
+out:
+    /* ...release application lock */
+    pthread_mutex_unlock(&sv->lock);
+}
+
+/*******************************************************************************
+ * View prediction
+ ******************************************************************************/
 
-        /* ...start alpha-plane processing */
-        __sv_alpha_update(sv);
+/* ...calculate PVM matrix of a quantized view (same way as the update sequence does) */
+static void __sv_view_matrix(imr_sview_t *sv, const int *step, __scalar ry, __mat4x4 pvm)
+{
+    __mat4x4    model;
+    __vec3      rot;
+    __scalar    scl;
+
+    __sv_view_snap(step, rot, &scl);
+    rot[1] = ry, rot[2] = 180.0 - rot[2];
+
+    __mat4x4_rotation(model, rot, scl);
+    __mat4x4_mul(sv->pv_matrix, model, pvm);
+}
 
-        /* ...re-enable input */
-        if ((sv->input_ready &= ~(1 << CAMERAS_NUMBER)) == 0)
+/* ...view prefetch task (runs on idle workers) */
+static void sv_view_task(void *arg)
+{
+    sv_view_t      *v = arg;
+    imr_sview_t    *sv = v->sv;
+    imr_cfg_t      *cfg[IMR_NUMBER];
+    __mat4x4        pvm;
+    int             r;
+
+    pthread_mutex_lock(&sv->view_lock);
+
+    /* ...entry might have been claimed by an update sequence meanwhile */
+    if (v->state != SV_VIEW_QUEUED)     goto out;
+
+    /* ...mark compilation is in progress (entry cannot be evicted) */
+    v->state = SV_VIEW_BUSY;
+    __sv_view_matrix(sv, v->step, v->ry, pvm);
+
+    pthread_mutex_unlock(&sv->view_lock);
+
+    r = __sv_view_compile(sv, pvm, cfg);
+
+    pthread_mutex_lock(&sv->view_lock);
+
+    if (r == 0)
+    {
+        memcpy(v->cfg, cfg, sizeof(v->cfg));
+        v->state = SV_VIEW_READY;
+
+        TRACE(DEBUG, _b("view %d/%d/%d precompiled"), v->step[0], v->step[1], v->step[2]);
+    }
+    else
+    {
+        v->state = SV_VIEW_EMPTY;
+
+        TRACE(ERROR, _x("view %d/%d/%d prefetch failed: %m"), v->step[0], v->step[1], v->step[2]);
+    }
+
+    /* ...wake up update sequence waiting for this view */
+    pthread_cond_broadcast(&sv->view_wait);
+
+out:
+    pthread_mutex_unlock(&sv->view_lock);
+}
+
+/* ...schedule view precompilation (called with a lock held) */
+static void __sv_view_prefetch(imr_sview_t *sv, const int *step, __scalar ry)
+{
+    sv_view_t  *v, *e = NULL;
+
+    pthread_mutex_lock(&sv->view_lock);
+
+    /* ...refresh access tick of a view that is cached already */
+    if ((v = __sv_view_lookup(sv, step, ry)) != NULL)
+    {
+        v->tick = sv->view_tick;
+        goto out;
+    }
+
+    /* ...use empty entry or evict least recently predicted precompiled view */
+    for (v = sv->view; v < sv->view + SV_VIEW_CACHE_SIZE; v++)
+    {
+        if (v->state == SV_VIEW_EMPTY)
         {
-            /* ...force job submission */
-            if (__sv_job_submit(sv) != 0)
-            {
-                TRACE(ERROR, _b("job submission failed: %m"));
-                goto out;
-            }
+            e = v;
+            break;
         }
+
+        (v->state == SV_VIEW_READY && (!e || (s32)(v->tick - e->tick) < 0) ? e = v : 0);
     }
 
+    /* ...all entries are being compiled */
+    if (!e)     goto out;
+
+    (e->state == SV_VIEW_READY ? __sv_view_release(e->cfg), sv->view_evicted++ : 0);
+
+    memcpy(e->step, step, sizeof(e->step));
+    e->ry = ry, e->sv = sv;
+    e->state = SV_VIEW_QUEUED, e->tick = sv->view_tick;
+
 out:
-    /* ...release application lock */
-    pthread_mutex_unlock(&sv->lock);
+    pthread_mutex_unlock(&sv->view_lock);
 
-    TRACE(INIT, _b("map update thread terminated"));
+    /* ...submit task outside of cache lock */
+    if (e && pool_submit(POOL_PRIO_BACKGROUND, sv_view_task, e) != 0)
+    {
+        TRACE(ERROR, _x("prefetch submission failed: %m"));
 
-    return NULL;
+        pthread_mutex_lock(&sv->view_lock);
+        e->state = SV_VIEW_EMPTY;
+        pthread_mutex_unlock(&sv->view_lock);
+    }
+}
+
+/* ...predict next quantized views and precompile them (called with a lock held) */
+static void __sv_view_predict(imr_sview_t *sv)
+{
+    int         animate = timer_source_is_active(sv->timer);
+    int         step[3], last[3], k, m;
+    __vec3      rot;
+    __scalar    scl;
+
+    /* ...precompilation in-place would only stall the caller */
+    if (pool_size() == 0)   return;
+
+    /* ...nothing to extrapolate if view is not moving */
+    if (!animate && fabs(sv->vel[0]) + fabs(sv->vel[1]) + fabs(sv->vel[2]) < 1e-4)     return;
+
+    memcpy(rot, sv->rot_acc, sizeof(rot)), scl = sv->scl_acc;
+    memcpy(last, sv->step, sizeof(last));
+
+    sv->view_tick++;
+
+    /* ...follow animation path or extrapolate input motion */
+    for (k = m = 0; k < SV_VIEW_HORIZON && m < SV_VIEW_PREDICT; k++)
+    {
+        if (animate)
+        {
+            __sv_matrix_animate(rot, &scl);
+        }
+        else
+        {
+            rot[0] += sv->vel[0], rot[2] += sv->vel[1], scl += sv->vel[2];
+            __sv_matrix_clamp(rot, &scl);
+        }
+
+        __sv_view_step(rot, scl, sv->lod, step);
+
+        if (!memcmp(step, last, sizeof(last)))  continue;
+
+        /* ...accumulators are aligned with a grid once the view is switched */
+        __sv_view_prefetch(sv, step, rot[1]);
+        __sv_view_snap(step, rot, &scl);
+        memcpy(last, step, sizeof(last)), m++;
+    }
 }
 
+/*******************************************************************************
+ * View update sequence
+ ******************************************************************************/
+
 /* ...process mesh rotation (called with a lock held) */
 static int __sv_map_update(imr_sview_t *sv)
 {
-    int     i;
+    int     i, changed;
 
-    /* ...ignore update request if one is started */
-    if (sv->flags & APP_FLAG_UPDATE)       return 0;
+    /* ...keep single update in flight; the latest target is picked up once it completes */
+    if (sv->flags & APP_FLAG_UPDATE)
+    {
+        (sv->flags & APP_FLAG_UPDATE_PENDING ? sv->settle_coalesced++ : 0);
+        sv->flags |= APP_FLAG_UPDATE_PENDING;
+
+        /* ...precompile pending target while current update completes */
+        __sv_view_predict(sv);
+        return 0;
+    }
 
     /* ...check if matrix has been actually adjusted */
-    if (!__sv_map_changed(sv))              return 0;
+    changed = __sv_map_changed(sv);
+
+    /* ...precompile views the user is likely to switch to next */
+    __sv_view_predict(sv);
+
+    if (!changed)                           return 0;
+
+    /* ...start time-to-settle measurement on first request of a burst */
+    if ((sv->flags & APP_FLAG_SETTLING) == 0)
+    {
+        sv->flags |= APP_FLAG_SETTLING;
+        sv->settle_t0 = __get_time_usec();
+        sv->settle_updates = sv->settle_coalesced = 0;
+    }
+
+    sv->settle_updates++;
 
     /* ...calculate M matrix */
     if (1)
@@ -735,8 +1348,9 @@ static int __sv_map_update(imr_sview_t *sv)
 
     TRACE(DEBUG, _b("trigger update sequence"));
 
-    /* ...kick update threads */
-    pthread_cond_broadcast(&sv->update);
+    /* ...schedule mappings update ahead of car image decoding */
+    CHK_API(pool_submit(POOL_PRIO_FRAME, sv_map_task, sv));
+    CHK_API(pool_submit(POOL_PRIO_BACKGROUND, sv_car_task, sv));
 
     return 0;
 }
@@ -744,9 +1358,6 @@ static int __sv_map_update(imr_sview_t *sv)
 /* ...initialize mesh update thread */
 static inline int sv_map_init(imr_sview_t *sv, int W, int H)
 {
-    pthread_attr_t  attr;
-    int             r;
-
     /* ...reset initial matrices */
     __sv_matrix_reset(sv);
 
@@ -756,16 +1367,6 @@ static inline int sv_map_init(imr_sview_t *sv, int W, int H)
     /* ...calculate PV matrix (which is constant for now) */
     __mat4x4_mul(__p_matrix, __v_matrix, sv->pv_matrix);
 
-    /* ...initialize thread attributes (joinable, 128KB stack) */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-    pthread_attr_setstacksize(&attr, 128 << 10);
-
-    /* ...create mesh update thread */
-    r = pthread_create(&sv->mesh_thread, &attr, mesh_update_thread, sv);
-    pthread_attr_destroy(&attr);
-    CHK_API(r);
-
     return 0;
 }
 
@@ -1017,6 +1618,32 @@ static inline int sv_alpha_setup(imr_sview_t *sv, int W, int H)
     /* ...allocate two sets of alpha-planes for each bundle */
     CHK_API(vsp_allocate_buffers(W, H, V4L2_PIX_FMT_GREY, &sv->alpha_plane[0][0], 2 * VSP_POOL_SIZE));
 
+    /* ...allocate alpha-planes cache */
+    for (j = 0; j < SV_ALPHA_CACHE_SIZE; j++)
+    {
+        sv_alpha_t     *a = &sv->alpha[j];
+
+        CHK_API(vsp_allocate_buffers(W, H, V4L2_PIX_FMT_GREY, a->plane, 2));
+        a->sv = sv;
+
+        /* ...create compositor buffers (cache keeps a reference; never disposed) */
+        for (i = 0; i < CAMERAS_NUMBER; i++)
+        {
+            imr_meta_t     *meta;
+
+            CHK_ERR(buffer = gst_buffer_new(), -(errno = ENOMEM));
+            meta = gst_buffer_add_imr_meta(buffer);
+            meta->priv = a->plane[i >> 1];
+            meta->width = W;
+            meta->height = H;
+            meta->format = format;
+            meta->index = VSP_POOL_SIZE + j;
+            GST_META_FLAG_SET(meta, GST_META_FLAG_POOLED);
+
+            (a->buffer[i] = buffer)->pool = (void *)sv;
+        }
+    }
+
     /* ...setup IMR engines */
     for (i = 0; i < CAMERAS_NUMBER; i++)
     {
@@ -1054,6 +1681,16 @@ static gboolean __car_buffer_dispose(GstMiniObject *obj)
     return destroy;
 }
 
+/* ...fill car buffer with a fully transparent image */
+static void sv_car_buffer_clear(GstBuffer *buffer)
+{
+    imr_meta_t     *meta = gst_buffer_get_imr_meta(buffer);
+
+    memset(vsp_mem_ptr(meta->priv), 0, meta->width * meta->height * 4);
+
+    TRACE(INFO, _b("car-buffer cleared (model rendering disabled)"));
+}
+
 /* ...load car buffer with image */
 static int sv_car_buffer_load(imr_sview_t *sv, GstBuffer *buffer, const char *path)
 {
@@ -1068,8 +1705,12 @@ static int sv_car_buffer_load(imr_sview_t *sv, GstBuffer *buffer, const char *pa
 
     t0 = __get_time_usec();
 
-    /* ...load PNG image into corresponding car plane */
-    CHK_API(create_png(path, &w, &h, &format, &data));
+    /* ...take sprite from atlas if present; fall back to PNG file if it is missing there */
+    if (!sv->car_atlas || car_atlas_load(sv->car_atlas, path, data, w, h, format) < 0)
+    {
+        /* ...decode PNG image row by row into corresponding car plane */
+        CHK_API(decode_png(path, &w, &h, &format, data, w * 4, 0));
+    }
 
     t1 = __get_time_usec();
 
@@ -1078,74 +1719,62 @@ static int sv_car_buffer_load(imr_sview_t *sv, GstBuffer *buffer, const char *pa
     return 0;
 }
 
-/* ...car buffer update thread */
-static void * car_update_thread(void *arg)
+/* ...car buffer update task */
+static void sv_car_task(void *arg)
 {
     imr_sview_t     *sv = arg;
+    int             m, disabled;
 
     /* ...protect internal data access */
     pthread_mutex_lock(&sv->lock);
 
-    /* ...wait for update event */
-    while (1)
-    {
-        int     m;
-
-        /* ...wait for car model update flag */
-        while ((sv->flags & (APP_FLAG_CAR_UPDATE | APP_FLAG_EOS)) == 0)
-        {
-            pthread_cond_wait(&sv->update, &sv->lock);
-        }
-
-        /* ...check for a termination request (tbd) */
-        if (sv->flags & APP_FLAG_EOS)
-        {
-            TRACE(INIT, _b("termination request received"));
-            goto out;
-        }
+    /* ...get index of the buffer to load */
+    m = (sv->flags & APP_FLAG_SET_INDEX ? 1 : 0);
 
-        /* ...get index of the buffer to load */
-        m = (sv->flags & APP_FLAG_SET_INDEX ? 1 : 0);
+    /* ...check if model rendering is enabled */
+    disabled = (sv->flags & APP_FLAG_CAR_DISABLE ? 1 : 0);
 
-        /* ...toggle buffers immediately */
-        sv->flags ^= APP_FLAG_SET_INDEX;
+    /* ...toggle buffers immediately */
+    sv->flags ^= APP_FLAG_SET_INDEX;
 
-        /* ...release internal data lock */
-        pthread_mutex_unlock(&sv->lock);
+    /* ...release internal data lock */
+    pthread_mutex_unlock(&sv->lock);
 
-        /* ...load car model (name is pretty fake) */
-        if (sv_car_buffer_load(sv, sv->car_buffer[m], sv->car_image) != 0)
-        {
-            TRACE(ERROR, _x("car buffer loading failed: %m"));
-        }
+    /* ...load car model (name is pretty fake) */
+    if (disabled)
+    {
+        sv_car_buffer_clear(sv->car_buffer[m]);
+    }
+    else if (sv_car_buffer_load(sv, sv->car_buffer[m], sv->car_image) != 0)
+    {
+        TRACE(ERROR, _x("car buffer loading failed: %m"));
+    }
 
-        /* ...reacquire application lock */
-        pthread_mutex_lock(&sv->lock);
+    /* ...reacquire application lock */
+    pthread_mutex_lock(&sv->lock);
 
-        /* ...submit buffer to a compositor pending queue */
-        pthread_mutex_lock(&sv->vsp_lock);
-        __vsp_submit_buffer(sv, VSP_CAR, sv->car_buffer[m]);
-        pthread_mutex_unlock(&sv->vsp_lock);
+    /* ...submit buffer to a compositor pending queue */
+    pthread_mutex_lock(&sv->vsp_lock);
+    __vsp_submit_buffer(sv, VSP_CAR, sv->car_buffer[m]);
+    pthread_mutex_unlock(&sv->vsp_lock);
 
-        /* ...clear car-model update flag */
-        sv->flags &= ~APP_FLAG_CAR_UPDATE;
-    }
+    /* ...clear car-model update flag */
+    sv->flags &= ~APP_FLAG_CAR_UPDATE;
 
-out:
     /* ...release data access lock */
     pthread_mutex_unlock(&sv->lock);
-
-    TRACE(INIT, _b("car-model update thread terminated: %m"));
-
-    return NULL;
 }
 
 /* ...car model initialization */
 static int sv_car_setup(imr_sview_t *sv, int W, int H)
 {
-    pthread_attr_t  attr;
+    extern char    *__model;
+    char            path[256];
     int             j;
-    int             r;
+
+    /* ...use packed car sprites if model has them */
+    snprintf(path, sizeof(path), "%s.atlas", __model);
+    (access(path, R_OK) == 0 ? sv->car_atlas = car_atlas_open(path, SV_CAR_CACHE_SIZE) : NULL);
 
     /* ...car image plane allocation */
     CHK_API(vsp_allocate_buffers(W, H, V4L2_PIX_FMT_ARGB32, sv->car_plane, 2));
@@ -1179,16 +1808,6 @@ static int sv_car_setup(imr_sview_t *sv, int W, int H)
         (sv->car_buffer[j] = buffer)->pool = (void *)sv;
     }
 
-    /* ...initialize thread attributes (joinable, 128KB stack) */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-    pthread_attr_setstacksize(&attr, 128 << 10);
-
-    /* ...create car model update thread */
-    r = pthread_create(&sv->car_thread, &attr, car_update_thread, sv);
-    pthread_attr_destroy(&attr);
-    CHK_API(r);
-
     return 0;
 }
 
@@ -1298,19 +1917,7 @@ static gboolean animation_timer(void *data)
     memcpy(&sv->rot_acc, &sv->tr_rot_acc, sizeof(sv->rot_acc));
     memcpy(&sv->scl_acc, &sv->tr_scl_acc, sizeof(sv->scl_acc));
 #else
-    (sv->rot_acc[0] > 180 ? sv->rot_acc[0] -= 360 : 0);
-    (sv->rot_acc[1] > 180 ? sv->rot_acc[1] -= 360 : 0);
-    (sv->rot_acc[2] > 180 ? sv->rot_acc[2] -= 360 : 0);
-
-    sv->rot_acc[0] -= (sv->rot_acc[0] - __MATH_ZERO) / 2;
-    sv->rot_acc[1] -= (sv->rot_acc[1] - __MATH_ZERO) / 2;
-    sv->rot_acc[2] -= (sv->rot_acc[2] - __MATH_ZERO) / 2;
-
-    (sv->rot_acc[0] > 0 ? sv->rot_acc[0] -= 360 : 0);
-    (sv->rot_acc[1] < 0 ? sv->rot_acc[1] += 360 : 0);
-    (sv->rot_acc[2] < 0 ? sv->rot_acc[2] += 360 : 0);
-
-    sv->scl_acc -= (sv->scl_acc - __MATH_ONE) / 2;
+    __sv_matrix_animate(sv->rot_acc, &sv->scl_acc);
 #endif
     /* ...update view */
     __sv_map_update(sv);
@@ -1655,6 +2262,50 @@ int imr_sview_set_view(imr_sview_t *sv, __vec3 rot, __scalar scale, char *image)
     return CHK_API(r);
 }
 
+/* ...set view quantization coarsening level */
+int imr_sview_set_lod(imr_sview_t *sv, int lod)
+{
+    int     r = 0;
+
+    CHK_ERR(lod >= 0 && lod <= SV_VIEW_LOD_MAX, -(errno = EINVAL));
+
+    pthread_mutex_lock(&sv->lock);
+
+    /* ...snap current view to the new grid (precompiled views remain valid) */
+    if (sv->lod != lod)
+    {
+        TRACE(INFO, _b("view quantization level: %d -> %d"), sv->lod, lod);
+        sv->lod = lod;
+        r = __sv_map_update(sv);
+    }
+
+    pthread_mutex_unlock(&sv->lock);
+
+    return CHK_API(r);
+}
+
+/* ...enable/disable car model rendering */
+int imr_sview_set_car(imr_sview_t *sv, int enable)
+{
+    int     r = 0;
+
+    pthread_mutex_lock(&sv->lock);
+
+    if (!enable != !(sv->flags & APP_FLAG_CAR_DISABLE))
+    {
+        TRACE(INFO, _b("car model rendering %s"), (enable ? "enabled" : "disabled"));
+        sv->flags ^= APP_FLAG_CAR_DISABLE;
+
+        /* ...invalidate current view to force car plane update sequence */
+        memset(sv->step, 0xFF, sizeof(sv->step));
+        r = __sv_map_update(sv);
+    }
+
+    pthread_mutex_unlock(&sv->lock);
+
+    return CHK_API(r);
+}
+
 /*******************************************************************************
  * Module initialization function
  ******************************************************************************/
@@ -1690,8 +2341,10 @@ imr_sview_t * imr_sview_init(const imr_sview_cb_t *cb, void *cdata, int w, int h
     pthread_mutex_init(&sv->vsp_lock, &attr);
     pthread_mutexattr_destroy(&attr);
 
-    /* ...initialize conditional variable for mesh configuration update threads */
-    pthread_cond_init(&sv->update, NULL);
+    /* ...initialize views cache locks */
+    pthread_mutex_init(&sv->view_lock, NULL);
+    pthread_cond_init(&sv->view_wait, NULL);
+    pthread_mutex_init(&sv->mesh_lock, NULL);
 
     /* ...create animated transition timer (use default context) */
     if ((sv->timer = timer_source_create(animation_timer, sv, NULL, NULL)) == NULL)
@@ -1700,10 +2353,10 @@ imr_sview_t * imr_sview_init(const imr_sview_cb_t *cb, void *cdata, int w, int h
         goto error;
     }
 
-    /* ...create map update thread */
+    /* ...initialize view matrices */
     if (sv_map_init(sv, W, H) != 0)
     {
-        TRACE(ERROR, _x("failed to create map update thread: %m"));
+        TRACE(ERROR, _x("failed to initialize view matrices: %m"));
         goto error;
     }
 
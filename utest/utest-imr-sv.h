@@ -69,6 +69,12 @@ extern int imr_sview_input_event(imr_sview_t *sv, widget_event_t *event);
 /* ...set static view */
 extern int imr_sview_set_view(imr_sview_t *sv, __vec3 rot, __scalar scale, char *image);
 
+/* ...set view quantization coarsening level (zero - full grid) */
+extern int imr_sview_set_lod(imr_sview_t *sv, int lod);
+
+/* ...enable/disable car model rendering */
+extern int imr_sview_set_car(imr_sview_t *sv, int enable);
+
 /* ...module initialization function */
 extern imr_sview_t * imr_sview_init(const imr_sview_cb_t *cb, void *cdata, int w, int h, int ifmt, int W, int H, int cw, int ch, __vec4 shadow);
 
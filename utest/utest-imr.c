@@ -33,6 +33,8 @@
 #include "sv/trace.h"
 #include "utest-imr.h"
 #include "utest-vsink.h"
+#include "utest-stamp.h"
+#include "utest-recorder.h"
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
@@ -531,6 +533,7 @@ static inline int __submit_buffer(imr_data_t *imr, int i)
 
     /* ...save associated input buffer (takes buffer ownership) */
     buf->input = buffer;
+    stamp_buffer(buffer, STAMP_IMR_QUEUE);
 
     TRACE(DEBUG, _b("enqueue buffer #<%d,%d>"), i, j);
 
@@ -539,6 +542,7 @@ static inline int __submit_buffer(imr_data_t *imr, int i)
 
     /* ...submit buffer-pair to the V4L2 */
     CHK_API(imr_buffers_enqueue(dev->vfd, j, vmeta->plane[0], dev->input_length, buf->data, dev->output_length));
+    recorder_event(REC_IMR_SUBMIT, i, j);
 
     /* ...advance writing index */
     dev->index = (++j == dev->size ? 0 : j);
@@ -573,18 +577,25 @@ static inline int __process_buffer(imr_data_t *imr, int i)
 
     /* ...estimate buffer processing time */
     imr_avg_time_update(dev, duration);
+    recorder_event(REC_IMR_DONE, i, j);
 
     TRACE(DEBUG, _b("dequeued buffer-pair #<%d,%d>, result: %d, duration: %u, submitted: %d"), i, j, error, duration, dev->submitted);
 
     /* ...get buffer descriptor */
     buf = &dev->pool[j];
 
-    /* ...return input buffer to caller */
-    gst_buffer_unref(buf->input);
-
     /* ...get output buffer handle */
     buffer = buf->output;
 
+    /* ...propagate input frame identity and capture time to the output */
+    GST_BUFFER_OFFSET(buffer) = GST_BUFFER_OFFSET(buf->input);
+    GST_BUFFER_DTS(buffer) = GST_BUFFER_PTS(buffer) = GST_BUFFER_PTS(buf->input);
+    stamp_buffer(buf->input, STAMP_IMR);
+    stamp_copy(buffer, buf->input);
+
+    /* ...return input buffer to caller */
+    gst_buffer_unref(buf->input);
+
     /* ...advance number of busy buffers */
     dev->busy++;
 
@@ -842,19 +853,17 @@ int imr_enable(imr_data_t *imr, int enable)
 /* ...start module operation */
 int imr_start(imr_data_t *imr)
 {
-    pthread_attr_t  attr;
-    
+    static int  index;
+    char        name[16];
+
     /* ...set decoder active flag */
     imr->active = 1;
 
-    /* ...initialize thread attributes (joinable, 128KB stack) */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-    pthread_attr_setstacksize(&attr, 128 << 10);
+    /* ...engines are named in order of start */
+    sprintf(name, "imr-%d", __atomic_fetch_add(&index, 1, __ATOMIC_RELAXED));
 
     /* ...create V4L2 decoding thread to asynchronously process buffers */
-    CHK_API(pthread_create(&imr->thread, &attr, imr_thread, imr));
-    pthread_attr_destroy(&attr);
+    CHK_API(thread_create(&imr->thread, name, 128 << 10, NULL, imr_thread, imr));
 
     /* ...enable streaming */
     CHK_API(imr_enable(imr, 1));
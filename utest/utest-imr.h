@@ -33,6 +33,7 @@
 
 #include "utest-common.h"
 #include "utest-camera.h"
+#include "utest-stamp.h"
 
 /*******************************************************************************
  * Opaque handles
@@ -88,6 +89,9 @@ typedef struct imr_meta
     /* ...job sequence id */
     u32                 sequence;
 
+    /* ...processing stages times of the source frame (us) */
+    u64                 stamps[STAMP_NUMBER];
+
 }   imr_meta_t;
 
 /* ...metadata API type accessor */
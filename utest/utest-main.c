@@ -32,6 +32,11 @@
 
 #include "sv/trace.h"
 #include "utest-app.h"
+#include "utest-vin.h"
+#include "utest-vin-proto.h"
+#include "utest-stamp.h"
+#include "utest-recorder.h"
+#include "utest-pool.h"
 #include <getopt.h>
 #include <linux/videodev2.h>
 
@@ -86,6 +91,10 @@ char * vin_dev_name[8] = {
 };
 
 
+/* ...VIN capture threads configuration */
+vin_thread_cfg_t    __vin_threads[8];
+int                 __vin_threads_num = 0;
+
 /* ...meshes definitions */
 char   *__mesh_file_name = "mesh.obj";
 
@@ -94,6 +103,9 @@ u32     __vin_format = V4L2_PIX_FMT_UYVY;
 int     __vin_width = 1280, __vin_height = 1080;
 int     __vin_buffers_num = 6;
 
+/* ...maximal VIN buffer pool depth for automatic growth (zero - disabled) */
+int     __vin_pool_max = 0;
+
 /* ...VSP dimensions */
 int     __vsp_width = 1920, __vsp_height = 1080;
 
@@ -118,6 +130,35 @@ int     __steps[3] = { 8, 32, 8 };
 /* ...model file prefix */
 char   *__model = "./data/model";
 
+/* ...surround-view frame-set synchronization tolerance (us) */
+int     __sv_sync_tolerance = 10000;
+
+/* ...per-consumer decimation / pacing configuration (default - full camera rate) */
+app_rate_cfg_t  __app_rate[APP_RATE_NUMBER];
+
+/* ...renderer policy (non-zero - draw only the newest queued frames) */
+int     __render_latest = 1;
+
+/* ...load-shedding controller configuration (default - disabled) */
+app_shed_cfg_t  __app_shed = { .down = 2, .up = 10 };
+
+/* ...number of shared worker pool threads (zero - number of online processors) */
+static int  __pool_workers = 0;
+
+/* ...frame timing shared-memory ring name (NULL - disabled) */
+char   *__stamp_name = NULL;
+
+/* ...glass-to-glass latency trace output file (NULL - disabled) */
+char   *__latency_file = NULL;
+
+/* ...flight recorder output directory (NULL - disabled) and time window (s) */
+char   *__rec_path = NULL;
+int     __rec_seconds = 10;
+
+/* ...capture daemon socket (NULL - cameras are opened directly), decimation ratio and frames quota */
+char   *__vind_socket = NULL;
+int     __vind_ratio = 1, __vind_depth = 2;
+
 
 /*******************************************************************************
  * Parameters parsing
@@ -140,6 +181,92 @@ static inline int parse_vin_devices(char *str, char **name, int n)
     return 0;
 }
 
+/* ...parse VIN capture threads configuration ("devices:cpus:priority,...") */
+static inline int parse_vin_threads(char *str, vin_thread_cfg_t *cfg, int n)
+{
+    char   *s;
+    int     k;
+
+    for (k = 0, s = strtok(str, ","); s; k++, s = strtok(NULL, ","))
+    {
+        /* ...make sure we have enough space */
+        CHK_ERR(k < n, -(errno = EINVAL));
+
+        /* ...parse device/cpu masks and priority */
+        cfg[k].cpus = 0, cfg[k].priority = 0;
+        CHK_ERR(sscanf(s, "%i:%i:%d", (int *)&cfg[k].devices, (int *)&cfg[k].cpus, &cfg[k].priority) >= 1, -(errno = EINVAL));
+    }
+
+    return k;
+}
+
+/* ...parse consumers rate control configuration ("consumer=ratio[:fps],...") */
+static inline int parse_rates(char *str, app_rate_cfg_t *cfg)
+{
+    static const char  *names[APP_RATE_NUMBER] = { "sv", "dm", "sc" };
+    char               *s, *v;
+    int                 k;
+
+    for (s = strtok(str, ","); s; s = strtok(NULL, ","))
+    {
+        /* ...split consumer name and value */
+        CHK_ERR(v = strchr(s, '='), -(errno = EINVAL));
+        *v++ = '\0';
+
+        /* ...find consumer */
+        for (k = 0; k < APP_RATE_NUMBER && strcasecmp(s, names[k]); k++)
+            ;
+
+        CHK_ERR(k < APP_RATE_NUMBER, -(errno = EINVAL));
+
+        /* ...parse decimation ratio and optional target rate */
+        cfg[k].ratio = 1, cfg[k].fps = 0;
+        CHK_ERR(sscanf(v, "%d:%f", &cfg[k].ratio, &cfg[k].fps) >= 1, -(errno = EINVAL));
+        CHK_ERR(cfg[k].ratio >= 0 && cfg[k].fps >= 0, -(errno = EINVAL));
+    }
+
+    return 0;
+}
+
+/* ...parse load-shedding configuration ("fps:latency-ms[:down:up]") */
+static inline int parse_shed(char *str, app_shed_cfg_t *cfg)
+{
+    float   ms = 0;
+
+    CHK_ERR(sscanf(str, "%f:%f:%d:%d", &cfg->fps, &ms, &cfg->down, &cfg->up) >= 2, -(errno = EINVAL));
+    CHK_ERR(cfg->fps >= 0 && ms >= 0 && cfg->down > 0 && cfg->up > 0, -(errno = EINVAL));
+    cfg->latency = (u32)(ms * 1000);
+
+    return 0;
+}
+
+/* ...parse flight recorder configuration ("[seconds:]directory") */
+static inline int parse_recorder(char *str)
+{
+    char   *p;
+    int     v = (int)strtol(str, &p, 10);
+
+    /* ...optional time window prefix */
+    (p != str && *p == ':' ? __rec_seconds = v, str = p + 1 : 0);
+    CHK_ERR(__rec_seconds > 0 && *str, -(errno = EINVAL));
+    __rec_path = str;
+
+    return 0;
+}
+
+/* ...parse capture daemon connection ("socket[:ratio[:depth]]") */
+static inline int parse_vind(char *str)
+{
+    char   *p = strchr(str, ':');
+
+    /* ...optional decimation ratio and frames quota suffix */
+    (p ? *p++ = '\0', sscanf(p, "%d:%d", &__vind_ratio, &__vind_depth) : 0);
+    CHK_ERR(*str && __vind_ratio > 0 && __vind_depth > 0 && __vind_depth <= VIN_PROTO_DEPTH_MAX, -(errno = EINVAL));
+    __vind_socket = str;
+
+    return 0;
+}
+
 /* ...parse camera format */
 static inline u32 parse_format(char *str)
 {
@@ -219,6 +346,7 @@ static const struct option    options[] = {
     {   "cwidth",   required_argument,  NULL,   'X' },
     {   "cheight",  required_argument,  NULL,   'Y' },
     {   "buffers",  required_argument,  NULL,   'n' },
+    {   "pool",     required_argument,  NULL,   'p' },
     {   "steps",    required_argument,  NULL,   's' },
     {   "model",    required_argument,  NULL,   'm' },
     {   "mesh",     required_argument,  NULL,   'M' },
@@ -226,6 +354,16 @@ static const struct option    options[] = {
     {   "gain",     required_argument,  NULL,   'g' },
     {   "bgcolor",  required_argument,  NULL,   'b' },
     {   "view",     required_argument,  NULL,   'V' },
+    {   "sync",     required_argument,  NULL,   't' },
+    {   "threads",  required_argument,  NULL,   'T' },
+    {   "rate",     required_argument,  NULL,   'R' },
+    {   "stamps",   required_argument,  NULL,   'F' },
+    {   "recorder", required_argument,  NULL,   'E' },
+    {   "latency",  required_argument,  NULL,   'L' },
+    {   "render",   required_argument,  NULL,   'P' },
+    {   "workers",  required_argument,  NULL,   'K' },
+    {   "shed",     required_argument,  NULL,   'D' },
+    {   "vind",     required_argument,  NULL,   'C' },
     {   NULL,       0,                  NULL,   0   },
 };
 
@@ -238,7 +376,7 @@ static int parse_cmdline(int argc, char **argv)
     int     opt;
 
     /* ...process command-line parameters */
-    while ((opt = getopt_long(argc, argv, "d:v:o:j:r:f:w:h:W:H:X:Y:n:s:m:M:S:g:c:b:V:", options, &index)) >= 0)
+    while ((opt = getopt_long(argc, argv, "d:v:o:j:r:f:w:h:W:H:X:Y:n:p:s:m:M:S:g:c:b:V:t:T:R:F:E:L:P:K:D:C:", options, &index)) >= 0)
     {
         switch (opt)
         {
@@ -320,6 +458,12 @@ static int parse_cmdline(int argc, char **argv)
             CHK_ERR((u32)(__vin_buffers_num = atoi(optarg)) < 64, -(errno = EINVAL));
             break;
 
+        case 'p':
+            /* ...parse maximal VIN buffer pool depth */
+            TRACE(INIT, _b("Maximal pool depth: '%s'"), optarg);
+            CHK_ERR((u32)(__vin_pool_max = atoi(optarg)) <= VIDEO_MAX_FRAME, -(errno = EINVAL));
+            break;
+
         case 's':
             /* ...parse rotation axis steps */
             TRACE(INIT, _b("rotation steps: '%s'"), optarg);
@@ -361,6 +505,69 @@ static int parse_cmdline(int argc, char **argv)
             TRACE(INIT, _b("default view: '%s'"), optarg);
             CHK_API(parse_vec(optarg, __default_view, 3));
             break;
+
+        case 't':
+            /* ...surround-view frame-set synchronization tolerance */
+            TRACE(INIT, _b("sync tolerance: '%s' us"), optarg);
+            CHK_ERR((u32)(__sv_sync_tolerance = atoi(optarg)) < 1000000, -(errno = EINVAL));
+            break;
+
+        case 'T':
+            /* ...VIN capture threads configuration */
+            TRACE(INIT, _b("VIN threads: '%s'"), optarg);
+            CHK_API(__vin_threads_num = parse_vin_threads(optarg, __vin_threads, 8));
+            break;
+
+        case 'R':
+            /* ...consumers decimation / pacing */
+            TRACE(INIT, _b("consumers rate: '%s'"), optarg);
+            CHK_API(parse_rates(optarg, __app_rate));
+            break;
+
+        case 'P':
+            /* ...renderer policy */
+            TRACE(INIT, _b("render policy: '%s'"), optarg);
+            if (!strcmp(optarg, "latest"))          __render_latest = 1;
+            else if (!strcmp(optarg, "fifo"))       __render_latest = 0;
+            else                                    return -(errno = EINVAL);
+            break;
+
+        case 'K':
+            /* ...shared worker pool size */
+            TRACE(INIT, _b("worker threads: '%s'"), optarg);
+            CHK_ERR((u32)(__pool_workers = atoi(optarg)) <= 16, -(errno = EINVAL));
+            break;
+
+        case 'D':
+            /* ...load-shedding controller */
+            TRACE(INIT, _b("load shedding: '%s'"), optarg);
+            CHK_API(parse_shed(optarg, &__app_shed));
+            break;
+
+        case 'C':
+            /* ...capture daemon connection */
+            TRACE(INIT, _b("capture daemon: '%s'"), optarg);
+            CHK_API(parse_vind(optarg));
+            break;
+
+        case 'F':
+            /* ...frame timing shared-memory ring */
+            TRACE(INIT, _b("frame timing ring: '%s'"), optarg);
+            __stamp_name = optarg;
+            break;
+
+        case 'E':
+            /* ...flight recorder */
+            TRACE(INIT, _b("flight recorder: '%s'"), optarg);
+            CHK_API(parse_recorder(optarg));
+            break;
+
+        case 'L':
+            /* ...latency trace output */
+            TRACE(INIT, _b("latency trace: '%s'"), optarg);
+            __latency_file = optarg;
+            break;
+
         case 'c':
             /* ...parse configuration file */
             TRACE(INIT, _b("configuration file: '%s'"), optarg);
@@ -392,6 +599,18 @@ int main(int argc, char **argv)
     /* ...parse application specific parameters */
     CHK_API(parse_cmdline(argc, argv));
 
+    /* ...create frame timing ring if requested */
+    CHK_API(__stamp_name ? stamp_init(__stamp_name, 8, STAMP_DEPTH) : 0);
+
+    /* ...open latency trace file if requested */
+    CHK_API(__latency_file ? stamp_trace_open(__latency_file) : 0);
+
+    /* ...start flight recorder if requested */
+    CHK_API(__rec_path ? recorder_init(__rec_path, __rec_seconds) : 0);
+
+    /* ...start shared worker pool */
+    CHK_API(pool_init(__pool_workers));
+
     /* ...initialize display subsystem */
     CHK_ERR(display = display_create(), -errno);
 
@@ -401,6 +620,12 @@ int main(int argc, char **argv)
     /* ...execute mainloop thread */
     app_thread(app);
 
+    /* ...stop worker pool and flight recorder, finalize latency trace and remove frame timing ring */
+    pool_destroy();
+    recorder_destroy();
+    stamp_trace_close();
+    stamp_destroy();
+
     TRACE(INIT, _b("application terminated"));
     
     return 0;
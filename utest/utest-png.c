@@ -63,36 +63,40 @@ static __attribute__((noreturn))  void __read_error(png_structp png_ptr, png_con
     longjmp(*jbp, EBADF);
 }
 
-int create_png(const char *path, int *width, int *height, int *format, void **data)
+/* ...premultiply color components of a decoded row by alpha */
+static inline void __png_premultiply(png_bytep p, int w)
+{
+    u32     a;
+
+    /* ...native pixel layout is B, G, R, A */
+    for (; w > 0; w--, p += 4)
+    {
+        a = p[3];
+        p[0] = (u8)((p[0] * a + 127) / 255);
+        p[1] = (u8)((p[1] * a + 127) / 255);
+        p[2] = (u8)((p[2] * a + 127) / 255);
+    }
+}
+
+/* ...decode PNG stream row by row (file name is used for diagnostics only) */
+static int __create_png(FILE *fp, const char *path, int *width, int *height, int *format, void **data, int stride, u32 flags)
 {
-	FILE                   *fp;
     unsigned char           header[8];
-	int                     y, w, h, fmt, stride = 0;
+	int                     y, w, h, fmt, pass, passes;
+	size_t                  rowbytes;
 	png_byte                color_type;
 	png_byte                bit_depth;
 	png_structp             png_ptr;
 	png_infop               info_ptr;
-	png_bytep * volatile    row_pointers = NULL;
-	png_bytep               row = NULL;
+	png_bytep volatile      row = NULL;
     jmp_buf                 jb;
 
-    /* ...sanity check - data buffer pointer must be provided */
-    CHK_ERR(data, -EINVAL);
-
-    /* ...open image file */
-	if ((fp = fopen(path, "rb")) == NULL)
-    {
-        TRACE(ERROR, _x("failed to open '%s': %m"), path);
-        return -errno;
-    }
-
     /* ...parse image header */
-    fread(header, 1, 8, fp);
-    if (png_sig_cmp(header, 0, 8))
+    if (fread(header, 1, 8, fp) != 8 || png_sig_cmp(header, 0, 8))
     {
         TRACE(ERROR, _x("invalid image '%s'"), path);
         errno = EBADF;
-        goto error;
+        return -1;
     }
     
     /* ...initialize PNG library handle */
@@ -100,7 +104,7 @@ int create_png(const char *path, int *width, int *height, int *format, void **da
     {
         TRACE(ERROR, _x("failed to read image '%s': %m"), path);
         errno = EBADF;
-        goto error;
+        return -1;
     }
 
     /* ...get image info */
@@ -190,6 +194,9 @@ int create_png(const char *path, int *width, int *height, int *format, void **da
     if (color_type & PNG_COLOR_MASK_COLOR)
         png_set_bgr(png_ptr);
 
+    /* ...interlaced images are decoded in several passes over the destination */
+    passes = png_set_interlace_handling(png_ptr);
+
     /* ...update image info after parameters adjustment */
     png_read_update_info(png_ptr, info_ptr);
     color_type = png_get_color_type(png_ptr, info_ptr);
@@ -220,17 +227,32 @@ int create_png(const char *path, int *width, int *height, int *format, void **da
         goto error_png;
     }
     
-    /* ...get image stride */
-    stride = png_get_rowbytes(png_ptr, info_ptr);
+    /* ...premultiplication is defined for images with alpha only */
+    if ((flags & PNG_DECODE_PREMULTIPLY) && fmt != GST_VIDEO_FORMAT_ARGB)
+    {
+        TRACE(ERROR, _x("image '%s' has no alpha channel to premultiply"), path);
+        errno = EINVAL;
+        goto error_png;
+    }
+
+    /* ...get image row length */
+    rowbytes = png_get_rowbytes(png_ptr, info_ptr);
 
-    /* ...make it 4-bytes aligned */
-    stride = (stride + 3) & ~3;
+    /* ...use 4-bytes aligned rows unless destination layout is given */
+    (!stride ? stride = (int)((rowbytes + 3) & ~3) : 0);
+
+    if ((size_t)stride < rowbytes)
+    {
+        TRACE(ERROR, _x("image '%s' row (%zu bytes) exceeds destination stride %d"), path, rowbytes, stride);
+        errno = EINVAL;
+        goto error_png;
+    }
 
     /* ...set pixeldata pointer */
     if (*data == NULL)
     {
         /* ...allocate pixeldata */
-        if ((row = malloc(stride * h)) == NULL)
+        if ((row = malloc((size_t)stride * h)) == NULL)
         {
             TRACE(ERROR, _x("failed to allocate image data"));
             errno = ENOMEM;
@@ -243,47 +265,102 @@ int create_png(const char *path, int *width, int *height, int *format, void **da
         row = *data;
     }
 
-    /* ...allocate row pointers array */
-    if ((row_pointers = malloc(sizeof(png_bytep) * h)) == NULL)
+    /* ...decode rows straight into destination; conversion is done while row is in cache */
+    for (pass = 0; pass < passes; pass++)
     {
-        TRACE(ERROR, _x("failed to create row-pointers array"));
-        errno = ENOMEM;
-        goto error_png;
-    }
+        for (y = 0; y < h; y++)
+        {
+            png_bytep   p = row + (size_t)y * stride;
 
-    /* ...initialize row pointers */
-    for (y = 0; y < h; y++, row += stride)
-        row_pointers[y] = row;
+            png_read_row(png_ptr, p, NULL);
+
+            /* ...row is final only after the last pass */
+            (pass == passes - 1 && (flags & PNG_DECODE_PREMULTIPLY) ? __png_premultiply(p, w), 0 : 0);
+        }
+    }
 
-    /* ...read image */
-    png_read_image(png_ptr, row_pointers);
+    png_read_end(png_ptr, NULL);
 
     /* ...save row pointer if needed */
-    (*data == NULL ? *data = row_pointers[0] : 0);
+    (*data == NULL ? *data = row : 0);
 
     TRACE(INIT, _b("PNG[%s] image %u*%u created: %p"), path, w, h, *data);
 
-    /* ...release interim memory */
-	free(row_pointers);
-
     /* ...destroy PNG data */
 	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 
-    fclose(fp);
-    
     return 0;
 
 error_png:
     /* ...release rows */
-    (row && row != *data ? free(row) : 0), (row_pointers ? free(row_pointers) : 0);
+    (row && row != *data ? free(row) : 0);
 
     /* ...destroy PNG data */
 	png_destroy_read_struct(&png_ptr, &info_ptr, NULL);
 
-error:
+	return -1;
+}
+
+int create_png(const char *path, int *width, int *height, int *format, void **data)
+{
+	FILE       *fp;
+    int         r;
+
+    /* ...sanity check - data buffer pointer must be provided */
+    CHK_ERR(data, -EINVAL);
+
+    /* ...open image file */
+	if ((fp = fopen(path, "rb")) == NULL)
+    {
+        TRACE(ERROR, _x("failed to open '%s': %m"), path);
+        return -errno;
+    }
+
+    r = __create_png(fp, path, width, height, format, data, 0, 0);
+
     /* ...close file handle */
 	fclose(fp);
-	return -1;
+
+    return r;
+}
+
+/* ...decode PNG file into caller-supplied plane with given stride */
+int decode_png(const char *path, int *width, int *height, int *format, void *data, int stride, u32 flags)
+{
+	FILE       *fp;
+    int         r;
+
+    /* ...destination plane must be provided */
+    CHK_ERR(data && stride >= 0, -EINVAL);
+
+	if ((fp = fopen(path, "rb")) == NULL)
+    {
+        TRACE(ERROR, _x("failed to open '%s': %m"), path);
+        return -errno;
+    }
+
+    r = __create_png(fp, path, width, height, format, &data, stride, flags);
+
+	fclose(fp);
+
+    return r;
+}
+
+/* ...decode PNG image held in memory (e.g. mapped sprite atlas entry) into caller-supplied plane */
+int decode_png_mem(const void *buf, size_t size, const char *name, int *width, int *height, int *format, void *data, int stride, u32 flags)
+{
+	FILE       *fp;
+    int         r;
+
+    CHK_ERR(data && stride >= 0 && buf && size, -EINVAL);
+
+	CHK_ERR(fp = fmemopen((void *)buf, size, "rb"), -errno);
+
+    r = __create_png(fp, name, width, height, format, &data, stride, flags);
+
+	fclose(fp);
+
+    return r;
 }
 
 /*******************************************************************************
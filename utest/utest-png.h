@@ -34,6 +34,15 @@
 /* ...load PNG file */
 extern int create_png(const char *path, int *width, int *height, int *format, void **data);
 
+/* ...premultiply color components by alpha while decoding */
+#define PNG_DECODE_PREMULTIPLY          (1 << 0)
+
+/* ...decode PNG file row by row into caller-supplied plane (zero stride - packed rows) */
+extern int decode_png(const char *path, int *width, int *height, int *format, void *data, int stride, u32 flags);
+
+/* ...decode PNG image from memory row by row into caller-supplied plane */
+extern int decode_png_mem(const void *buf, size_t size, const char *name, int *width, int *height, int *format, void *data, int stride, u32 flags);
+
 /* ...write PNG file */
 extern int store_png(const char *path, int width, int height, int format, void *data);
 
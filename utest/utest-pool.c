@@ -0,0 +1,318 @@
+/*******************************************************************************
+ * utest-pool.c
+ *
+ * Shared work-stealing worker pool
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      POOL
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-pool.h"
+#include <unistd.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...maximal number of worker threads */
+#define POOL_WORKERS_MAX                16
+
+/*******************************************************************************
+ * Local typedefs
+ ******************************************************************************/
+
+/* ...task descriptor */
+typedef struct pool_task
+{
+    /* ...task function and its argument */
+    void              (*fn)(void *);
+    void               *arg;
+
+}   pool_task_t;
+
+/* ...worker thread data */
+typedef struct pool_worker
+{
+    /* ...per-priority local task queues */
+    GQueue              queue[POOL_PRIO_NUMBER];
+
+    /* ...local queues access lock */
+    pthread_mutex_t     lock;
+
+    /* ...worker thread handle */
+    pthread_t           thread;
+
+    /* ...executed / stolen tasks counters */
+    u32                 executed, stolen;
+
+}   pool_worker_t;
+
+/* ...pool data */
+typedef struct pool
+{
+    /* ...worker threads */
+    pool_worker_t       worker[POOL_WORKERS_MAX];
+    int                 num;
+
+    /* ...round-robin index for submissions from outside of the pool */
+    u32                 next;
+
+    /* ...number of queued tasks not yet claimed by workers */
+    u32                 pending;
+
+    /* ...termination request */
+    int                 exit;
+
+    /* ...pending counter access lock */
+    pthread_mutex_t     lock;
+
+    /* ...work availability condition */
+    pthread_cond_t      wait;
+
+}   pool_t;
+
+/*******************************************************************************
+ * Local variables
+ ******************************************************************************/
+
+/* ...global pool instance */
+static pool_t          *__pool;
+
+/* ...worker descriptor of current thread (NULL outside of the pool) */
+static __thread pool_worker_t  *__pool_self;
+
+/*******************************************************************************
+ * Internal helpers
+ ******************************************************************************/
+
+/* ...take highest-priority task; local queue head first, then tail of the other workers queues */
+static pool_task_t * __pool_take(pool_t *pool, int id)
+{
+    pool_task_t    *task = NULL;
+    int             prio, i, k;
+
+    for (prio = 0; prio < POOL_PRIO_NUMBER; prio++)
+    {
+        for (i = 0; i < pool->num; i++)
+        {
+            pool_worker_t  *w = &pool->worker[k = (id + i) % pool->num];
+
+            pthread_mutex_lock(&w->lock);
+            task = (i == 0 ? g_queue_pop_head(&w->queue[prio]) : g_queue_pop_tail(&w->queue[prio]));
+            pthread_mutex_unlock(&w->lock);
+
+            if (task)
+            {
+                (k != id ? pool->worker[id].stolen++ : 0);
+                return task;
+            }
+        }
+    }
+
+    return NULL;
+}
+
+/* ...worker thread */
+static void * pool_thread(void *arg)
+{
+    pool_worker_t  *w = arg;
+    pool_t         *pool = __pool;
+    int             id = (int)(w - pool->worker);
+
+    __pool_self = w;
+
+    while (1)
+    {
+        pool_task_t    *task;
+
+        /* ...claim one of the queued tasks */
+        pthread_mutex_lock(&pool->lock);
+
+        while (pool->pending == 0 && !pool->exit)
+        {
+            pthread_cond_wait(&pool->wait, &pool->lock);
+        }
+
+        /* ...terminate once all queued tasks are drained */
+        if (pool->pending == 0)
+        {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+
+        pool->pending--;
+
+        pthread_mutex_unlock(&pool->lock);
+
+        /* ...claimed task is guaranteed to sit in one of the queues */
+        while ((task = __pool_take(pool, id)) == NULL)
+            ;
+
+        task->fn(task->arg);
+        free(task);
+
+        w->executed++;
+    }
+
+    TRACE(DEBUG, _b("worker-%d terminated"), id);
+
+    return NULL;
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/* ...submit task for asynchronous execution */
+int pool_submit(int prio, void (*fn)(void *), void *arg)
+{
+    pool_t         *pool = __pool;
+    pool_worker_t  *w;
+    pool_task_t    *task;
+
+    CHK_ERR((u32)prio < POOL_PRIO_NUMBER, -(errno = EINVAL));
+
+    /* ...execute task in-place if pool is not started */
+    if (!pool)
+    {
+        fn(arg);
+        return 0;
+    }
+
+    CHK_ERR(task = malloc(sizeof(*task)), -(errno = ENOMEM));
+    task->fn = fn, task->arg = arg;
+
+    /* ...tasks spawned by workers stay local; others are distributed round-robin */
+    w = (__pool_self ? : &pool->worker[__atomic_fetch_add(&pool->next, 1, __ATOMIC_RELAXED) % pool->num]);
+
+    pthread_mutex_lock(&w->lock);
+    g_queue_push_tail(&w->queue[prio], task);
+    pthread_mutex_unlock(&w->lock);
+
+    /* ...publish the task */
+    pthread_mutex_lock(&pool->lock);
+    pool->pending++;
+    pthread_cond_signal(&pool->wait);
+    pthread_mutex_unlock(&pool->lock);
+
+    return 0;
+}
+
+/* ...number of worker threads (zero if tasks are executed in-place) */
+int pool_size(void)
+{
+    return (__pool ? __pool->num : 0);
+}
+
+/* ...start worker threads (zero - number of online processors) */
+int pool_init(int workers)
+{
+    pool_t         *pool;
+    char            name[16];
+    int             i, j;
+
+    CHK_ERR(!__pool, -(errno = EBUSY));
+
+    (workers <= 0 ? workers = (int)sysconf(_SC_NPROCESSORS_ONLN) : 0);
+    (workers > POOL_WORKERS_MAX ? workers = POOL_WORKERS_MAX : 0);
+    (workers < 1 ? workers = 1 : 0);
+
+    CHK_ERR(pool = calloc(1, sizeof(*pool)), -(errno = ENOMEM));
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->wait, NULL);
+
+    for (i = 0; i < workers; i++)
+    {
+        pthread_mutex_init(&pool->worker[i].lock, NULL);
+
+        for (j = 0; j < POOL_PRIO_NUMBER; j++)
+        {
+            g_queue_init(&pool->worker[i].queue[j]);
+        }
+    }
+
+    __pool = pool, pool->num = workers;
+
+    for (i = 0; i < workers; i++)
+    {
+        sprintf(name, "pool-%d", i);
+
+        /* ...create worker thread (256KB stack) */
+        if (thread_create(&pool->worker[i].thread, name, 256 << 10, NULL, pool_thread, &pool->worker[i]) != 0)
+        {
+            TRACE(ERROR, _x("failed to create worker-%d: %m"), i);
+            pool->num = i;
+            break;
+        }
+    }
+
+    /* ...release pool if no worker has started */
+    if (pool->num == 0)
+    {
+        __pool = NULL;
+        free(pool);
+        return -errno;
+    }
+
+    TRACE(INIT, _b("worker pool created: %d threads"), pool->num);
+
+    return 0;
+}
+
+/* ...drain queued tasks and stop worker threads */
+void pool_destroy(void)
+{
+    pool_t     *pool = __pool;
+    int         i;
+
+    if (!pool)      return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->exit = 1;
+    pthread_cond_broadcast(&pool->wait);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (i = 0; i < pool->num; i++)
+    {
+        pthread_join(pool->worker[i].thread, NULL);
+
+        TRACE(INFO, _b("worker-%d: executed=%u, stolen=%u"), i, pool->worker[i].executed, pool->worker[i].stolen);
+    }
+
+    __pool = NULL;
+    free(pool);
+}
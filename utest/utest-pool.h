@@ -0,0 +1,58 @@
+/*******************************************************************************
+ * utest-pool.h
+ *
+ * Shared work-stealing worker pool
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#ifndef __UTEST_POOL_H
+#define __UTEST_POOL_H
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "utest-common.h"
+
+/*******************************************************************************
+ * Task priorities (lower value is served first)
+ ******************************************************************************/
+
+enum {
+    POOL_PRIO_FRAME,
+    POOL_PRIO_BACKGROUND,
+    POOL_PRIO_NUMBER,
+};
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+extern int pool_init(int workers);
+
+extern void pool_destroy(void);
+
+extern int pool_submit(int prio, void (*fn)(void *), void *arg);
+
+extern int pool_size(void);
+
+#endif  /* __UTEST_POOL_H */
@@ -0,0 +1,438 @@
+/*******************************************************************************
+ * utest-recorder.c
+ *
+ * ADAS unit-test. Pipeline events flight recorder
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      REC
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-recorder.h"
+#include <unistd.h>
+#include <signal.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...estimated events rate used for ring sizing (events per second) */
+#define REC_EVENTS_RATE                 2048
+
+/* ...supervision period (ms) */
+#define REC_CHECK_PERIOD                250
+
+/* ...render stall duration treated as a pipeline hang (us) */
+#define REC_WATCHDOG_TIMEOUT            1000000
+
+/* ...frame-rate collapse detection: minimal average rate and drop factor */
+#define REC_FPS_MIN                     5
+#define REC_FPS_COLLAPSE                0.5
+
+/* ...minimal interval between automatically triggered dumps (us) */
+#define REC_DUMP_INTERVAL               10000000
+
+/* ...dump triggers */
+#define REC_TRIGGER_REQUEST             1
+#define REC_TRIGGER_WATCHDOG            2
+#define REC_TRIGGER_FPS                 3
+
+/*******************************************************************************
+ * Local typedefs
+ ******************************************************************************/
+
+/* ...compact event record */
+typedef struct rec_event
+{
+    /* ...event time (CLOCK_MONOTONIC, us) */
+    u64                 ts;
+
+    /* ...position in the event stream plus one (zero while record is written) */
+    u32                 seq;
+
+    /* ...event type and source identifier */
+    u16                 type, id;
+
+    /* ...event argument (sequence number, buffer index, etc) */
+    u32                 arg;
+
+    /* ...padding */
+    u32                 reserved;
+
+}   rec_event_t;
+
+/* ...recorder data */
+typedef struct recorder
+{
+    /* ...events ring and its index mask */
+    rec_event_t        *ring;
+    u32                 mask;
+
+    /* ...events stream position */
+    u32                 head;
+
+    /* ...time window to dump (us) */
+    u64                 window;
+
+    /* ...output directory */
+    char               *path;
+
+    /* ...wake-up event descriptor */
+    int                 evfd;
+
+    /* ...supervision thread */
+    pthread_t           thread;
+
+    /* ...time of last render event and total number of renders */
+    u64                 last_render;
+    u32                 renders;
+
+    /* ...render events counter at last check and average rate */
+    u32                 renders_last;
+    float               fps_avg;
+
+    /* ...time of last automatic dump */
+    u64                 last_dump;
+
+    /* ...stall has been reported already */
+    int                 stalled;
+
+}   recorder_t;
+
+/*******************************************************************************
+ * Local variables
+ ******************************************************************************/
+
+/* ...global recorder handle (NULL - disabled) */
+static recorder_t      *__recorder;
+
+/* ...wake-up descriptor used from a signal handler */
+static int              __recorder_evfd = -1;
+
+/* ...event names */
+static const char      *__rec_names[REC_NUMBER] = {
+    [REC_VIN_DEQUEUE] = "vin-dequeue",
+    [REC_IMR_SUBMIT] = "imr-submit",
+    [REC_IMR_DONE] = "imr-done",
+    [REC_VSP_SUBMIT] = "vsp-submit",
+    [REC_VSP_DONE] = "vsp-done",
+    [REC_RENDER] = "render",
+    [REC_VIEW_CHANGE] = "view-change",
+    [REC_DUMP] = "dump",
+};
+
+/* ...trigger names */
+static const char      *__rec_triggers[] = {
+    [REC_TRIGGER_REQUEST] = "request",
+    [REC_TRIGGER_WATCHDOG] = "watchdog",
+    [REC_TRIGGER_FPS] = "fps-collapse",
+};
+
+/*******************************************************************************
+ * Internal helpers
+ ******************************************************************************/
+
+/* ...current monotonic time in microseconds */
+static inline u64 __rec_now(void)
+{
+    struct timespec     ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* ...post wake-up event to supervision thread */
+static inline void __rec_kick(int fd, u64 v)
+{
+    /* ...write to eventfd is async-signal-safe; failure means counter overflow only */
+    (void)!write(fd, &v, sizeof(v));
+}
+
+/* ...dump request signal handler */
+static void __rec_signal(int sig)
+{
+    (__recorder_evfd >= 0 ? __rec_kick(__recorder_evfd, REC_TRIGGER_REQUEST) : (void)0);
+}
+
+/*******************************************************************************
+ * Dumping
+ ******************************************************************************/
+
+/* ...write last recorded events into a file */
+static int __rec_dump(recorder_t *rec, int trigger)
+{
+    u32             head = __atomic_load_n(&rec->head, __ATOMIC_ACQUIRE);
+    u32             n = (head > rec->mask ? rec->mask + 1 : head);
+    u64             now = __rec_now();
+    char            name[256];
+    FILE           *f;
+    u32             k, written = 0;
+
+    /* ...create output file */
+    snprintf(name, sizeof(name), "%s/flight-%llu-%s.csv", rec->path, (unsigned long long)now, __rec_triggers[trigger]);
+    CHK_ERR(f = fopen(name, "wt"), -errno);
+
+    fprintf(f, "# trigger=%s, now=%llu us, window=%llu us\n", __rec_triggers[trigger], (unsigned long long)now, (unsigned long long)rec->window);
+    fprintf(f, "ts,event,id,arg\n");
+
+    /* ...go through the ring from the oldest to the newest record */
+    for (k = head - n; k != head; k++)
+    {
+        rec_event_t    *e = &rec->ring[k & rec->mask];
+        rec_event_t     v;
+
+        /* ...copy the record and make sure it has not been overwritten meanwhile */
+        if (__atomic_load_n(&e->seq, __ATOMIC_ACQUIRE) != k + 1)    continue;
+        v = *e;
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&e->seq, __ATOMIC_RELAXED) != k + 1)    continue;
+
+        /* ...skip events out of the time window */
+        if (v.ts + rec->window < now)       continue;
+
+        fprintf(f, "%llu,%s,%u,%u\n", (unsigned long long)v.ts, (v.type < REC_NUMBER ? __rec_names[v.type] : "?"), v.id, v.arg);
+        written++;
+    }
+
+    fclose(f);
+
+    TRACE(INFO, _b("flight recorder dumped (%s): %u events into '%s'"), __rec_triggers[trigger], written, name);
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Supervision thread
+ ******************************************************************************/
+
+/* ...check rendering progress; return dump trigger if pipeline stalls or frame-rate collapses */
+static int __rec_check(recorder_t *rec, u64 now)
+{
+    u64     last = __atomic_load_n(&rec->last_render, __ATOMIC_RELAXED);
+    u32     renders = __atomic_load_n(&rec->renders, __ATOMIC_RELAXED);
+    float   fps = (renders - rec->renders_last) * 1000.0 / REC_CHECK_PERIOD;
+    int     trigger = 0;
+
+    rec->renders_last = renders;
+
+    /* ...nothing rendered yet */
+    if (!last)      return 0;
+
+    /* ...detect rendering stall (report it once) */
+    if (now - last > REC_WATCHDOG_TIMEOUT)
+    {
+        (!rec->stalled ? rec->stalled = 1, trigger = REC_TRIGGER_WATCHDOG : 0);
+    }
+    else
+    {
+        rec->stalled = 0;
+
+        /* ...detect sudden drop of frame-rate against slowly moving average */
+        (rec->fps_avg > REC_FPS_MIN && fps < rec->fps_avg * REC_FPS_COLLAPSE ? trigger = REC_TRIGGER_FPS : 0);
+    }
+
+    /* ...update average rate */
+    rec->fps_avg += (fps - rec->fps_avg) / 8;
+
+    /* ...limit rate of automatic dumps */
+    if (trigger && rec->last_dump && now - rec->last_dump < REC_DUMP_INTERVAL)
+    {
+        trigger = 0;
+    }
+
+    return trigger;
+}
+
+/* ...recorder supervision thread */
+static void * recorder_thread(void *arg)
+{
+    recorder_t     *rec = arg;
+    struct pollfd   pfd = { .fd = rec->evfd, .events = POLLIN };
+
+    while (1)
+    {
+        int     r = poll(&pfd, 1, REC_CHECK_PERIOD);
+        u64     v, now = __rec_now();
+        int     trigger;
+
+        if (r < 0)
+        {
+            /* ...ignore soft interruptions */
+            if (errno == EINTR)     continue;
+            TRACE(ERROR, _x("poll failed: %m"));
+            break;
+        }
+
+        if (r > 0)
+        {
+            /* ...explicit dump request */
+            trigger = (read(rec->evfd, &v, sizeof(v)) == sizeof(v) ? REC_TRIGGER_REQUEST : 0);
+        }
+        else if ((trigger = __rec_check(rec, now)) != 0)
+        {
+            rec->last_dump = now;
+        }
+
+        if (trigger)
+        {
+            recorder_event(REC_DUMP, trigger, 0);
+            (__rec_dump(rec, trigger) < 0 ? TRACE(ERROR, _x("failed to dump flight recorder: %m")) : 0);
+        }
+    }
+
+    return (void *)(intptr_t)-errno;
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/* ...record pipeline event */
+void recorder_event(int type, int id, u32 arg)
+{
+    recorder_t     *rec = __recorder;
+    rec_event_t    *e;
+    u32             k;
+    u64             now;
+
+    /* ...recording is disabled */
+    if (!rec)       return;
+
+    /* ...claim the slot */
+    k = __atomic_fetch_add(&rec->head, 1, __ATOMIC_RELAXED);
+    e = &rec->ring[k & rec->mask];
+
+    /* ...invalidate slot while it is written */
+    __atomic_store_n(&e->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    e->ts = now = __rec_now(), e->type = (u16)type, e->id = (u16)id, e->arg = arg;
+
+    __atomic_store_n(&e->seq, k + 1, __ATOMIC_RELEASE);
+
+    /* ...track rendering progress */
+    if (type == REC_RENDER)
+    {
+        __atomic_store_n(&rec->last_render, now, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&rec->renders, 1, __ATOMIC_RELAXED);
+    }
+}
+
+/* ...request asynchronous dump */
+void recorder_dump(void)
+{
+    (__recorder ? __rec_kick(__recorder->evfd, REC_TRIGGER_REQUEST) : (void)0);
+}
+
+/* ...create flight recorder */
+int recorder_init(const char *path, int seconds)
+{
+    recorder_t         *rec;
+    struct sigaction    sa;
+    u32                 n;
+
+    /* ...sanity check */
+    CHK_ERR(!__recorder && seconds > 0, -(errno = EINVAL));
+
+    CHK_ERR(rec = calloc(1, sizeof(*rec)), -(errno = ENOMEM));
+
+    /* ...ring capacity is a power of two covering requested time window */
+    for (n = 1024; n < (u32)seconds * REC_EVENTS_RATE; n <<= 1)
+        ;
+
+    if ((rec->ring = calloc(n, sizeof(*rec->ring))) == NULL || (rec->path = strdup(path)) == NULL)
+    {
+        errno = ENOMEM;
+        goto error;
+    }
+
+    rec->mask = n - 1, rec->window = (u64)seconds * 1000000;
+
+    /* ...create wake-up event */
+    if ((rec->evfd = eventfd(0, EFD_NONBLOCK)) < 0)
+    {
+        TRACE(ERROR, _x("failed to create event: %m"));
+        goto error;
+    }
+
+    /* ...create supervision thread (128KB stack) */
+    if (thread_create(&rec->thread, "recorder", 128 << 10, NULL, recorder_thread, rec) != 0)
+    {
+        TRACE(ERROR, _x("failed to create thread: %m"));
+        close(rec->evfd);
+        goto error;
+    }
+
+    /* ...enable recording */
+    __recorder_evfd = rec->evfd, __recorder = rec;
+
+    /* ...dump on SIGUSR1 */
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = __rec_signal, sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
+
+    TRACE(INIT, _b("flight recorder created: %u events, %d seconds window, output: '%s'"), n, seconds, path);
+
+    return 0;
+
+error:
+    free(rec->path), free(rec->ring), free(rec);
+    return -errno;
+}
+
+/* ...destroy flight recorder */
+void recorder_destroy(void)
+{
+    recorder_t     *rec = __recorder;
+
+    if (!rec)       return;
+
+    /* ...restore default signal disposition */
+    signal(SIGUSR1, SIG_DFL);
+
+    /* ...disable recording and stop supervision thread */
+    __recorder = NULL, __recorder_evfd = -1;
+    pthread_cancel(rec->thread);
+    pthread_join(rec->thread, NULL);
+
+    /* ...release resources (ring is kept as some writers may still be running) */
+    close(rec->evfd);
+    free(rec->path);
+
+    TRACE(INIT, _b("flight recorder destroyed"));
+}
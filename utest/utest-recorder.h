@@ -0,0 +1,64 @@
+/*******************************************************************************
+ * utest-recorder.h
+ *
+ * ADAS unit-test. Pipeline events flight recorder
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#ifndef __UTEST_RECORDER_H
+#define __UTEST_RECORDER_H
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "utest-common.h"
+
+/*******************************************************************************
+ * Event types
+ ******************************************************************************/
+
+enum {
+    REC_VIN_DEQUEUE,
+    REC_IMR_SUBMIT,
+    REC_IMR_DONE,
+    REC_VSP_SUBMIT,
+    REC_VSP_DONE,
+    REC_RENDER,
+    REC_VIEW_CHANGE,
+    REC_DUMP,
+    REC_NUMBER,
+};
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+extern int recorder_init(const char *path, int seconds);
+
+extern void recorder_destroy(void);
+
+extern void recorder_event(int type, int id, u32 arg);
+
+extern void recorder_dump(void);
+
+#endif  /* __UTEST_RECORDER_H */
@@ -0,0 +1,117 @@
+/*******************************************************************************
+ * utest-ring.h
+ *
+ * ADAS unit-test. Single-producer / single-consumer ring
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#ifndef __UTEST_RING_H
+#define __UTEST_RING_H
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "utest-common.h"
+
+/*******************************************************************************
+ * Types definitions
+ ******************************************************************************/
+
+/* ...bounded ring of pointers; one producer and one consumer thread may access it without a lock */
+typedef struct ring
+{
+    /* ...items storage and index mask (capacity is a power of two) */
+    void              **data;
+    u32                 mask;
+
+    /* ...write position (modified by producer only) */
+    u32                 head __attribute__((aligned(64)));
+
+    /* ...read position (modified by consumer only) */
+    u32                 tail __attribute__((aligned(64)));
+
+}   ring_t;
+
+/*******************************************************************************
+ * Ring operations
+ ******************************************************************************/
+
+/* ...allocate ring storage (size must be a power of two) */
+static inline int ring_init(ring_t *r, u32 size)
+{
+    CHK_ERR(size && (size & (size - 1)) == 0, -(errno = EINVAL));
+    CHK_ERR(r->data = calloc(size, sizeof(void *)), -(errno = ENOMEM));
+    r->mask = size - 1, r->head = r->tail = 0;
+    return 0;
+}
+
+/* ...release ring storage */
+static inline void ring_destroy(ring_t *r)
+{
+    free(r->data), r->data = NULL;
+}
+
+/* ...number of items in the ring (approximate if called by a third party) */
+static inline u32 ring_count(ring_t *r)
+{
+    return __atomic_load_n(&r->head, __ATOMIC_ACQUIRE) - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE);
+}
+
+/* ...check if ring is empty */
+static inline int ring_empty(ring_t *r)
+{
+    return ring_count(r) == 0;
+}
+
+/* ...put item into the ring (producer side) */
+static inline int ring_push(ring_t *r, void *item)
+{
+    u32     head = r->head;
+
+    /* ...make sure there is a room */
+    if (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) > r->mask)    return -(errno = ENOSPC);
+
+    /* ...place the item and publish it */
+    r->data[head & r->mask] = item;
+    __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+
+    return 0;
+}
+
+/* ...get item from the ring (consumer side); NULL if ring is empty */
+static inline void * ring_pop(ring_t *r)
+{
+    u32     tail = r->tail;
+    void   *item;
+
+    /* ...check if there is an item available */
+    if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) == tail)    return NULL;
+
+    /* ...retrieve the item and release the slot */
+    item = r->data[tail & r->mask];
+    __atomic_store_n(&r->tail, tail + 1, __ATOMIC_RELEASE);
+
+    return item;
+}
+
+#endif  /* __UTEST_RING_H */
@@ -34,6 +34,10 @@
 #include "utest-app.h"
 #include "utest-vsink.h"
 #include "utest-vin.h"
+#include "utest-vin-client.h"
+#include "utest-stamp.h"
+#include "utest-recorder.h"
+#include "utest-ring.h"
 #include "utest-imr.h"
 #include "utest-mesh.h"
 #include "utest-meta.h"
@@ -42,6 +46,8 @@
 #include <linux/videodev2.h>
 #include <pango/pangocairo.h>
 #include <math.h>
+#include <signal.h>
+#include <glib-unix.h>
 #include "sv/svlib.h"
 #include "objdet.h"
 #include "utest-imr-sv.h"
@@ -59,23 +65,12 @@ TRACE_TAG(DEBUG, 1);
  * Local constants definitions
  ******************************************************************************/
 
-/* ...VIN devices identifiers */
-#define VIN_SV_LEFT                     0
-#define VIN_SV_RIGHT                    1
-#define VIN_SV_FRONT                    2
-#define VIN_SV_REAR                     3
-#define VIN_DM                          4
-#define VIN_SC_LEFT                     5
-#define VIN_SC_RIGHT                    6
-#define VIN_SC_REAR                     7
-#define VIN_NUMBER                      8
-
-/* ...IMR engines identifiers */
-#define IMR_SC_LEFT                     0
-#define IMR_SC_RIGHT                    1
-#define IMR_SC_REAR                     2
-#define IMR_DM                          3
-#define IMR_NUMBER                      4
+/* ...maximal number of VIN devices */
+#define VIN_NUMBER_MAX                  16
+
+/* ...maximal number of driver-monitor / smart-cameras (limited by screen layout) */
+#define DM_CAMERAS_MAX                  1
+#define SC_CAMERAS_MAX                  3
 
 /* ...surround-view output stream */
 #define OUT_SV                          0
@@ -88,6 +83,18 @@ TRACE_TAG(DEBUG, 1);
 /* ...buffer pool size for smart-cameras */
 #define IMR_POOL_SIZE                   2
 
+/* ...driver-monitor buffers owned by application (one in detector, one in renderer) */
+#define DM_LATEST_DEPTH                 2
+
+/* ...maximal depth of surround-view input queue */
+#define SV_INPUT_QUEUE_SIZE             3
+
+/* ...surround-view synchronization statistics reporting period (in frame-sets) */
+#define SV_SYNC_REPORT_PERIOD           256
+
+/* ...capacity of the rings passing processed buffers to the renderer */
+#define APP_RING_SIZE                   8
+
 /*******************************************************************************
  * Forward declarations
  ******************************************************************************/
@@ -131,12 +138,46 @@ extern int  __steps[];
 /* ...model file prefix */
 extern char * __model;
 
+/* ...surround-view frame-set synchronization tolerance (us) */
+extern int  __sv_sync_tolerance;
+
+/* ...VIN capture threads configuration */
+extern vin_thread_cfg_t __vin_threads[];
+extern int  __vin_threads_num;
+
+/* ...maximal VIN buffer pool depth for automatic growth (zero - disabled) */
+extern int  __vin_pool_max;
+
+/* ...per-consumer decimation / pacing configuration */
+extern app_rate_cfg_t   __app_rate[];
+
+/* ...renderer policy (non-zero - draw only the newest queued frames) */
+extern int  __render_latest;
+
+/* ...load-shedding controller configuration */
+extern app_shed_cfg_t   __app_shed;
+
+/* ...capture daemon connection (NULL - cameras are opened directly) */
+extern char *__vind_socket;
+extern int  __vind_ratio, __vind_depth;
+
 /* ...tbd */
 
 /*******************************************************************************
  * Local types definitions
  ******************************************************************************/
 
+/* ...camera topology entry (indexed by VIN device id) */
+typedef struct app_camera
+{
+    /* ...camera role and index within the role */
+    int                 role, index;
+
+    /* ...capture and correction devices names */
+    char               *vin, *imr;
+
+}   app_camera_t;
+
 /* ...smart-camera configuration */
 typedef struct sc_cfg
 {
@@ -151,6 +192,57 @@ typedef struct sc_cfg
 
 }   sc_cfg_t;
 
+/* ...consumer frame-rate controller */
+typedef struct app_pacer
+{
+    /* ...decimation ratio and input frames counter */
+    u32                 ratio, count;
+
+    /* ...minimal interval between passed frames (us; zero - no pacing) */
+    s64                 interval;
+
+    /* ...earliest time for the next frame to pass (us) */
+    s64                 next;
+
+    /* ...capture time of last decision and estimated input period (us) */
+    s64                 last, period;
+
+    /* ...last decision */
+    int                 pass;
+
+    /* ...number of passed / skipped frames */
+    u32                 passed, skipped;
+
+}   app_pacer_t;
+
+/* ...degradation ladder steps (applied in that order) */
+enum {
+    APP_SHED_DM_RATE,
+    APP_SHED_SC_RATE,
+    APP_SHED_VIEW_LOD,
+    APP_SHED_CAR,
+    APP_SHED_SV_RATE,
+    APP_SHED_STEPS,
+};
+
+/* ...load-shedding controller state */
+typedef struct app_shed
+{
+    /* ...current degradation level and ladder steps applied at each level */
+    int                 level, step[APP_SHED_STEPS];
+
+    /* ...consecutive over-budget / within-budget supervision periods */
+    int                 bad, good;
+
+    /* ...rendered frames counter latched at last supervision */
+    u32                 frames;
+
+    /* ...number of timed displayed frames, accumulated latency and stages durations (us) */
+    u32                 timed;
+    u64                 latency, stage[STAMP_NUMBER];
+
+}   app_shed_t;
+
 /* ...global application data */
 struct app_data
 {
@@ -175,39 +267,67 @@ struct app_data
     /* ...active sview mode */
     int                 sv_gpu_mode;
 
+    /* ...cameras topology */
+    app_camera_t       *cameras;
+
+    /* ...total number of cameras and number of cameras per role */
+    int                 cameras_num, sv_num, dm_num, sc_num;
+
     /* ...surround-view input buffers */
-    GQueue              sv_input[4], sv_output;
+    GQueue              sv_input[CAMERAS_NUMBER];
 
-    /* ...driver-monitor input buffers */
-    GQueue              dm_input[1], dm_output[1];
-    
-    /* ...smart-camera input/output buffers */
-    GQueue              sc_input[3], sc_output[3];
+    /* ...processed buffers passed to the renderer (single producer / single consumer) */
+    ring_t              sv_output, *dm_output, *sc_output;
+
+    /* ...surround-view inputs readiness flags */
+    u32                 sv_flags;
+
+    /* ...surround-view frame-set skew (last/maximal, in microseconds) */
+    u32                 sv_skew, sv_skew_max;
+
+    /* ...number of surround-view frame-sets consumed by the engine */
+    u32                 sv_sets;
+
+    /* ...frame-set at the heads of the queues has passed rate control */
+    int                 sv_admitted;
+
+    /* ...termination flag (no more input is accepted and no frames are rendered) */
+    int                 quit;
 
-    /* ...readiness flags */
-    u32                 sv_flags, dm_flags, sc_flags;
+    /* ...number of late / orphaned surround-view buffers dropped */
+    u32                 sv_dropped[CAMERAS_NUMBER];
+
+    /* ...consumers rate controllers */
+    app_pacer_t         sv_pacer, *dm_pacer, *sc_pacer;
+
+    /* ...number of stale frames skipped by the renderer */
+    u32                 sv_stale, *dm_stale, *sc_stale;
 
     /* ...texture output viewports */
-    texture_view_t      sv_view[4], dm_view[1][2], sc_view[3][2];
+    texture_view_t      sv_view[CAMERAS_NUMBER], (*dm_view)[2], (*sc_view)[2];
 
     /* ...cairo matrix for 2D-graphics */
-    cairo_matrix_t      dm_mat[1];
+    cairo_matrix_t     *dm_mat;
 
     /* ...IMR output buffers for smart-cameras and for driver-monitor (ugly - tbd) */
-    vsp_mem_t          *sc_mem[3][2], *dm_mem[6];
+    vsp_mem_t          *(*sc_mem)[2], *dm_mem[6];
 
     /* ...smart-camera configuration data */
-    sc_cfg_t            sc_cfg[3];
-
-    /* ...IMR engines configurations */
-    imr_cfg_t          *imr_cfg[IMR_NUMBER];
+    sc_cfg_t           *sc_cfg;
 
     /* ...data access lock */
     pthread_mutex_t     lock;
 
+    /* ...lock acquisitions, contended acquisitions and total waiting time (us) */
+    u32                 lock_acquired, lock_contended;
+    u64                 lock_wait;
+
     /* ...VIN engine handle */
     vin_data_t         *vin;
 
+    /* ...capture daemon client handle (replaces VIN engine if set) */
+    vin_client_t       *vind;
+
     /* ...IMR engine handle */
     imr_data_t         *imr;
 
@@ -217,9 +337,6 @@ struct app_data
     /* ...frame number */
     u32                 frame_num;
 
-    /* ...cameras mesh data */
-    mesh_data_t        *mesh[IMR_NUMBER];
-
     /* ...current focus item */
     int                 focus;
 
@@ -235,6 +352,21 @@ struct app_data
     /* ...focus revert / long-press detector timers */
     timer_source_t     *timer, *long_press_timer;
 
+    /* ...VIN buffer pools supervision timer */
+    timer_source_t     *pool_timer;
+
+    /* ...VIN starvation counters latched at last supervision */
+    u32                *vin_starved;
+
+    /* ...load-shedding supervision timer */
+    timer_source_t     *shed_timer;
+
+    /* ...run-time statistics reporting timer */
+    timer_source_t     *stats_timer;
+
+    /* ...load-shedding controller state */
+    app_shed_t          shed;
+
     /* ...last button pressing time */
     int                 spnav_long_press;
 };
@@ -243,49 +375,191 @@ struct app_data
  * Helpers
  ******************************************************************************/
 
-static inline int app_camera_is_sv(int i)
+static inline int app_camera_is_sv(app_data_t *app, int i)
 {
-    return i >= VIN_SV_LEFT && i <= VIN_SV_REAR;
+    return app->cameras[i].role == APP_CAMERA_SV;
 }
 
-static inline int app_sv_camera_index(int i)
+static inline int app_camera_is_dm(app_data_t *app, int i)
 {
-    return i - VIN_SV_LEFT;
+    return app->cameras[i].role == APP_CAMERA_DM;
 }
 
-static inline int app_camera_is_dm(int i)
+static inline int app_camera_is_sc(app_data_t *app, int i)
 {
-    return i == VIN_DM;
+    return app->cameras[i].role == APP_CAMERA_SC;
 }
 
-static inline int app_dm_camera_index(int i)
+/* ...index of the camera within its role */
+static inline int app_camera_index(app_data_t *app, int i)
 {
-    return i - VIN_DM;
+    return app->cameras[i].index;
 }
 
-static inline int app_camera_is_sc(int i)
+/* ...number of focusable items (surround-view scene, driver-monitors, smart-cameras) */
+static inline int app_focus_number(app_data_t *app)
 {
-    return i >= VIN_SC_LEFT && i <= VIN_SC_REAR;
+    return 1 + app->dm_num + app->sc_num;
 }
 
-static inline int app_sc_camera_index(int i)
+/* ...smart-camera index of the item in focus (negative if it is not a smart-camera) */
+static inline int app_focus_sc(app_data_t *app)
 {
-    return i - VIN_SC_LEFT;
+    return (app->focus > app->dm_num ? app->focus - 1 - app->dm_num : -1);
 }
 
 /*******************************************************************************
  * Helper functions
  ******************************************************************************/
 
+/* ...capture timestamp of the buffer in microseconds */
+static inline s64 app_buffer_ts(GstBuffer *buffer)
+{
+    return (s64)(GST_BUFFER_PTS(buffer) / 1000);
+}
+
+/* ...reset consumer rate controller */
+static void app_pacer_init(app_pacer_t *p, app_rate_cfg_t *cfg)
+{
+    memset(p, 0, sizeof(*p));
+    p->ratio = (cfg->ratio > 1 ? cfg->ratio : 1);
+    p->interval = (cfg->fps > 0 ? (s64)(1000000 / cfg->fps) : 0);
+}
+
+/* ...account timing of a frame that has reached the display (called with a lock held) */
+static void app_shed_account(app_data_t *app, const u32 *d, int latency)
+{
+    app_shed_t     *s = &app->shed;
+    int             k;
+
+    for (k = 0; k < STAMP_NUMBER; k++)
+    {
+        s->stage[k] += d[k];
+    }
+
+    s->latency += latency, s->timed++;
+}
+
+/* ...scale down consumer rate by an integer factor (counters are kept) */
+static void app_pacer_scale(app_pacer_t *p, app_rate_cfg_t *cfg, int k)
+{
+    p->ratio = (cfg->ratio > 1 ? cfg->ratio : 1) * k;
+    p->interval = (cfg->fps > 0 ? (s64)(1000000 / cfg->fps) * k : 0);
+}
+
+/* ...decide whether the frame captured at given time is passed to consumer */
+static int app_pacer_check(app_pacer_t *p, s64 ts)
+{
+    int     pass;
+
+    /* ...track input period to tolerate capture jitter */
+    (p->count && ts > p->last ? p->period = ts - p->last : 0);
+    p->last = ts;
+
+    /* ...apply decimation ratio */
+    pass = (p->count++ % p->ratio == 0);
+
+    /* ...make sure target rate is not exceeded */
+    if (pass && p->interval)
+    {
+        if (ts + p->period / 2 < p->next)
+        {
+            pass = 0;
+        }
+        else
+        {
+            /* ...keep the phase unless we are late by more than an interval */
+            p->next = (ts - p->next < p->interval ? p->next : ts) + p->interval;
+        }
+    }
+
+    (pass ? p->passed++ : p->skipped++);
+
+    return (p->pass = pass);
+}
+
+/* ...total number of stale frames of the cameras set */
+static inline u32 app_stale_total(u32 *stale, int n)
+{
+    u32     t = 0;
+
+    while (n--)     t += stale[n];
+
+    return t;
+}
+
+/* ...acquire application lock accounting contention */
+static inline void app_lock(app_data_t *app)
+{
+    u32     t0;
+
+    if (pthread_mutex_trylock(&app->lock) != 0)
+    {
+        t0 = __get_time_usec();
+        pthread_mutex_lock(&app->lock);
+        app->lock_contended++, app->lock_wait += (u32)(__get_time_usec() - t0);
+    }
+
+    app->lock_acquired++;
+}
+
+/* ...release application lock */
+static inline void app_unlock(app_data_t *app)
+{
+    pthread_mutex_unlock(&app->lock);
+}
+
+/* ...check if all buffers for the next frame are available (may be called without a lock) */
 static inline int app_frame_ready(app_data_t *app)
 {
+    int     i;
+
+    /* ...order publication of caller's own buffer against inspection of the other sources */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
     if (app->sv_gpu_mode)
     {
-        return (app->sv_flags | app->dm_flags | app->sc_flags) == 0;
+        if (__atomic_load_n(&app->sv_flags, __ATOMIC_RELAXED))      return 0;
+
+        for (i = 0; i < app->dm_num; i++)
+        {
+            if (ring_empty(&app->dm_output[i]))     return 0;
+        }
+
+        for (i = 0; i < app->sc_num; i++)
+        {
+            if (ring_empty(&app->sc_output[i]))     return 0;
+        }
+
+        return 1;
     }
     else
     {
-        return !g_queue_is_empty(&app->sv_output);
+        return !ring_empty(&app->sv_output);
+    }
+}
+
+/* ...release renderer rings storage */
+static void app_rings_destroy(app_data_t *app)
+{
+    int     i;
+
+    ring_destroy(&app->sv_output);
+    for (i = 0; i < app->dm_num; i++)     ring_destroy(&app->dm_output[i]);
+    for (i = 0; i < app->sc_num; i++)     ring_destroy(&app->sc_output[i]);
+}
+
+/* ...pass processed buffer to the renderer (called from the ring producer thread without a lock) */
+static inline void app_output_push(app_data_t *app, ring_t *ring, GstBuffer *buffer)
+{
+    if (ring_push(ring, gst_buffer_ref(buffer)) < 0)
+    {
+        TRACE(ERROR, _x("render ring overflow; drop buffer %p"), buffer);
+        gst_buffer_unref(buffer);
+    }
+    else if (app_frame_ready(app))
+    {
+        window_schedule_redraw(app->window);
     }
 }
 
@@ -300,25 +574,12 @@ static void imr_sv_ready(void *cdata, GstBuffer **buf)
 
     TRACE(DEBUG, _b("imr-sv-engine buffer ready"));
 
-    /* ...lock internal application data */
-    pthread_mutex_lock(&app->lock);
-
-    /* ...check if we still have IMR-mode */
+    /* ...check if we still have IMR-mode (stale buffer is dropped by renderer) */
     if (!app->sv_gpu_mode)
     {
-        GstBuffer  *buffer = imr_sview_buf_output(buf);
-
-        /* ...put buffer into rendering queue */
-        g_queue_push_tail(&app->sv_output, gst_buffer_ref(buffer));
-
-        /* ...all other buffers are just dropped - tbd */
-
-        /* ...rendering is available */
-        window_schedule_redraw(app->window);
+        /* ...put buffer into rendering ring; all other buffers are just dropped - tbd */
+        app_output_push(app, &app->sv_output, imr_sview_buf_output(buf));
     }
-
-    /* ...release application lock */
-    pthread_mutex_unlock(&app->lock);
 }
 
 /* ...engine processing callback */
@@ -326,18 +587,167 @@ static imr_sview_cb_t   imr_sv_callback = {
     .ready = imr_sv_ready,
 };
     
+/* ...take the frame to render from the ring (stale frames are released if newest-frame policy is active) */
+static inline GstBuffer * app_output_pop(ring_t *ring, u32 *stale, int vin)
+{
+    GstBuffer  *buffer = ring_pop(ring);
+    GstBuffer  *next;
+
+    while (__render_latest && buffer && (next = ring_pop(ring)) != NULL)
+    {
+        /* ...frame has not reached the display (only rings of raw VIN buffers are reported to capture engine) */
+        (vin ? vin_buffer_dropped(buffer) : (void)0);
+        gst_buffer_unref(buffer);
+        buffer = next, (*stale)++;
+    }
+
+    return buffer;
+}
+
 /*******************************************************************************
  * Surround view interface
  ******************************************************************************/
 
+/* ...drop the head of surround-view input queue */
+static inline void __sv_input_drop(app_data_t *app, int i)
+{
+    GstBuffer  *buffer = g_queue_pop_head(&app->sv_input[i]);
+
+    /* ...frame-set at the heads is changed */
+    app->sv_admitted = 0;
+
+    /* ...notify capture engine the frame has not been consumed */
+    vin_buffer_dropped(buffer);
+    gst_buffer_unref(buffer);
+
+    /* ...account dropped buffer */
+    app->sv_dropped[i]++;
+}
+
+/* ...take complete frame-set from the heads of surround-view queues (called with a lock held) */
+static inline void sv_input_pop(app_data_t *app, GstBuffer **buf)
+{
+    int     i;
+
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+    {
+        BUG(g_queue_is_empty(&app->sv_input[i]), _x("queue-%d is empty"), i);
+
+        buf[i] = g_queue_pop_head(&app->sv_input[i]);
+    }
+
+    /* ...next frame-set is subject to rate control */
+    app->sv_admitted = 0;
+}
+
+/* ...align heads of surround-view queues by capture time and apply rate control (called with a lock held) */
+static u32 sv_input_sync(app_data_t *app)
+{
+    s64     tolerance = __sv_sync_tolerance;
+    s64     t, t_min = 0, t_max = 0;
+    GstBuffer  *buf[CAMERAS_NUMBER];
+    u32     flags;
+    int     i, k = 0;
+
+    /* ...do not let the queues grow if some camera has stalled */
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+    {
+        while (g_queue_get_length(&app->sv_input[i]) > SV_INPUT_QUEUE_SIZE)
+        {
+            TRACE(DEBUG, _b("sv-%d: drop orphaned buffer"), i);
+            __sv_input_drop(app, i);
+        }
+    }
+
+    while (1)
+    {
+        /* ...update readiness flags */
+        for (flags = 0, i = 0; i < CAMERAS_NUMBER; i++)
+        {
+            (g_queue_is_empty(&app->sv_input[i]) ? flags |= (1 << i) : 0);
+        }
+
+        /* ...stop if some of the cameras has no buffer yet */
+        if (flags != 0)     break;
+
+        /* ...find oldest and newest buffers at the heads of the queues */
+        for (i = 0; i < CAMERAS_NUMBER; i++)
+        {
+            t = app_buffer_ts(g_queue_peek_head(&app->sv_input[i]));
+
+            (i == 0 || t < t_min ? t_min = t, k = i : 0);
+            (i == 0 || t > t_max ? t_max = t : 0);
+        }
+
+        /* ...frame-set is complete if all buffers are close enough (zero tolerance disables alignment) */
+        if (tolerance > 0 && t_max - t_min > tolerance)
+        {
+            /* ...oldest buffer cannot be matched anymore - it is too late; drop it */
+            TRACE(DEBUG, _b("sv-%d: drop late buffer (skew: %lld us)"), k, (long long)(t_max - t_min));
+
+            __sv_input_drop(app, k);
+            continue;
+        }
+
+        /* ...rate control decision is taken once per assembled frame-set */
+        if (app->sv_admitted || app_pacer_check(&app->sv_pacer, t_min))
+        {
+            app->sv_admitted = 1;
+            break;
+        }
+
+        /* ...frame-set is skipped by consumer rate control */
+        sv_input_pop(app, buf);
+
+        for (i = 0; i < CAMERAS_NUMBER; i++)
+        {
+            gst_buffer_unref(buf[i]);
+        }
+    }
+
+    /* ...publish readiness flags at once (they are inspected without a lock) */
+    return (app->sv_flags = flags);
+}
+
+/* ...account frame-set consumed by the surround-view engine (called with a lock held) */
+static void sv_input_account(app_data_t *app, GstBuffer **buf)
+{
+    s64     t, t_min = 0, t_max = 0;
+    int     i;
+
+    /* ...find capture time spread of the frame-set */
+    for (i = 0; i < CAMERAS_NUMBER; i++)
+    {
+        t = app_buffer_ts(buf[i]);
+
+        (i == 0 || t < t_min ? t_min = t : 0);
+        (i == 0 || t > t_max ? t_max = t : 0);
+    }
+
+    /* ...update skew statistics */
+    app->sv_skew = (u32)(t_max - t_min);
+    (app->sv_skew > app->sv_skew_max ? app->sv_skew_max = app->sv_skew : 0);
+
+    /* ...report statistics periodically */
+    if (++app->sv_sets % SV_SYNC_REPORT_PERIOD == 0)
+    {
+        TRACE(INFO, _b("sv-sync: sets=%u, skew=%u/%u us, dropped=%u/%u/%u/%u"),
+              app->sv_sets, app->sv_skew, app->sv_skew_max,
+              app->sv_dropped[0], app->sv_dropped[1], app->sv_dropped[2], app->sv_dropped[3]);
+
+        /* ...restart maximal skew tracking */
+        app->sv_skew_max = 0;
+    }
+}
+
 /* ...trigger processing of surround-view scene */
 static int sv_input_process(app_data_t *app, int i, GstBuffer *buffer)
 {
     /* ...collect buffers */
     g_queue_push_tail(&app->sv_input[i], gst_buffer_ref(buffer));
 
-    /* ...check if we have sufficient amount of buffers */
-    if ((app->sv_flags &= ~(1 << i)) == 0)
+    /* ...check if we have a complete time-aligned frame-set */
+    if (sv_input_sync(app) == 0)
     {
         /* ...check if IMR- or GPU-based engine is active */
         if (app->sv_gpu_mode)
@@ -350,22 +760,20 @@ static int sv_input_process(app_data_t *app, int i, GstBuffer *buffer)
         }
         else
         {
-            GstBuffer  *buf[4];
+            GstBuffer  *buf[CAMERAS_NUMBER];
             
             /* ...collect buffers from input queue (it is a common function) */
-            for (i = 0; i < 4; i++)
-            {
-                buf[i] = g_queue_pop_head(&app->sv_input[i]);
+            sv_input_pop(app, buf);
+            sv_input_account(app, buf);
 
-                /* ...update readiness flag */
-                (g_queue_is_empty(&app->sv_input[i]) ? app->sv_flags |= (1 << i) : 0);
-            }
+            /* ...update readiness flags */
+            sv_input_sync(app);
 
             /* ...submit buffers to the engine */
             CHK_API(imr_sview_submit(app->imr_sv, buf));
 
             /* ...release buffers ownership */
-            for (i = 0; i < 4; i++)
+            for (i = 0; i < CAMERAS_NUMBER; i++)
             {
                 gst_buffer_unref(buf[i]);
             }
@@ -393,6 +801,9 @@ static int dm_input_process(app_data_t *app, int i, GstBuffer *buffer)
         if (objdet_engine_push_buffer(app->dm, buffer, vmeta->plane[0], &ometa->info, &ometa->scene, texture->image, vmeta->format))
         {
             TRACE(ERROR, _x("dm-%d: failed to submit buffer"), i);
+
+            /* ...account pipeline-side drop */
+            vin_buffer_dropped(buffer);
         }
         else
         {
@@ -412,31 +823,16 @@ static void dm_buffer_ready(void *cdata, void *cookie, road_scene_t *scene)
     
     TRACE(DEBUG, _b("buffer returned from engine: %p"), buffer);
 
-    /* ...lock data access */
-    pthread_mutex_lock(&app->lock);
-
     /* ...drop buffer if we are in the IMR-mode */
     if (app->sv_gpu_mode)
     {
-        /* ...submit buffer to the ready queue */
-        g_queue_push_tail(&app->dm_output[i], gst_buffer_ref(buffer));
-
-        /* ...mark buffer queue is not empty */
-        if ((app->dm_flags &= ~(1 << i)) == 0)
-        {
-            if (app_frame_ready(app))
-            {
-                window_schedule_redraw(app->window);
-            }
-        }
+        /* ...submit buffer to the ready ring */
+        app_output_push(app, &app->dm_output[i], buffer);
     }
     else
     {
         TRACE(DEBUG, _b("dm-%d: drop detector output"), i);
     }
-
-    /* ...unlock data access */
-    pthread_mutex_unlock(&app->lock);
 }
 
 /* ...buffer retirement hook */
@@ -500,7 +896,7 @@ static int imr_buffer_allocate(void *cdata, int i, GstBuffer *buffer)
     int             j = meta->index;
     void           *planes[3] = { NULL, };
 
-    if (i < IMR_DM)
+    if (i < app->sc_num)
     {
         /* ...sanity check */
         BUG((u32)j >= (u32)2, _x("imr-%d: invalid buffer index: %d"), i, j);
@@ -556,29 +952,16 @@ static int imr_buffer_process(void *cdata, int i, GstBuffer *buffer)
     TRACE(DEBUG, _b("imr-buffer <%d:%d> ready"), i, meta->index);
 
     /* ...sanity check */
-    CHK_ERR((u32)i < (u32)IMR_NUMBER, -(errno = EINVAL));
-
-    /* ...lock application data */
-    pthread_mutex_lock(&app->lock);
+    CHK_ERR((u32)i < (u32)app->sc_num, -(errno = EINVAL));
 
     /* ...processing is enabled only in the GPU-mode */
     if (app->sv_gpu_mode)
     {
         /* ...check buffer type */
-        if (i < IMR_DM)
+        if (i < app->sc_num)
         {
-            /* ...smart-camera interface; put buffer into rendering queue */
-            g_queue_push_tail(&app->sc_output[i], gst_buffer_ref(buffer));
-    
-            /* ...clear flag */
-            if ((app->sc_flags &= ~(1 << i)) == 0)
-            {
-                /* ...schedule rendering if possible */
-                if (app_frame_ready(app))
-                {
-                    window_schedule_redraw(app->window);
-                }
-            }
+            /* ...smart-camera interface; put buffer into rendering ring */
+            app_output_push(app, &app->sc_output[i], buffer);
         }
         else
         {
@@ -591,7 +974,7 @@ static int imr_buffer_process(void *cdata, int i, GstBuffer *buffer)
             /* ...driver-monitor interface; pass buffer to the object detection engine */
             if (objdet_engine_push_buffer(app->dm, buffer, vsp_mem_ptr(mem), &ometa->info, &ometa->scene, texture->image, meta->format))
             {
-                TRACE(ERROR, _x("dm-%d: failed to submit buffer"), i - IMR_DM);
+                TRACE(ERROR, _x("dm-%d: failed to submit buffer"), i - app->sc_num);
             }
             else
             {
@@ -599,9 +982,6 @@ static int imr_buffer_process(void *cdata, int i, GstBuffer *buffer)
             }
         }
     }
-    
-    /* ...release application lock */
-    pthread_mutex_unlock(&app->lock);
 
     return 0;
 }
@@ -636,12 +1016,12 @@ static int app_input_alloc(void *data, int i, GstBuffer *buffer)
     vsink_meta_t   *vmeta = gst_buffer_get_vsink_meta(buffer);
     int             w = vmeta->width, h = vmeta->height;
 
-    if (i >= VIN_SV_LEFT && i <= VIN_SV_REAR)
+    if (app_camera_is_sv(app, i))
     {
         /* ...initialize surround-view application as needed - tbd */
         BUG(w != 1280 || h != 1080, _x("camera-%d: invalid buffer dimensions: %d*%d"), i, w, h);
     }
-    else if (i == VIN_DM)
+    else if (app_camera_is_dm(app, i))
     {
         objdet_meta_t  *ometa;
 
@@ -652,7 +1032,7 @@ static int app_input_alloc(void *data, int i, GstBuffer *buffer)
         CHK_ERR(ometa = gst_buffer_add_objdet_meta(buffer), -errno);
         GST_META_FLAG_SET(ometa, GST_META_FLAG_POOLED);
     }
-    else if (i >= VIN_SC_LEFT && i <= VIN_SC_REAR)
+    else if (app_camera_is_sc(app, i))
     {
         /* ...initialize smart-camera library */
         /* BUG(w != 1280 || h != 1080, _x("camera-%d: invalid buffer dimensions: %d*%d"), i, w, h); */
@@ -675,31 +1055,39 @@ static int app_input_process(void *data, int i, GstBuffer *buffer)
 {
     app_data_t     *app = data;
     vsink_meta_t   *vmeta = gst_buffer_get_vsink_meta(buffer);
-    int             r;
+    s64             ts = app_buffer_ts(buffer);
+    int             r, j;
 
     TRACE(DEBUG, _b("camera-%d: input buffer received"), i);
 
     /* ...make sure camera index is valid */
-    CHK_ERR(i >= 0 && i < VIN_NUMBER, -EINVAL);
+    CHK_ERR(i >= 0 && i < app->cameras_num, -EINVAL);
 
     /* ...make sure buffer dimensions are valid */
     CHK_ERR(vmeta, -EINVAL);
 
     /* ...lock access to the internal queue */
-    pthread_mutex_lock(&app->lock);
+    app_lock(app);
 
-    /* ...pass buffer to particular receiver */
-    if (app_camera_is_sv(i))
+    /* ...pass buffer to particular receiver unless consumer rate control skips it */
+    if (app->quit)
     {
-        r = sv_input_process(app, app_sv_camera_index(i), buffer);
+        r = 0;
     }
-    else if (app_camera_is_dm(i))
+    else if (app_camera_is_sv(app, i))
     {
-        r = dm_input_process(app, app_dm_camera_index(i), buffer);
+        j = app_camera_index(app, i);
+        r = sv_input_process(app, j, buffer);
     }
-    else if (app_camera_is_sc(i))
+    else if (app_camera_is_dm(app, i))
     {
-        r = sc_input_process(app, app_sc_camera_index(i), buffer);
+        j = app_camera_index(app, i);
+        r = (app_pacer_check(&app->dm_pacer[j], ts) ? dm_input_process(app, j, buffer) : 0);
+    }
+    else if (app_camera_is_sc(app, i))
+    {
+        j = app_camera_index(app, i);
+        r = (app_pacer_check(&app->sc_pacer[j], ts) ? sc_input_process(app, j, buffer) : 0);
     }
     else
     {
@@ -708,7 +1096,7 @@ static int app_input_process(void *data, int i, GstBuffer *buffer)
     }
 
     /* ...unlock internal data */
-    pthread_mutex_unlock(&app->lock);
+    app_unlock(app);
 
     return r;
 }
@@ -896,96 +1284,123 @@ static void app_redraw(display_data_t *display, void *data)
     int             h = window_get_height(window);
 
     /* ...lock internal data */
-    pthread_mutex_lock(&app->lock);
+    app_lock(app);
 
-    while (app_frame_ready(app))
+    while (!app->quit && app_frame_ready(app))
     {
         float       fps = window_frame_rate_update(window);
         cairo_t    *cr = NULL;
-        GstBuffer  *sv_buffer[4] = { NULL }, *dm_buffer[1] = { NULL }, *sc_buffer[3] = { NULL };
+        GstBuffer  *sv_buffer[CAMERAS_NUMBER] = { NULL }, *dm_buffer[DM_CAMERAS_MAX] = { NULL }, *sc_buffer[SC_CAMERAS_MAX] = { NULL };
         GstBuffer  *sv_output = NULL;
+        GstBuffer  *shown[CAMERAS_NUMBER + DM_CAMERAS_MAX + SC_CAMERAS_MAX];
+        int         shown_num = 0;
+        u32         d[STAMP_NUMBER], stage[STAMP_NUMBER];
+        int         l, latency = -1;
         int         i;
         int         sv_gpu_mode = app->sv_gpu_mode;
         
         if (sv_gpu_mode)
         {
-            /* ...get the buffers from the head of corresponding queue */
-            for (i = 0; i < 4; i++)
+            /* ...get the buffers from the head of corresponding queue (if surround-view is present) */
+            if (app->sv_num)
+            {
+                sv_input_pop(app, sv_buffer);
+            }
+
+            /* ...re-align remaining surround-view buffers and update readiness flags */
+            (app->sv_num ? sv_input_sync(app) : 0);
+
+            /* ...skip to the newest complete frame-set if requested */
+            while (__render_latest && app->sv_num && app->sv_flags == 0)
             {
-                BUG(g_queue_is_empty(&app->sv_input[i]), _x("queue-%d is empty"), i);
+                for (i = 0; i < app->sv_num; i++)
+                {
+                    vin_buffer_dropped(sv_buffer[i]);
+                    gst_buffer_unref(sv_buffer[i]);
+                }
 
-                /* ...get the head of the queue */
-                sv_buffer[i] = g_queue_pop_head(&app->sv_input[i]);
+                sv_input_pop(app, sv_buffer);
+
+                sv_input_sync(app);
+                app->sv_stale++;
+            }
 
-                /* ...update readiness flag */
-                (g_queue_is_empty(&app->sv_input[i]) ? app->sv_flags |= (1 << i) : 0);
+            /* ...account frame-set passed to the renderer */
+            if (app->sv_num)
+            {
+                sv_input_account(app, sv_buffer);
             }
 
             /* ....get the driver monitor buffer */
-            for (i = 0; i < 1; i++)
+            for (i = 0; i < app->dm_num; i++)
             {
-                BUG(g_queue_is_empty(&app->dm_output[i]), _x("queue-%d is empty"), i);
-            
-                /* ...get the head of the queue */
-                dm_buffer[i] = g_queue_pop_head(&app->dm_output[i]);
+                /* ...get the head (or the newest entry) of the ring */
+                dm_buffer[i] = app_output_pop(&app->dm_output[i], &app->dm_stale[i], 1);
 
-                /* ...update readiness flag */
-                (g_queue_is_empty(&app->dm_output[i]) ? app->dm_flags |= (1 << i) : 0);
+                BUG(!dm_buffer[i], _x("ring-%d is empty"), i);
             }
 
             /* ...get the smart-camera buffer */
-            for (i = 0; i < 3; i++)
+            for (i = 0; i < app->sc_num; i++)
             {
-                BUG(g_queue_is_empty(&app->sc_output[i]), _x("queue-%d is empty"), i);
+                /* ...get the head (or the newest entry) of the ring */
+                sc_buffer[i] = app_output_pop(&app->sc_output[i], &app->sc_stale[i], 0);
 
-                /* ...get the head of the queue */
-                sc_buffer[i] = g_queue_pop_head(&app->sc_output[i]);
-
-                /* ...update readiness flag */
-                (g_queue_is_empty(&app->sc_output[i]) ? app->sc_flags |= (1 << i) : 0);
+                BUG(!sc_buffer[i], _x("ring-%d is empty"), i);
             }
 
             /* ...drop all pending IMR-SV buffers as needed */
-            while (!g_queue_is_empty(&app->sv_output))
+            while ((sv_output = ring_pop(&app->sv_output)) != NULL)
             {
-                gst_buffer_unref(g_queue_pop_head(&app->sv_output));
+                gst_buffer_unref(sv_output);
             }
         }
         else
         {
-            /* ...output queue must not be empty */
-            BUG(g_queue_is_empty(&app->sv_output), _x("sv-output-queue is empty"));
+            GstBuffer  *buffer;
+
+            /* ...get the buffer from head (or the newest entry) of the ready ring */
+            sv_output = app_output_pop(&app->sv_output, &app->sv_stale, 0);
 
-            /* ...get the buffer from head of the ready queue */
-            sv_output = g_queue_pop_head(&app->sv_output);
+            /* ...output ring must not be empty */
+            BUG(!sv_output, _x("sv-output-ring is empty"));
 
             /* ...drop all pending driver monitor buffers */
-            for (i = 0; i < 1; i++)
+            for (i = 0; i < app->dm_num; i++)
             {
-                while (!g_queue_is_empty(&app->dm_output[i]))
+                while ((buffer = ring_pop(&app->dm_output[i])) != NULL)
                 {
-                    gst_buffer_unref(g_queue_pop_head(&app->dm_output[i]));
+                    gst_buffer_unref(buffer);
                 }
-                
-                /* ...update readiness flag */
-                app->dm_flags |= (1 << i);
             }
 
             /* ...drop all pending smart-camera buffers */
-            for (i = 0; i < 3; i++)
+            for (i = 0; i < app->sc_num; i++)
             {
-                while (!g_queue_is_empty(&app->sc_output[i]))
+                while ((buffer = ring_pop(&app->sc_output[i])) != NULL)
                 {
-                    gst_buffer_unref(g_queue_pop_head(&app->sc_output[i]));
+                    gst_buffer_unref(buffer);
                 }
-                
-                /* ...update readiness flag */
-                app->sc_flags |= (1 << i);
             }
         }
 
         /* ...release the lock */
-        pthread_mutex_unlock(&app->lock);
+        app_unlock(app);
+
+        /* ...collect the buffers composing the frame */
+        if (sv_gpu_mode)
+        {
+            for (i = 0; i < app->sv_num; i++)     shown[shown_num++] = sv_buffer[i];
+            for (i = 0; i < app->dm_num; i++)     shown[shown_num++] = dm_buffer[i];
+            for (i = 0; i < app->sc_num; i++)     shown[shown_num++] = sc_buffer[i];
+        }
+        else
+        {
+            shown[shown_num++] = sv_output;
+        }
+
+        /* ...mark frames entering the renderer */
+        for (i = 0; i < shown_num; i++)     stamp_buffer(shown[i], STAMP_REDRAW);
 
 	cr = window_get_cairo(window);
         /* ...add some performance monitors here - tbd */
@@ -997,7 +1412,7 @@ static void app_redraw(display_data_t *display, void *data)
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT | GL_STENCIL_BUFFER_BIT);
 
         /* ...process surround-view frames */
-        if (sv_gpu_mode)
+        if (sv_gpu_mode && app->sv_num)
         {
             GLuint              tex[4];
             void               *plane[4];
@@ -1067,7 +1482,7 @@ static void app_redraw(display_data_t *display, void *data)
             /* ...save current cairo context */
             cairo_save(cr);
 
-            for (i = 0; i < 1; i++)
+            for (i = 0; i < app->dm_num; i++)
             {
                 vsink_meta_t     *vmeta = gst_buffer_get_vsink_meta(dm_buffer[i]);
                 objdet_meta_t  *ometa = gst_buffer_get_objdet_meta(dm_buffer[i]);
@@ -1130,21 +1545,21 @@ static void app_redraw(display_data_t *display, void *data)
         /* ...process smart-cameras */
         if (sv_gpu_mode)
         {
-            for (i = 0; i < 3; i++)
+            for (i = 0; i < app->sc_num; i++)
             {
                 imr_meta_t         *meta = gst_buffer_get_imr_meta(sc_buffer[i]);
                 texture_view_t     *v = &app->sc_view[i][0];
                 texture_view_t     *b = &app->sc_view[i][1];
                 u32                 c0, c1;
                 float               s;
-                u32                 mask = 1 << (i + 1);
+                u32                 mask = 1 << (app->dm_num + i);
                 float               alpha;
                 
                 /* ...flush surface state before switching to native rendering */
                 cairo_surface_flush(cairo_get_target(cr));
 
                 /* ...select color and transparency depending on current focus and fading level */
-                if (app->focus == i + 2)
+                if (app_focus_sc(app) == i)
                 {
                     /* ...corder gradient gradually fades away */
                     c0 = __app_cfg.sc_active_border.c0 + (u32)(0xFF * app->alpha);
@@ -1208,6 +1623,20 @@ static void app_redraw(display_data_t *display, void *data)
         
         /* ...submit window to composer */
         window_draw(window);
+        recorder_event(REC_RENDER, sv_gpu_mode, app->frame_num);
+
+        /* ...mark displayed frames and export their timing */
+        for (i = 0; i < shown_num; i++)
+        {
+            stamp_buffer(shown[i], STAMP_DISPLAY);
+            stamp_trace_frame(shown[i]);
+
+            /* ...frame latency is the one of its slowest component */
+            if ((l = stamp_latency(shown[i], d)) > latency)
+            {
+                latency = l, memcpy(stage, d, sizeof(stage));
+            }
+        }
 
         /* ...make sure the pipeline is processed fully before dropping the buffers */
         glFinish();
@@ -1215,13 +1644,13 @@ static void app_redraw(display_data_t *display, void *data)
         if (sv_gpu_mode)
         {
             /* ...drop surround-view buffers */
-            for (i = 0; i < 4; i++)     gst_buffer_unref(sv_buffer[i]);
+            for (i = 0; i < app->sv_num; i++)     gst_buffer_unref(sv_buffer[i]);
 
             /* ...drop driver monitor buffers */
-            for (i = 0; i < 1; i++)     gst_buffer_unref(dm_buffer[i]);
+            for (i = 0; i < app->dm_num; i++)     gst_buffer_unref(dm_buffer[i]);
 
             /* ...drop smart-camera buffers */
-            for (i = 0; i < 3; i++)     gst_buffer_unref(sc_buffer[i]);
+            for (i = 0; i < app->sc_num; i++)     gst_buffer_unref(sc_buffer[i]);
         }
         else
         {
@@ -1230,11 +1659,14 @@ static void app_redraw(display_data_t *display, void *data)
         }
 
         /* ...lock internal data access */
-        pthread_mutex_lock(&app->lock);
+        app_lock(app);
+
+        /* ...pass frame timing to load-shedding controller */
+        if (latency >= 0)   app_shed_account(app, stage, latency);
     }
 
     /* ...release processing lock */
-    pthread_mutex_unlock(&app->lock);
+    app_unlock(app);
 
     TRACE(DEBUG, _b("drawing completed"));
 }
@@ -1521,6 +1953,8 @@ static void __focus_switch(app_data_t *app, int focus)
 {
     timer_source_t     *timer = app->timer;
 
+    recorder_event(REC_VIEW_CHANGE, 0, focus);
+
     if ((app->focus = focus) == 0)
     {
         /* ...stop pending timer if running */
@@ -1542,7 +1976,7 @@ static gboolean focus_timeout(void *data)
     app_data_t     *app = data;
 
     /* ...get application access lock */
-    pthread_mutex_lock(&app->lock);
+    app_lock(app);
 
     /* ...processing is active only in SV-based mode */
     if (app->sv_gpu_mode)
@@ -1555,7 +1989,7 @@ static gboolean focus_timeout(void *data)
     timer_source_stop(app->timer);
 
     /* ...release application lock */
-    pthread_mutex_unlock(&app->lock);
+    app_unlock(app);
 
     /* ...source should not be deleted */
     return TRUE;
@@ -1570,7 +2004,7 @@ static gboolean long_press_timeout(void *data)
     app_data_t     *app = data;
 
     /* ...get application access lock */
-    pthread_mutex_lock(&app->lock);
+    app_lock(app);
 
     /* ...processing is active only in SV-based mode */
     if (app->sv_gpu_mode)
@@ -1591,7 +2025,290 @@ static gboolean long_press_timeout(void *data)
     }
 
     /* ...release application lock */
-    pthread_mutex_unlock(&app->lock);
+    app_unlock(app);
+
+    /* ...source should not be deleted */
+    return TRUE;
+}
+
+/*******************************************************************************
+ * Capture devices
+ ******************************************************************************/
+
+/* ...open cameras (directly or through the capture daemon) */
+static int app_vin_init(app_data_t *app, char **name)
+{
+    if (__vind_socket)
+    {
+        CHK_ERR(app->vind = vin_client_init(__vind_socket, name, app->cameras_num, &vin_cb, app), -errno);
+    }
+    else
+    {
+        CHK_ERR(app->vin = vin_init(name, app->cameras_num, &vin_cb, app), -errno);
+    }
+
+    return 0;
+}
+
+/* ...set up camera format; daemon-owned pool is shared, so only a frames quota is requested */
+static int app_vin_device_init(app_data_t *app, int i, int w, int h, u32 fmt, int size)
+{
+    if (app->vind)
+    {
+        return vin_client_subscribe(app->vind, i, w, h, fmt, __vind_ratio, __vind_depth);
+    }
+    else
+    {
+        return vin_device_init(app->vin, i, w, h, fmt, size);
+    }
+}
+
+/* ...start frames delivery */
+static int app_vin_start(app_data_t *app)
+{
+    return (app->vind ? vin_client_start(app->vind) : vin_start(app->vin));
+}
+
+/*******************************************************************************
+ * Run-time statistics reporting
+ ******************************************************************************/
+
+/* ...statistics reporting period (ms) */
+#define APP_STATS_PERIOD            (5000)
+
+/* ...report renderer and application lock statistics (independent of active consumers) */
+static gboolean stats_timeout(void *data)
+{
+    app_data_t     *app = data;
+    u32             acquired, contended, sv, dm, sc;
+    u64             wait;
+
+    /* ...take a consistent snapshot */
+    app_lock(app);
+    acquired = app->lock_acquired, contended = app->lock_contended, wait = app->lock_wait;
+    sv = app->sv_stale, dm = app_stale_total(app->dm_stale, app->dm_num), sc = app_stale_total(app->sc_stale, app->sc_num);
+    app_unlock(app);
+
+    TRACE(INFO, _b("render-stale: sv=%u, dm=%u, sc=%u"), sv, dm, sc);
+    TRACE(INFO, _b("app-lock: acquired=%u, contended=%u, wait=%llu us"), acquired, contended, (unsigned long long)wait);
+
+    /* ...source should not be deleted */
+    return TRUE;
+}
+
+/*******************************************************************************
+ * VIN buffer pools supervision
+ ******************************************************************************/
+
+/* ...pools supervision period (ms) */
+#define VIN_POOL_CHECK_PERIOD       (1000)
+
+/* ...grow buffer pool of the cameras that have been starving */
+static gboolean pool_timeout(void *data)
+{
+    app_data_t     *app = data;
+    vin_stats_t     stats;
+    int             i;
+
+    /* ...application lock is not taken - resizing waits for buffers held by renderer */
+    for (i = 0; i < app->cameras_num; i++)
+    {
+        if (vin_device_get_stats(app->vin, i, &stats) < 0)      continue;
+
+        /* ...skip camera if driver has not been starving since last check */
+        if (stats.starved == app->vin_starved[i])               continue;
+
+        /* ...latch starvation counter */
+        app->vin_starved[i] = stats.starved;
+
+        /* ...add one more buffer to the pool if allowed */
+        if ((int)stats.pool < __vin_pool_max)
+        {
+            TRACE(INFO, _b("camera-%d: starving (%u) - grow pool to %u"), i, stats.starved, stats.pool + 1);
+            vin_device_resize(app->vin, i, stats.pool + 1);
+        }
+    }
+
+    /* ...source should not be deleted */
+    return TRUE;
+}
+
+/*******************************************************************************
+ * Load shedding
+ ******************************************************************************/
+
+/* ...supervision period (ms) */
+#define APP_SHED_PERIOD             (1000)
+
+/* ...fraction of latency budget the pipeline shall fit into to step back up */
+#define APP_SHED_HEADROOM           (0.8)
+
+/* ...ladder steps names */
+static const char * __shed_names[APP_SHED_STEPS] = {
+    [APP_SHED_DM_RATE] = "driver-monitor rate",
+    [APP_SHED_SC_RATE] = "smart-cameras rate",
+    [APP_SHED_VIEW_LOD] = "view quantization",
+    [APP_SHED_CAR] = "car model",
+    [APP_SHED_SV_RATE] = "surround-view rate",
+};
+
+/* ...check if controller is enabled */
+static inline int app_shed_enabled(void)
+{
+    return __app_shed.fps > 0 || __app_shed.latency > 0;
+}
+
+/* ...check if ladder step affects active consumers (called with a lock held) */
+static int app_shed_available(app_data_t *app, int step)
+{
+    switch (step)
+    {
+    case APP_SHED_DM_RATE:      return app->dm_num > 0;
+    case APP_SHED_SC_RATE:      return app->sc_num > 0;
+    case APP_SHED_VIEW_LOD:
+    case APP_SHED_CAR:          return app->imr_sv && !app->sv_gpu_mode;
+    case APP_SHED_SV_RATE:      return app->sv_num > 0;
+    default:                    return 0;
+    }
+}
+
+/* ...apply or revert ladder step (called with a lock held) */
+static void app_shed_apply(app_data_t *app, int step, int on)
+{
+    int     i, k = (on ? 2 : 1);
+
+    switch (step)
+    {
+    case APP_SHED_DM_RATE:
+        for (i = 0; i < app->dm_num; i++)   app_pacer_scale(&app->dm_pacer[i], &__app_rate[APP_RATE_DM], k);
+        break;
+
+    case APP_SHED_SC_RATE:
+        for (i = 0; i < app->sc_num; i++)   app_pacer_scale(&app->sc_pacer[i], &__app_rate[APP_RATE_SC], k);
+        break;
+
+    case APP_SHED_VIEW_LOD:
+        /* ...halve the number of distinct views (fewer mesh recompilations and car images decoding) */
+        (imr_sview_set_lod(app->imr_sv, on) < 0 ? TRACE(ERROR, _x("failed to set view quantization: %m")) : 0);
+        break;
+
+    case APP_SHED_CAR:
+        (imr_sview_set_car(app->imr_sv, !on) < 0 ? TRACE(ERROR, _x("failed to switch car model: %m")) : 0);
+        break;
+
+    case APP_SHED_SV_RATE:
+        /* ...output buffers are allocated once; halve the composition rate instead of the resolution */
+        app_pacer_scale(&app->sv_pacer, &__app_rate[APP_RATE_SV], k);
+        break;
+    }
+}
+
+/* ...rendering rate expected with applied ladder steps (called with a lock held) */
+static float app_shed_fps(app_data_t *app, float fps)
+{
+    app_shed_t     *s = &app->shed;
+    int             i, gated = 0;
+
+    /* ...renderer waits for every source in GPU mode and for surround-view output otherwise */
+    for (i = 0; i < s->level; i++)
+    {
+        switch (s->step[i])
+        {
+        case APP_SHED_DM_RATE:
+        case APP_SHED_SC_RATE:  gated |= app->sv_gpu_mode;     break;
+        case APP_SHED_SV_RATE:  gated = 1;                      break;
+        }
+    }
+
+    /* ...each rate step halves its sources; renderer follows the slowest of them */
+    return (gated ? fps / 2 : fps);
+}
+
+/* ...step degradation ladder down or up depending on the budgets compliance */
+static gboolean shed_timeout(void *data)
+{
+    app_data_t     *app = data;
+    app_shed_t     *s = &app->shed;
+    app_shed_cfg_t *cfg = &__app_shed;
+    char            reason[128];
+    float           fps, target;
+    u32             latency = 0;
+    int             k, worst = STAMP_VIN, over;
+
+    app_lock(app);
+
+    /* ...calculate rendering rate and average latency over the period */
+    fps = (app->frame_num - s->frames) * 1000.0 / APP_SHED_PERIOD;
+    s->frames = app->frame_num;
+
+    if (s->timed)
+    {
+        latency = (u32)(s->latency / s->timed);
+
+        /* ...find the stage contributing most of the latency */
+        for (k = STAMP_VIN; k < STAMP_NUMBER; k++)
+        {
+            (s->stage[k] > s->stage[worst] ? worst = k : 0);
+        }
+    }
+
+    /* ...frame rate budget accounts for decimation applied by the controller itself */
+    target = app_shed_fps(app, cfg->fps);
+
+    /* ...check the budgets; keep the level if latency fits but without headroom */
+    if (cfg->fps > 0 && fps < target)
+    {
+        snprintf(reason, sizeof(reason), "frame rate %.1f below %.1f fps", fps, target);
+        over = 1;
+    }
+    else if (cfg->latency && latency > cfg->latency)
+    {
+        snprintf(reason, sizeof(reason), "latency %u us above %u us (slowest stage '%s': %u us)",
+                 latency, cfg->latency, stamp_stage_name(worst), (u32)(s->stage[worst] / s->timed));
+        over = 1;
+    }
+    else if (cfg->latency && latency > cfg->latency * APP_SHED_HEADROOM)
+    {
+        over = -1;
+    }
+    else
+    {
+        snprintf(reason, sizeof(reason), "frame rate %.1f fps, latency %u us within budget for %d periods", fps, latency, cfg->up);
+        over = 0;
+    }
+
+    /* ...restart accumulation */
+    s->timed = 0, s->latency = 0;
+    memset(s->stage, 0, sizeof(s->stage));
+
+    /* ...update hysteresis counters */
+    s->bad = (over > 0 ? s->bad + 1 : 0);
+    s->good = (over == 0 ? s->good + 1 : 0);
+
+    if (s->bad >= cfg->down)
+    {
+        /* ...find next ladder step affecting active consumers */
+        for (k = (s->level ? s->step[s->level - 1] + 1 : 0); k < APP_SHED_STEPS && !app_shed_available(app, k); k++)
+            ;
+
+        if (k < APP_SHED_STEPS)
+        {
+            TRACE(INFO, _b("load shedding: level %d - reduce %s: %s"), s->level + 1, __shed_names[k], reason);
+            app_shed_apply(app, s->step[s->level++] = k, 1);
+        }
+
+        s->bad = 0;
+    }
+    else if (s->good >= cfg->up && s->level > 0)
+    {
+        k = s->step[--s->level];
+        TRACE(INFO, _b("load shedding: level %d - restore %s: %s"), s->level, __shed_names[k], reason);
+        app_shed_apply(app, k, 0);
+
+        s->good = 0;
+    }
+
+    app_unlock(app);
 
     /* ...source should not be deleted */
     return TRUE;
@@ -1606,7 +2323,7 @@ static inline widget_data_t * app_spnav_event(app_data_t *app, widget_data_t *wi
 {
     spnav_event    *e = event->e;
 
-    pthread_mutex_lock(&app->lock);
+    app_lock(app);
 
     /* ...process switch between modes */
     if (e->type == SPNAV_EVENT_BUTTON && e->button.press == 1)
@@ -1619,7 +2336,7 @@ static inline widget_data_t * app_spnav_event(app_data_t *app, widget_data_t *wi
                 timer_source_stop(app->timer);
 
                 /* ...left button pressed */
-                if (app->focus == 0)
+                if (app->focus == 0 && app->imr_sv)
                 {
                     /* ...switch to IMR mode */
                     app->sv_gpu_mode = 0;
@@ -1627,10 +2344,10 @@ static inline widget_data_t * app_spnav_event(app_data_t *app, widget_data_t *wi
                     /* ...reset carousel menu parameters */
                     (app->imr_menu ? carousel_reset(app->imr_menu) : 0);
                 }
-                else if (app->focus > 1)
+                else if (app_focus_sc(app) >= 0)
                 {
                     /* ...reset active smart-camera state */
-                    __sc_mesh_reset(app, app->focus - 2);
+                    __sc_mesh_reset(app, app_focus_sc(app));
                 }
             }
             else
@@ -1679,12 +2396,12 @@ static inline widget_data_t * app_spnav_event(app_data_t *app, widget_data_t *wi
                     timer_source_stop(app->long_press_timer);
 
                     /* ...switch the focus */
-                    __focus_switch(app, (++app->focus == 5 ? app->focus = 0 : app->focus));
+                    __focus_switch(app, (++app->focus == app_focus_number(app) ? app->focus = 0 : app->focus));
                 }
                 else if (app->focus == 0)
                 {
                     /* ...ignore event as we toggled the focus */
-                    __focus_switch(app, (++app->focus == 5 ? app->focus = 0 : app->focus));
+                    __focus_switch(app, (++app->focus == app_focus_number(app) ? app->focus = 0 : app->focus));
                 }
             }
         }
@@ -1696,7 +2413,7 @@ static inline widget_data_t * app_spnav_event(app_data_t *app, widget_data_t *wi
             if (app->focus == 0)
             {
                 /* ...pass event to surround-view app */
-                sview_engine_spnav_event(app->sv, e);
+                (app->sv ? sview_engine_spnav_event(app->sv, e) : 0);
             }
             else
             {
@@ -1704,9 +2421,9 @@ static inline widget_data_t * app_spnav_event(app_data_t *app, widget_data_t *wi
                 timer_source_start(app->timer, FOCUS_REVERT_TIMEOUT, 0);
 
                 /* ...pass event to smart-camera object */
-                if (app->focus >= 2)
+                if (app_focus_sc(app) >= 0)
                 {
-                    sc_spnav_event(app, app->focus - 2, event);
+                    sc_spnav_event(app, app_focus_sc(app), event);
                 }
             }
         }
@@ -1726,7 +2443,7 @@ static inline widget_data_t * app_spnav_event(app_data_t *app, widget_data_t *wi
     }
 
     /* ...release application lock */
-    pthread_mutex_unlock(&app->lock);
+    app_unlock(app);
 
     return widget;
 }
@@ -1734,9 +2451,10 @@ static inline widget_data_t * app_spnav_event(app_data_t *app, widget_data_t *wi
 /* ...touch-screen event processing */
 static inline widget_data_t * app_touch_event(app_data_t *app, widget_data_t *widget, widget_touch_event_t *event)
 {
-    pthread_mutex_lock(&app->lock);
+    app_lock(app);
 
-    switch (event->type)
+    /* ...touch-screen controls surround-view scene only */
+    switch (app->sv ? event->type : -1)
     {
     case WIDGET_EVENT_TOUCH_DOWN:
         sview_engine_touch(app->sv, TOUCH_DOWN, event->id, event->x, event->y);
@@ -1751,7 +2469,7 @@ static inline widget_data_t * app_touch_event(app_data_t *app, widget_data_t *wi
         break;
     }
 
-    pthread_mutex_unlock(&app->lock);
+    app_unlock(app);
     
     return widget;
 }
@@ -1759,7 +2477,7 @@ static inline widget_data_t * app_touch_event(app_data_t *app, widget_data_t *wi
 /* ...keyboard event processing */
 static inline widget_data_t * app_kbd_event(app_data_t *app, widget_data_t *widget, widget_key_event_t *event)
 {
-    pthread_mutex_lock(&app->lock);
+    app_lock(app);
 
     if (event->type == WIDGET_EVENT_KEY_PRESS)
     {
@@ -1800,12 +2518,12 @@ static inline widget_data_t * app_kbd_event(app_data_t *app, widget_data_t *widg
                     timer_source_stop(app->long_press_timer);
 
                     /* ...switch the focus */
-                    __focus_switch(app, (++app->focus == 5 ? app->focus = 0 : app->focus));
+                    __focus_switch(app, (++app->focus == app_focus_number(app) ? app->focus = 0 : app->focus));
                 }
                 else if (app->focus == 0)
                 {
                     /* ...ignore event as we toggled the focus */
-                    __focus_switch(app, (++app->focus == 5 ? app->focus = 0 : app->focus));
+                    __focus_switch(app, (++app->focus == app_focus_number(app) ? app->focus = 0 : app->focus));
                 }
             }
         }
@@ -1819,7 +2537,7 @@ static inline widget_data_t * app_kbd_event(app_data_t *app, widget_data_t *widg
                     timer_source_stop(app->timer);
 
                     /* ...left button pressed */
-                    if (app->focus == 0)
+                    if (app->focus == 0 && app->imr_sv)
                     {
                         /* ...switch to IMR mode */
                         app->sv_gpu_mode = 0;
@@ -1827,10 +2545,10 @@ static inline widget_data_t * app_kbd_event(app_data_t *app, widget_data_t *widg
                         /* ...reset carousel menu parameters */
                         (app->imr_menu ? carousel_reset(app->imr_menu) : 0);
                     }
-                    else if (app->focus > 1)
+                    else if (app_focus_sc(app) >= 0)
                     {
                         /* ...reset active smart-camera state */
-                        __sc_mesh_reset(app, app->focus - 2);
+                        __sc_mesh_reset(app, app_focus_sc(app));
                     }
                 }
                 else
@@ -1851,7 +2569,7 @@ static inline widget_data_t * app_kbd_event(app_data_t *app, widget_data_t *widg
                 if (app->focus == 0)
                 {
                     /* ...pass event to surround-view app */
-                    sview_engine_keyboard_key(app->sv, event->code, event->state);
+                    (app->sv ? sview_engine_keyboard_key(app->sv, event->code, event->state) : 0);
                 }
                 else
                 {
@@ -1859,9 +2577,9 @@ static inline widget_data_t * app_kbd_event(app_data_t *app, widget_data_t *widg
                     timer_source_start(app->timer, FOCUS_REVERT_TIMEOUT, 0);
 
                     /* ...pass event to smart-camera object */
-                    if (app->focus >= 2)
+                    if (app_focus_sc(app) >= 0)
                     {
-                        sc_kbd_event(app, app->focus - 2, event);
+                        sc_kbd_event(app, app_focus_sc(app), event);
                     }
                 }
             }
@@ -1873,7 +2591,7 @@ static inline widget_data_t * app_kbd_event(app_data_t *app, widget_data_t *widg
         }
     }
 
-    pthread_mutex_unlock(&app->lock);
+    app_unlock(app);
 
     return widget;
 }
@@ -2003,6 +2721,7 @@ static void imr_sv_select(void *cdata, int i, int j)
     
     /* ...set fixed view for the surround-view scene */
     imr_sview_set_view(app->imr_sv, rot, scale, (char*)image);
+    recorder_event(REC_VIEW_CHANGE, 1, i * __app_cfg.carousel_x + j);
 
     TRACE(1, _b("set static view #%d: angle=%f/%f/%f, scale=%f, image='%s'"), i, rot[0], rot[1], rot[2], scale, image);
 }
@@ -2083,28 +2802,55 @@ static int app_context_init(widget_data_t *widget, void *data)
     int             w = window_get_width(window);
     int             h = window_get_height(window);
     const float     factor = (float)h / w;
-    int             i;
+    char           *name[VIN_NUMBER_MAX];
+    int             i, j;
 
-    /* ...create VIN engine */
-    CHK_ERR(app->vin = vin_init(vin_dev_name, VIN_NUMBER, &vin_cb, app), -errno);
+    /* ...create VIN engine for configured cameras */
+    for (i = 0; i < app->cameras_num; i++)
+    {
+        name[i] = app->cameras[i].vin;
+    }
 
-    /* ...create IMR engine */
-    CHK_ERR(app->imr = imr_init(imr_dev_name, IMR_NUMBER - 1 , &imr_cb, app), -errno);
+    CHK_API(app_vin_init(app, name));
 
-    /* ...create driver-monitor engine */
-    CHK_ERR(app->dm = objdet_engine_init(&dm_callback, app, 640, 400, 2, 1280, 1080, &__dm_cfg), -errno);
+    /* ...assign cameras to dedicated capture threads (daemon runs its own) */
+    for (i = 0; app->vin && i < __vin_threads_num; i++)
+    {
+        CHK_API(vin_thread_setup(app->vin, &__vin_threads[i]));
+    }
 
-    /* ..set up color correction backchannel */
-    for (i = 0; i < 4; i++)
+    /* ...create IMR engine (one engine per smart-camera) */
+    for (i = 0; i < app->cameras_num; i++)
     {
-            __sv_cfg.vfd[i] = get_v4l2_fd(app->vin, i);
+        (app_camera_is_sc(app, i) ? name[app_camera_index(app, i)] = app->cameras[i].imr : 0);
+    }
+
+    if (app->sc_num)
+    {
+        CHK_ERR(app->imr = imr_init(name, app->sc_num, &imr_cb, app), -errno);
+    }
+
+    /* ...create driver-monitor engine */
+    if (app->dm_num)
+    {
+        CHK_ERR(app->dm = objdet_engine_init(&dm_callback, app, 640, 400, 2, 1280, 1080, &__dm_cfg), -errno);
     }
-    
-    /* ...setup GPU-based surround-view engine */
-    CHK_ERR(app->sv = sview_engine_init(&__sv_cfg, 1280, 1080), -errno);
 
-    /* ...setup IMR-based surround-view engine (FullHD is a maximal possible resolution) */
-    CHK_ERR(app->imr_sv = imr_sview_init(&imr_sv_callback, app, 1280, 1080, __vin_format, __vsp_width, __vsp_height, __car_width, __car_height, __shadow_rect), -errno);
+    /* ...surround-view engines are created only if the cameras set is present */
+    if (app->sv_num)
+    {
+        /* ..set up color correction backchannel (not available if devices are owned by daemon) */
+        for (i = 0; i < app->cameras_num; i++)
+        {
+            (app_camera_is_sv(app, i) ? __sv_cfg.vfd[app_camera_index(app, i)] = (app->vin ? get_v4l2_fd(app->vin, i) : -1) : 0);
+        }
+
+        /* ...setup GPU-based surround-view engine */
+        CHK_ERR(app->sv = sview_engine_init(&__sv_cfg, 1280, 1080), -errno);
+
+        /* ...setup IMR-based surround-view engine (FullHD is a maximal possible resolution) */
+        CHK_ERR(app->imr_sv = imr_sview_init(&imr_sv_callback, app, 1280, 1080, __vin_format, __vsp_width, __vsp_height, __car_width, __car_height, __shadow_rect), -errno);
+    }
 
     /* ...adjust carousel parameters for a given aspect ratio */
     __imr_sv_carousel_cfg.x_length *= (float)h / w;
@@ -2123,37 +2869,57 @@ static int app_context_init(widget_data_t *widget, void *data)
     /* ...create a long-touch detection timer */
     app->long_press_timer = timer_source_create(long_press_timeout, app, NULL, g_main_loop_get_context(app->loop));
 
+    /* ...create buffer pools supervision timer */
+    app->pool_timer = timer_source_create(pool_timeout, app, NULL, g_main_loop_get_context(app->loop));
+
+    /* ...create load-shedding supervision timer */
+    app->shed_timer = timer_source_create(shed_timeout, app, NULL, g_main_loop_get_context(app->loop));
+
+    /* ...create statistics reporting timer */
+    app->stats_timer = timer_source_create(stats_timeout, app, NULL, g_main_loop_get_context(app->loop));
+
     /* ...initialize VINs for surround-view */
-    for (i = 0; i < 4; i++)
+    for (i = 0; i < app->cameras_num; i++)
     {
-        const float *v = __sv_view[i];
+        const float *v;
+
+        if (!app_camera_is_sv(app, i))      continue;
+
+        v = __sv_view[j = app_camera_index(app, i)];
         
         /* ...use 1280*1080 UYVY configuration; use pool of 5 buffers */
-        CHK_API(vin_device_init(app->vin, i, 1280, 1080, V4L2_PIX_FMT_UYVY, 6));
+        CHK_API(app_vin_device_init(app, i, 1280, 1080, V4L2_PIX_FMT_UYVY, 6));
 
         /* ...setup view-port - fill single quadrant */
-        texture_set_view(&app->sv_view[i], v[0], v[1], v[2], v[3]);
+        texture_set_view(&app->sv_view[j], v[0], v[1], v[2], v[3]);
     }
 
     /* ...reset buffers readiness flags */
-    app->sv_flags = (1 << i) - 1;
+    app->sv_flags = (1 << app->sv_num) - 1;
 
     /* ...initialize VINs for driver-monitor */
-    for (i = 0; i < 1; i++)
+    for (i = 0; i < app->cameras_num; i++)
     {
-        const float     *v = __dm_view[i];
-        cairo_matrix_t  *m = &app->dm_mat[i];
+        const float     *v;
+        cairo_matrix_t  *m;
         __mat3x3        __identity;
 
+        if (!app_camera_is_dm(app, i))      continue;
+
+        v = __dm_view[j = app_camera_index(app, i)], m = &app->dm_mat[j];
+
         /* ...create identity matrix */
         __mat3x3_identity(__identity);
 
         /* ...set camera into 640 * 400 NV16 configuration; use pool of 5 buffers */
-        CHK_API(vin_device_init(app->vin, VIN_DM + i, 640, 400, V4L2_PIX_FMT_UYVY, 8));
+        CHK_API(app_vin_device_init(app, i, 640, 400, V4L2_PIX_FMT_UYVY, 8));
+
+        /* ...detector needs only the most recent frame (daemon skips frames beyond quota anyway) */
+        CHK_API(app->vin ? vin_device_set_latest(app->vin, i, DM_LATEST_DEPTH) : 0);
 
         /* ...setup view-port */
-        texture_set_view(&app->dm_view[i][0], v[0], v[1], v[2], v[3]);
-        texture_set_view(&app->dm_view[i][1], v[0] - 0.03 * factor, v[1] - 0.03, v[2] + 0.03 * factor, v[3] + 0.03);
+        texture_set_view(&app->dm_view[j][0], v[0], v[1], v[2], v[3]);
+        texture_set_view(&app->dm_view[j][1], v[0] - 0.03 * factor, v[1] - 0.03, v[2] + 0.03 * factor, v[3] + 0.03);
 
         /* ...initialize cairo transformation matrix for a drawing */
         m->xx = (v[2] - v[0]) * w / 640.0, m->xy = 0;
@@ -2172,56 +2938,173 @@ static int app_context_init(widget_data_t *widget, void *data)
 #endif
     }
 
-    /* ...reset buffers readiness flags */
-    app->dm_flags = (1 << i) - 1;
-
     /* ...initialize VINs for smart-cameras */
-    for (i = 0; i < 3; i++)
+    for (i = 0; i < app->cameras_num; i++)
     {
-        const float *v = __sc_view[i];
+        const float *v;
         const float factor = (float)h / w;
+
+        if (!app_camera_is_sc(app, i))      continue;
+
+        v = __sc_view[j = app_camera_index(app, i)];
         
         /* ...set camera into 1280 * 1080 UYVY configuration; use pool of 5 buffers */
-        CHK_API(vin_device_init(app->vin, VIN_SC_LEFT + i, 1280, 1080/* 640, 400 */, V4L2_PIX_FMT_UYVY, 5));
+        CHK_API(app_vin_device_init(app, i, 1280, 1080/* 640, 400 */, V4L2_PIX_FMT_UYVY, 5));
 
         /* ...setup view-port */
-        texture_set_view(&app->sc_view[i][0], v[0], v[1], v[2], v[3]);
-        texture_set_view(&app->sc_view[i][1], v[0] - 0.03 * factor, v[1] - 0.03, v[2] + 0.03 * factor, v[3] + 0.03);
+        texture_set_view(&app->sc_view[j][0], v[0], v[1], v[2], v[3]);
+        texture_set_view(&app->sc_view[j][1], v[0] - 0.03 * factor, v[1] - 0.03, v[2] + 0.03 * factor, v[3] + 0.03);
 
         /* ...allocate VSP buffers (we use user-pointer V4L2 configuration) */
-        CHK_API(vsp_allocate_buffers(1280, 1080, V4L2_PIX_FMT_UYVY, app->sc_mem[i], 2));
+        CHK_API(vsp_allocate_buffers(1280, 1080, V4L2_PIX_FMT_UYVY, app->sc_mem[j], 2));
         
         /* ...setup IMR engine */
-        CHK_API(imr_setup(app->imr, i, 1280, 1080/* 640, 400 */, 1280, 1080, GST_VIDEO_FORMAT_UYVY, GST_VIDEO_FORMAT_UYVY, IMR_POOL_SIZE));
+        CHK_API(imr_setup(app->imr, j, 1280, 1080/* 640, 400 */, 1280, 1080, GST_VIDEO_FORMAT_UYVY, GST_VIDEO_FORMAT_UYVY, IMR_POOL_SIZE));
 
         /* ...set initial transformation matrix */
-        CHK_API(__sc_mesh_reset(app, i));
+        CHK_API(__sc_mesh_reset(app, j));
     }
-    
-    /* ...reset buffers readiness flags */
-    app->sc_flags = (1 << i) - 1;
 
     /* ...start IMR engine */
-    CHK_API(imr_start(app->imr));
+    if (app->imr)
+    {
+        CHK_API(imr_start(app->imr));
+    }
+
+    /* ...enable automatic growth of VIN buffer pools if requested */
+    (app->vin && __vin_pool_max > 0 ? timer_source_start(app->pool_timer, VIN_POOL_CHECK_PERIOD, VIN_POOL_CHECK_PERIOD) : 0);
+
+    /* ...start load-shedding controller if any budget is set */
+    (app_shed_enabled() ? timer_source_start(app->shed_timer, APP_SHED_PERIOD, APP_SHED_PERIOD) : 0);
+
+    /* ...report run-time statistics periodically */
+    timer_source_start(app->stats_timer, APP_STATS_PERIOD, APP_STATS_PERIOD);
 
     TRACE(INFO, _b("run-time initialized: %d*%d"), w, h);
 
     return 0;
 }
 
+/*******************************************************************************
+ * Cameras topology
+ ******************************************************************************/
+
+/* ...default topology: surround-view set, driver-monitor and three smart-cameras */
+static const int __default_roles[] = {
+    APP_CAMERA_SV, APP_CAMERA_SV, APP_CAMERA_SV, APP_CAMERA_SV,
+    APP_CAMERA_DM,
+    APP_CAMERA_SC, APP_CAMERA_SC, APP_CAMERA_SC,
+};
+
+/* ...allocate zero-initialized per-camera array (no storage for unused roles) */
+static inline int __cameras_alloc(void *ptr, int n, size_t size)
+{
+    void  **p = ptr;
+
+    return (n == 0 || (*p = calloc(n, size)) != NULL ? 0 : -(errno = ENOMEM));
+}
+
+/* ...release per-camera data */
+static void app_topology_destroy(app_data_t *app)
+{
+    free(app->cameras), free(app->vin_starved);
+    free(app->dm_output), free(app->dm_pacer), free(app->dm_stale), free(app->dm_view), free(app->dm_mat);
+    free(app->sc_output), free(app->sc_pacer), free(app->sc_stale), free(app->sc_view), free(app->sc_mem), free(app->sc_cfg);
+}
+
+/* ...set up cameras roles and allocate per-camera data */
+static int app_topology_init(app_data_t *app)
+{
+    app_cfg_t      *cfg = &__app_cfg;
+    int             n = (cfg->topology_number ? : (int)(sizeof(__default_roles) / sizeof(__default_roles[0])));
+    int             k[APP_CAMERA_ROLES] = { 0 };
+    int             i;
+
+    CHK_ERR(n <= VIN_NUMBER_MAX, -(errno = EINVAL));
+
+    CHK_API(__cameras_alloc(&app->cameras, n, sizeof(*app->cameras)));
+    CHK_API(__cameras_alloc(&app->vin_starved, n, sizeof(*app->vin_starved)));
+
+    /* ...assign roles and devices; default layout takes devices from command line */
+    for (i = 0; i < n; i++)
+    {
+        app_camera_t   *c = &app->cameras[i];
+        int             role = (cfg->topology_number ? cfg->topology[i].role : __default_roles[i]);
+
+        c->role = role, c->index = k[role]++;
+        c->vin = (cfg->topology_number ? cfg->topology[i].vin : vin_dev_name[i]);
+        c->imr = (cfg->topology_number ? cfg->topology[i].imr : NULL);
+    }
+
+    /* ...surround-view engines process complete set only; others are bound by screen layout */
+    CHK_ERR(k[APP_CAMERA_SV] == 0 || k[APP_CAMERA_SV] == CAMERAS_NUMBER, -(errno = EINVAL));
+    CHK_ERR(k[APP_CAMERA_DM] <= DM_CAMERAS_MAX && k[APP_CAMERA_SC] <= SC_CAMERAS_MAX, -(errno = EINVAL));
+
+    /* ...smart-cameras use IMR engines in order unless configured explicitly */
+    for (i = 0; i < n; i++)
+    {
+        app_camera_t   *c = &app->cameras[i];
+
+        (c->role == APP_CAMERA_SC && !c->imr ? c->imr = imr_dev_name[c->index] : 0);
+    }
+
+    /* ...allocate per-camera data of the roles that are present */
+    CHK_API(__cameras_alloc(&app->dm_output, k[APP_CAMERA_DM], sizeof(*app->dm_output)));
+    CHK_API(__cameras_alloc(&app->dm_pacer, k[APP_CAMERA_DM], sizeof(*app->dm_pacer)));
+    CHK_API(__cameras_alloc(&app->dm_stale, k[APP_CAMERA_DM], sizeof(*app->dm_stale)));
+    CHK_API(__cameras_alloc(&app->dm_view, k[APP_CAMERA_DM], sizeof(*app->dm_view)));
+    CHK_API(__cameras_alloc(&app->dm_mat, k[APP_CAMERA_DM], sizeof(*app->dm_mat)));
+    CHK_API(__cameras_alloc(&app->sc_output, k[APP_CAMERA_SC], sizeof(*app->sc_output)));
+    CHK_API(__cameras_alloc(&app->sc_pacer, k[APP_CAMERA_SC], sizeof(*app->sc_pacer)));
+    CHK_API(__cameras_alloc(&app->sc_stale, k[APP_CAMERA_SC], sizeof(*app->sc_stale)));
+    CHK_API(__cameras_alloc(&app->sc_view, k[APP_CAMERA_SC], sizeof(*app->sc_view)));
+    CHK_API(__cameras_alloc(&app->sc_mem, k[APP_CAMERA_SC], sizeof(*app->sc_mem)));
+    CHK_API(__cameras_alloc(&app->sc_cfg, k[APP_CAMERA_SC], sizeof(*app->sc_cfg)));
+
+    /* ...publish the numbers once storage is in place */
+    app->cameras_num = n;
+    app->sv_num = k[APP_CAMERA_SV], app->dm_num = k[APP_CAMERA_DM], app->sc_num = k[APP_CAMERA_SC];
+
+    /* ...surround-view scene cannot be produced by IMR engine without the cameras */
+    (app->sv_num == 0 ? app->sv_gpu_mode = 1 : 0);
+
+    TRACE(INIT, _b("cameras topology: %d cameras (sv: %d, dm: %d, sc: %d)"), n, app->sv_num, app->dm_num, app->sc_num);
+
+    return 0;
+}
+
 /*******************************************************************************
  * Application thread
  ******************************************************************************/
 
+/* ...termination request handler (executed in main loop context) */
+static gboolean app_signal(void *data)
+{
+    app_data_t     *app = data;
+
+    TRACE(INIT, _b("termination requested"));
+
+    g_main_loop_quit(app->loop);
+
+    return TRUE;
+}
+
 void * app_thread(void *arg)
 {
     app_data_t     *app = arg;
 
-    C_UNUSED(app);
-    
+    /* ...quit main loop on interruption to let the caller finalize the modules */
+    g_unix_signal_add(SIGINT, app_signal, app);
+    g_unix_signal_add(SIGTERM, app_signal, app);
+
     g_main_loop_run(app->loop);
-    
-    while (1)   sleep(10);
+
+    /* ...stop accepting input and rendering; the frames in flight are left to complete */
+    app_lock(app);
+    app->quit = 1;
+    app_unlock(app);
+
+    TRACE(INIT, _b("main loop terminated"));
 
     return NULL;
 }
@@ -2279,14 +3162,32 @@ static gboolean app_bus_callback(GstBus *bus, GstMessage *message, gpointer data
 static void app_destroy(gpointer data, GObject *obj)
 {
     app_data_t  *app = data;
+    int          i;
 
     TRACE(INIT, _b("destruct application data"));
 
+    /* ...report consumers rate control statistics */
+    TRACE(INFO, _b("sv-rate: passed=%u, skipped=%u, stale=%u"), app->sv_pacer.passed, app->sv_pacer.skipped, app->sv_stale);
+    for (i = 0; i < app->dm_num; i++)
+    {
+        TRACE(INFO, _b("dm-%d-rate: passed=%u, skipped=%u, stale=%u"), i, app->dm_pacer[i].passed, app->dm_pacer[i].skipped, app->dm_stale[i]);
+    }
+    for (i = 0; i < app->sc_num; i++)
+    {
+        TRACE(INFO, _b("sc-%d-rate: passed=%u, skipped=%u, stale=%u"), i, app->sc_pacer[i].passed, app->sc_pacer[i].skipped, app->sc_stale[i]);
+    }
+
     /* ...destroy main loop */
     g_main_loop_unref(app->loop);
 
     /* ...destroy main application window */
     (app->window ? window_destroy(app->window) : 0);
+
+    /* ...release renderer rings */
+    app_rings_destroy(app);
+
+    /* ...release per-camera data */
+    app_topology_destroy(app);
     
     /* ...free application data structure */
     free(app);
@@ -2320,6 +3221,7 @@ app_data_t * app_init(display_data_t *display)
 {
     app_data_t            *app;
     pthread_mutexattr_t    attr;
+    int                    i;
 
     /* ...sanity check - output device shall be positive */
     CHK_ERR(__output_main >= 0, (errno = EINVAL, NULL));
@@ -2333,6 +3235,27 @@ app_data_t * app_init(display_data_t *display)
     /* ...start in GPU-SV mode */
     app->sv_gpu_mode = 1, app->focus = 0;
 
+    /* ...set up cameras topology */
+    if (app_topology_init(app) != 0)
+    {
+        TRACE(ERROR, _x("invalid cameras topology: %m"));
+        goto error;
+    }
+
+    /* ...set up consumers rate control */
+    app_pacer_init(&app->sv_pacer, &__app_rate[APP_RATE_SV]);
+    for (i = 0; i < app->dm_num; i++)
+    {
+        app_pacer_init(&app->dm_pacer[i], &__app_rate[APP_RATE_DM]);
+    }
+    for (i = 0; i < app->sc_num; i++)
+    {
+        app_pacer_init(&app->sc_pacer[i], &__app_rate[APP_RATE_SC]);
+    }
+
+    /* ...keep stages times in buffers for load-shedding controller */
+    if (app_shed_enabled())     stamp_collect(1);
+
     /* ...set output device number for a main window */
     app_main_info.output = __output_main;
 
@@ -2349,6 +3272,31 @@ app_data_t * app_init(display_data_t *display)
     pthread_mutex_init(&app->lock, &attr);
     pthread_mutexattr_destroy(&attr);
 
+    /* ...create rings passing processed buffers to the renderer */
+    if (ring_init(&app->sv_output, APP_RING_SIZE) < 0)
+    {
+        TRACE(ERROR, _x("failed to create render rings: %m"));
+        goto error;
+    }
+
+    for (i = 0; i < app->dm_num; i++)
+    {
+        if (ring_init(&app->dm_output[i], APP_RING_SIZE) < 0)
+        {
+            TRACE(ERROR, _x("failed to create render rings: %m"));
+            goto error;
+        }
+    }
+
+    for (i = 0; i < app->sc_num; i++)
+    {
+        if (ring_init(&app->sc_output[i], APP_RING_SIZE) < 0)
+        {
+            TRACE(ERROR, _x("failed to create render rings: %m"));
+            goto error;
+        }
+    }
+
     /* ...create main loop object (use default context) */
     if ((app->loop = g_main_loop_new(NULL, FALSE)) == NULL)
     {
@@ -2384,7 +3332,7 @@ app_data_t * app_init(display_data_t *display)
     }
 
     /* ...start VIN interface */
-    if (vin_start(app->vin) < 0)
+    if (app_vin_start(app) < 0)
     {
         TRACE(ERROR, _x("failed to start VIN: %m"));
         goto error;
@@ -2404,6 +3352,12 @@ error:
     /* ...destroy main application window */
     (app->window ? window_destroy(app->window) : 0);
 
+    /* ...release renderer rings */
+    app_rings_destroy(app);
+
+    /* ...release per-camera data */
+    app_topology_destroy(app);
+
     /* ...destroy data handle */
     free(app);
 
@@ -0,0 +1,400 @@
+/*******************************************************************************
+ * utest-stamp.c
+ *
+ * ADAS unit-test. Frame timing shared-memory ring
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      STAMP
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-stamp.h"
+#include "utest-vsink.h"
+#include "utest-imr.h"
+#include <fcntl.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...Chrome trace flushing period (us) */
+#define STAMP_TRACE_FLUSH_PERIOD        1000000
+
+/*******************************************************************************
+ * Local variables
+ ******************************************************************************/
+
+/* ...mapped ring (NULL if disabled) */
+static stamp_header_t  *__stamp_hdr;
+
+/* ...records array */
+static stamp_record_t  *__stamp_rec;
+
+/* ...shared-memory object name */
+static char            *__stamp_name;
+
+/* ...Chrome trace output file (NULL if disabled) */
+static FILE            *__stamp_trace;
+
+/* ...collection of buffer times with no export enabled */
+static int              __stamp_collect;
+
+/* ...number of trace events written and mask of named trace threads */
+static u32              __stamp_events, __stamp_tids;
+
+/* ...time of last trace flushing (us) */
+static u64              __stamp_flushed;
+
+/* ...trace output lock (file may be closed while renderer is still running) */
+static pthread_mutex_t  __stamp_trace_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/* ...stages names */
+static const char      *__stamp_names[STAMP_NUMBER] = {
+    [STAMP_CAPTURE] = "capture",
+    [STAMP_VIN] = "vin",
+    [STAMP_IMR_QUEUE] = "imr-queue",
+    [STAMP_IMR] = "imr",
+    [STAMP_VSP] = "vsp",
+    [STAMP_REDRAW] = "redraw",
+    [STAMP_DISPLAY] = "display",
+};
+
+/*******************************************************************************
+ * Internal helpers
+ ******************************************************************************/
+
+/* ...current monotonic time in microseconds */
+static inline u64 __stamp_now(void)
+{
+    struct timespec     ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (u64)ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
+/* ...check if any timing consumer is active */
+static inline int __stamp_enabled(void)
+{
+    return __stamp_hdr || __stamp_trace || __stamp_collect;
+}
+
+/* ...get stages times carried by buffer metadata */
+static inline u64 * __stamp_meta(GstBuffer *buffer)
+{
+    vsink_meta_t   *vmeta;
+    imr_meta_t     *imeta;
+
+    if ((vmeta = gst_buffer_get_vsink_meta(buffer)) != NULL)        return vmeta->stamps;
+    else if ((imeta = gst_buffer_get_imr_meta(buffer)) != NULL)     return imeta->stamps;
+    else                                                            return NULL;
+}
+
+/* ...locate the record of particular frame */
+static inline stamp_record_t * __stamp_record(u32 camera, u32 seq)
+{
+    u32     depth = __stamp_hdr->depth;
+
+    return (camera < __stamp_hdr->cameras ? &__stamp_rec[camera * depth + seq % depth] : NULL);
+}
+
+/*******************************************************************************
+ * Writers interface
+ ******************************************************************************/
+
+/* ...start timing of new captured frame (called from capture thread) */
+void stamp_frame(GstBuffer *buffer, int camera, u32 seq, u64 ts)
+{
+    stamp_record_t     *rec;
+    u64                 now, *t;
+    u32                 v;
+    int                 k;
+
+    /* ...bail out if timing is not enabled */
+    if (!__stamp_enabled())     return;
+
+    now = __stamp_now();
+
+    /* ...reset times carried by the buffer */
+    if ((t = __stamp_meta(buffer)) != NULL)
+    {
+        memset(t, 0, STAMP_NUMBER * sizeof(*t));
+        t[STAMP_CAPTURE] = ts, t[STAMP_VIN] = now;
+    }
+
+    /* ...open a record in the shared-memory ring */
+    if (!__stamp_hdr || !(rec = __stamp_record((u32)camera, seq)))     return;
+
+    /* ...mark record is being updated */
+    v = __atomic_load_n(&rec->version, __ATOMIC_RELAXED);
+    __atomic_store_n(&rec->version, v + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    /* ...fill frame identification and reset stages times */
+    __atomic_store_n(&rec->camera, (u32)camera, __ATOMIC_RELAXED);
+    __atomic_store_n(&rec->sequence, seq, __ATOMIC_RELAXED);
+    for (k = 0; k < STAMP_NUMBER; k++)
+    {
+        __atomic_store_n(&rec->ts[k], 0, __ATOMIC_RELAXED);
+    }
+
+    __atomic_store_n(&rec->ts[STAMP_CAPTURE], ts, __ATOMIC_RELAXED);
+    __atomic_store_n(&rec->ts[STAMP_VIN], now, __ATOMIC_RELAXED);
+
+    /* ...publish the record */
+    __atomic_store_n(&rec->version, v + 2, __ATOMIC_RELEASE);
+}
+
+/* ...mark completion of processing stage for the frame carried by a buffer */
+void stamp_buffer(GstBuffer *buffer, int stage)
+{
+    u64                 id = GST_BUFFER_OFFSET(buffer);
+    u32                 camera = (u32)(id >> 32), seq = (u32)id;
+    stamp_record_t     *rec;
+    u64                 now, *t;
+
+    /* ...bail out if timing is not enabled or buffer does not carry frame identity */
+    if (!__stamp_enabled() || id == GST_BUFFER_OFFSET_NONE)     return;
+
+    now = __stamp_now();
+
+    /* ...update times carried by the buffer */
+    ((t = __stamp_meta(buffer)) != NULL ? t[stage] = now : 0);
+
+    /* ...ignore frames whose record has been recycled already */
+    if (!__stamp_hdr || !(rec = __stamp_record(camera, seq)) || __atomic_load_n(&rec->sequence, __ATOMIC_ACQUIRE) != seq)   return;
+
+    __atomic_store_n(&rec->ts[stage], now, __ATOMIC_RELEASE);
+}
+
+/* ...pass source frame times to the derived buffer */
+void stamp_copy(GstBuffer *dst, GstBuffer *src)
+{
+    u64    *d, *s;
+
+    if (__stamp_enabled() && (d = __stamp_meta(dst)) != NULL && (s = __stamp_meta(src)) != NULL)
+    {
+        memcpy(d, s, STAMP_NUMBER * sizeof(*d));
+    }
+}
+
+/*******************************************************************************
+ * Readers interface
+ ******************************************************************************/
+
+/* ...get stages durations of a displayed frame (us); returns capture-to-display latency */
+int stamp_latency(GstBuffer *buffer, u32 *d)
+{
+    u64    *t;
+    int     k, prev;
+
+    /* ...buffer must carry complete timing */
+    if (!__stamp_enabled() || GST_BUFFER_OFFSET(buffer) == GST_BUFFER_OFFSET_NONE)     return -(errno = ENODATA);
+    if (!(t = __stamp_meta(buffer)) || !t[STAMP_CAPTURE] || t[STAMP_DISPLAY] < t[STAMP_CAPTURE])    return -(errno = ENODATA);
+
+    /* ...stages the frame has not passed through are accounted to the next one */
+    for (d[STAMP_CAPTURE] = 0, prev = STAMP_CAPTURE, k = STAMP_CAPTURE + 1; k < STAMP_NUMBER; k++)
+    {
+        (t[k] < t[prev] ? d[k] = 0 : (d[k] = (u32)(t[k] - t[prev]), prev = k));
+    }
+
+    return (int)(t[STAMP_DISPLAY] - t[STAMP_CAPTURE]);
+}
+
+/* ...stage name */
+const char * stamp_stage_name(int stage)
+{
+    return ((u32)stage < STAMP_NUMBER ? __stamp_names[stage] : "unknown");
+}
+
+/*******************************************************************************
+ * Chrome trace export
+ ******************************************************************************/
+
+/* ...output single trace event */
+static inline void __stamp_trace_event(const char *fmt, ...)
+{
+    va_list     args;
+
+    fputs(__stamp_events++ ? ",\n" : "[\n", __stamp_trace);
+    va_start(args, fmt);
+    vfprintf(__stamp_trace, fmt, args);
+    va_end(args);
+}
+
+/* ...write displayed frame stages as trace events (called from renderer thread) */
+void stamp_trace_frame(GstBuffer *buffer)
+{
+    u64     id = GST_BUFFER_OFFSET(buffer);
+    u32     camera = (u32)(id >> 32), seq = (u32)id;
+    u64    *t, now;
+    int     k, prev;
+
+    /* ...bail out if export is disabled or buffer does not carry complete timing */
+    if (!__stamp_trace || id == GST_BUFFER_OFFSET_NONE)     return;
+    if (!(t = __stamp_meta(buffer)) || !t[STAMP_CAPTURE] || t[STAMP_DISPLAY] < t[STAMP_CAPTURE])    return;
+
+    pthread_mutex_lock(&__stamp_trace_lock);
+
+    /* ...re-check under lock as trace might have been closed meanwhile */
+    if (!__stamp_trace)     goto out;
+
+    /* ...name camera track when it shows up first time */
+    if (camera < 32 && !(__stamp_tids & (1U << camera)))
+    {
+        __stamp_trace_event("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"camera-%u\"}}", camera, camera);
+        __stamp_tids |= 1U << camera;
+    }
+
+    /* ...glass-to-glass interval enclosing all stages */
+    __stamp_trace_event("{\"name\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu,\"args\":{\"seq\":%u}}",
+                        camera, (unsigned long long)t[STAMP_CAPTURE], (unsigned long long)(t[STAMP_DISPLAY] - t[STAMP_CAPTURE]), seq);
+
+    /* ...individual stages the frame has passed through */
+    for (prev = STAMP_CAPTURE, k = STAMP_CAPTURE + 1; k < STAMP_NUMBER; k++)
+    {
+        if (t[k] < t[prev])     continue;
+
+        __stamp_trace_event("{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%llu,\"dur\":%llu,\"args\":{\"seq\":%u}}",
+                            __stamp_names[k], camera, (unsigned long long)t[prev], (unsigned long long)(t[k] - t[prev]), seq);
+        prev = k;
+    }
+
+    /* ...flush the output periodically so that trace survives abnormal termination */
+    if ((now = __stamp_now()) - __stamp_flushed >= STAMP_TRACE_FLUSH_PERIOD)
+    {
+        fflush(__stamp_trace);
+        __stamp_flushed = now;
+    }
+
+out:
+    pthread_mutex_unlock(&__stamp_trace_lock);
+}
+
+/* ...create Chrome trace file */
+int stamp_trace_open(const char *fname)
+{
+    CHK_ERR(!__stamp_trace, -(errno = EBUSY));
+    CHK_ERR(__stamp_trace = fopen(fname, "wt"), -errno);
+
+    __stamp_events = __stamp_tids = 0;
+    __stamp_flushed = __stamp_now();
+
+    TRACE(INIT, _b("latency trace output: '%s'"), fname);
+
+    return 0;
+}
+
+/* ...finalize Chrome trace file */
+void stamp_trace_close(void)
+{
+    FILE   *f;
+
+    /* ...disable export (wait for the frame being written) */
+    pthread_mutex_lock(&__stamp_trace_lock);
+    f = __stamp_trace, __stamp_trace = NULL;
+    pthread_mutex_unlock(&__stamp_trace_lock);
+
+    if (!f)     return;
+
+    /* ...terminate JSON array */
+    fputs(__stamp_events ? "\n]\n" : "[]\n", f);
+    fclose(f);
+
+    TRACE(INIT, _b("latency trace closed: %u events"), __stamp_events);
+}
+
+/*******************************************************************************
+ * Module initialization
+ ******************************************************************************/
+
+/* ...create shared-memory ring */
+int stamp_init(const char *name, int cameras, int depth)
+{
+    size_t      size = sizeof(stamp_header_t) + (size_t)cameras * depth * sizeof(stamp_record_t);
+    void       *map;
+    int         fd;
+
+    /* ...sanity check */
+    CHK_ERR(!__stamp_hdr && cameras > 0 && depth > 0, -(errno = EINVAL));
+
+    /* ...create shared-memory object (visible in /dev/shm) */
+    CHK_ERR((fd = shm_open(name, O_RDWR | O_CREAT | O_TRUNC, 0644)) >= 0, -errno);
+
+    if (ftruncate(fd, size) < 0 || (map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) == MAP_FAILED)
+    {
+        TRACE(ERROR, _x("failed to map shared memory '%s': %m"), name);
+        close(fd), shm_unlink(name);
+        return -errno;
+    }
+
+    /* ...mapping is retained after descriptor is closed */
+    close(fd);
+
+    /* ...records are zero-filled by ftruncate; fill the header */
+    __stamp_hdr = map, __stamp_rec = (stamp_record_t *)(__stamp_hdr + 1);
+    __stamp_hdr->cameras = cameras, __stamp_hdr->depth = depth;
+    __stamp_hdr->size = sizeof(stamp_record_t);
+    __stamp_hdr->version = STAMP_VERSION;
+    __atomic_store_n(&__stamp_hdr->magic, STAMP_MAGIC, __ATOMIC_RELEASE);
+
+    __stamp_name = strdup(name);
+
+    TRACE(INIT, _b("frame timing ring '%s' created: %d cameras, %d records each"), name, cameras, depth);
+
+    return 0;
+}
+
+/* ...destroy shared-memory ring */
+void stamp_destroy(void)
+{
+    /* ...do nothing if ring is not enabled */
+    if (!__stamp_hdr)       return;
+
+    /* ...remove the object name; mapping is kept as some writers may still be running */
+    (__stamp_name ? shm_unlink(__stamp_name), free(__stamp_name) : (void)0);
+    __stamp_name = NULL;
+
+    TRACE(INIT, _b("frame timing ring destroyed"));
+}
+
+/* ...keep stages times in buffers metadata regardless of export (benchmarking) */
+void stamp_collect(int enable)
+{
+    __stamp_collect = enable;
+}
@@ -0,0 +1,141 @@
+/*******************************************************************************
+ * utest-stamp.h
+ *
+ * ADAS unit-test. Frame timing shared-memory ring
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#ifndef __UTEST_STAMP_H
+#define __UTEST_STAMP_H
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "utest-common.h"
+
+/*******************************************************************************
+ * Shared-memory layout
+ *
+ * The ring consists of a header followed by "cameras * depth" records; record
+ * of frame with sequence number "seq" from camera "i" is located at position
+ * "i * depth + seq % depth". All times are CLOCK_MONOTONIC in microseconds.
+ *
+ * Record is (re)initialized by the capture thread only; "version" is odd while
+ * that is in progress. Subsequent stages update single time fields atomically,
+ * zero meaning the stage has not been reached yet. Reader shall fetch version,
+ * copy the record and retry if version was odd or has changed meanwhile.
+ ******************************************************************************/
+
+/* ...ring signature ("STMP") and layout revision */
+#define STAMP_MAGIC                     0x504D5453
+#define STAMP_VERSION                   2
+
+/* ...default number of records per camera (about two seconds at 30 fps) */
+#define STAMP_DEPTH                     64
+
+/* ...frame processing stages (V4L2 capture, VIN dequeue, IMR queue/done, VSP done, redraw, buffers swap) */
+enum {
+    STAMP_CAPTURE,
+    STAMP_VIN,
+    STAMP_IMR_QUEUE,
+    STAMP_IMR,
+    STAMP_VSP,
+    STAMP_REDRAW,
+    STAMP_DISPLAY,
+    STAMP_NUMBER,
+};
+
+/* ...ring header */
+typedef struct stamp_header
+{
+    /* ...signature and layout revision */
+    u32                 magic, version;
+
+    /* ...number of cameras and records per camera */
+    u32                 cameras, depth;
+
+    /* ...size of individual record */
+    u32                 size;
+
+    /* ...reserved for future use */
+    u32                 reserved[3];
+
+}   stamp_header_t;
+
+/* ...per-frame record */
+typedef struct stamp_record
+{
+    /* ...record update counter */
+    u32                 version;
+
+    /* ...camera identifier */
+    u32                 camera;
+
+    /* ...capture sequence number */
+    u32                 sequence;
+
+    /* ...padding */
+    u32                 reserved;
+
+    /* ...V4L2 capture timestamp and stages completion times */
+    u64                 ts[STAMP_NUMBER];
+
+}   stamp_record_t;
+
+/*******************************************************************************
+ * Frame identification
+ ******************************************************************************/
+
+/* ...frame identifier carried in buffer offset field */
+static inline u64 stamp_frame_id(int camera, u32 seq)
+{
+    return ((u64)camera << 32) | seq;
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+extern int stamp_init(const char *name, int cameras, int depth);
+
+extern void stamp_destroy(void);
+
+extern void stamp_frame(GstBuffer *buffer, int camera, u32 seq, u64 ts);
+
+extern void stamp_buffer(GstBuffer *buffer, int stage);
+
+extern void stamp_copy(GstBuffer *dst, GstBuffer *src);
+
+extern int stamp_latency(GstBuffer *buffer, u32 *d);
+
+extern const char * stamp_stage_name(int stage);
+
+extern int stamp_trace_open(const char *fname);
+
+extern void stamp_trace_frame(GstBuffer *buffer);
+
+extern void stamp_trace_close(void);
+
+extern void stamp_collect(int enable);
+
+#endif  /* __UTEST_STAMP_H */
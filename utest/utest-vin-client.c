@@ -0,0 +1,482 @@
+/*******************************************************************************
+ * utest-vin-client.c
+ *
+ * VIN capture daemon client (zero-copy DMABUF frames reception)
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      VINC
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-vsink.h"
+#include "utest-stamp.h"
+#include "utest-vin-client.h"
+#include "utest-vin-proto.h"
+#include <poll.h>
+#include <unistd.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/videodev2.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local typedefs
+ ******************************************************************************/
+
+/* ...imported capture buffer */
+typedef struct vin_client_buffer
+{
+    /* ...GStreamer buffer wrapping the mapping */
+    GstBuffer              *buffer;
+
+    /* ...DMABUF descriptor received from daemon */
+    int                     dmafd;
+
+    /* ...mapped memory */
+    void                   *data;
+    u32                     length;
+
+    /* ...release message is pending transmission by the reception thread */
+    int                     pending;
+
+}   vin_client_buffer_t;
+
+/* ...client camera */
+typedef struct vin_client_camera
+{
+    /* ...capture device name */
+    char                   *name;
+
+    /* ...buffers imported from daemon */
+    vin_client_buffer_t     pool[VIDEO_MAX_FRAME];
+
+}   vin_client_camera_t;
+
+/* ...client data */
+typedef struct vin_client
+{
+    /* ...connection socket */
+    int                     fd;
+
+    /* ...cameras */
+    vin_client_camera_t    *camera;
+    int                     num;
+
+    /* ...application callbacks */
+    camera_callback_t      *cb;
+    void                   *cdata;
+
+    /* ...frames reception thread */
+    pthread_t               thread;
+
+    /* ...reception thread wake-up descriptor */
+    int                     evfd;
+
+    /* ...pending releases access lock */
+    pthread_mutex_t         lock;
+
+    /* ...number of buffers whose release is pending */
+    int                     pending;
+
+}   vin_client_t;
+
+/*******************************************************************************
+ * Messages transmission
+ ******************************************************************************/
+
+/* ...receive message along with optional descriptor */
+static int vin_client_recv(vin_client_t *client, vin_msg_t *msg, int *dmafd)
+{
+    struct iovec        iov = { .iov_base = msg, .iov_len = sizeof(*msg) };
+    struct msghdr       mh = { .msg_iov = &iov, .msg_iovlen = 1 };
+    union {
+        struct cmsghdr  h;
+        char            buf[CMSG_SPACE(sizeof(int))];
+    }                   ctl;
+    struct cmsghdr     *c;
+    ssize_t             n;
+
+    mh.msg_control = ctl.buf, mh.msg_controllen = sizeof(ctl.buf);
+
+    CHK_ERR((n = recvmsg(client->fd, &mh, MSG_CMSG_CLOEXEC)) != 0, -(errno = ECONNRESET));
+    CHK_ERR(n == (ssize_t)sizeof(*msg), -(errno = (n < 0 ? errno : EPROTO)));
+
+    /* ...extract passed descriptor if any */
+    *dmafd = -1;
+
+    for (c = CMSG_FIRSTHDR(&mh); c; c = CMSG_NXTHDR(&mh, c))
+    {
+        if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS)
+        {
+            memcpy(dmafd, CMSG_DATA(c), sizeof(int));
+        }
+    }
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Buffers handling
+ ******************************************************************************/
+
+/* ...return frame to the daemon without blocking (called with a lock held) */
+static int __client_release(vin_client_t *client, u32 i, u32 j)
+{
+    vin_msg_t       msg;
+
+    memset(&msg, 0, sizeof(msg));
+    msg.type = VIN_MSG_RELEASE;
+    msg.camera = i;
+    msg.release.index = j;
+
+    if (send(client->fd, &msg, sizeof(msg), MSG_NOSIGNAL | MSG_DONTWAIT) == sizeof(msg))
+    {
+        return 0;
+    }
+    else if (errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        TRACE(ERROR, _x("camera-%u: failed to release buffer #%u: %m"), i, j);
+    }
+
+    return -errno;
+}
+
+/* ...transmit pending releases once socket becomes writable (called from reception thread) */
+static void vin_client_flush(vin_client_t *client)
+{
+    int     i, j;
+
+    pthread_mutex_lock(&client->lock);
+
+    for (i = 0; i < client->num && client->pending; i++)
+    {
+        for (j = 0; j < VIDEO_MAX_FRAME && client->pending; j++)
+        {
+            vin_client_buffer_t    *buf = &client->camera[i].pool[j];
+
+            if (!buf->pending)      continue;
+
+            /* ...keep the rest queued if socket is still congested */
+            if (__client_release(client, (u32)i, (u32)j) < 0 && errno == EAGAIN)   goto out;
+
+            buf->pending = 0, client->pending--;
+        }
+    }
+
+out:
+    pthread_mutex_unlock(&client->lock);
+}
+
+/* ...buffer dispose function (called in response to "gst_buffer_unref") */
+static gboolean __client_buffer_dispose(GstMiniObject *obj)
+{
+    GstBuffer      *buffer = GST_BUFFER(obj);
+    vin_client_t   *client = (vin_client_t *)buffer->pool;
+    u32             i, j;
+    u64             one = 1;
+
+    /* ...camera and buffer index are carried in the offset-end field */
+    i = (u32)(GST_BUFFER_OFFSET_END(buffer) >> 32);
+    j = (u32)GST_BUFFER_OFFSET_END(buffer);
+
+    /* ...return frame to the daemon; buffer stays imported */
+    pthread_mutex_lock(&client->lock);
+
+    if (client->pending || (__client_release(client, i, j) < 0 && errno == EAGAIN))
+    {
+        /* ...socket is congested; let reception thread send the message (caller is never blocked) */
+        client->camera[i].pool[j].pending = 1, client->pending++;
+
+        if (write(client->evfd, &one, sizeof(one)) < 0)
+        {
+            TRACE(ERROR, _x("failed to wake up reception thread: %m"));
+        }
+    }
+
+    pthread_mutex_unlock(&client->lock);
+
+    gst_buffer_ref(buffer);
+
+    return FALSE;
+}
+
+/* ...import capture buffer announced by daemon */
+static int vin_client_import(vin_client_t *client, u32 i, vin_msg_buffer_t *m, int dmafd)
+{
+    vin_client_buffer_t    *buf;
+    vsink_meta_t           *vmeta;
+    GstBuffer              *buffer;
+
+    CHK_ERR(i < (u32)client->num && m->index < VIDEO_MAX_FRAME && dmafd >= 0, -(errno = EPROTO));
+
+    buf = &client->camera[i].pool[m->index];
+    CHK_ERR(!buf->buffer, -(errno = EEXIST));
+
+    /* ...map buffer memory (no data is copied - frames are shared with other clients) */
+    buf->data = mmap(NULL, m->length, PROT_READ | PROT_WRITE, MAP_SHARED, dmafd, 0);
+    CHK_ERR(buf->data != MAP_FAILED, (buf->data = NULL, -errno));
+    buf->dmafd = dmafd, buf->length = m->length;
+
+    /* ...create GStreamer buffer */
+    CHK_ERR(buf->buffer = buffer = gst_buffer_new(), -(errno = ENOMEM));
+
+    CHK_ERR(vmeta = gst_buffer_add_vsink_meta(buffer), -(errno = ENOMEM));
+    vmeta->width = (int)m->width;
+    vmeta->height = (int)m->height;
+    vmeta->format = __pixfmt_v4l2_to_gst(m->format);
+    vmeta->dmafd[0] = dmafd;
+    vmeta->dmafd[1] = -1;
+    vmeta->plane[0] = buf->data;
+    vmeta->plane[1] = NULL;
+    GST_META_FLAG_SET(vmeta, GST_META_FLAG_POOLED);
+
+    /* ...save buffer identity */
+    GST_BUFFER_OFFSET_END(buffer) = ((u64)i << 32) | m->index;
+
+    /* ...buffer is returned to the daemon rather than freed */
+    GST_MINI_OBJECT(buffer)->dispose = __client_buffer_dispose;
+    buffer->pool = (void *)client;
+
+    TRACE(INFO, _b("camera-%u: buffer #%u imported: %u*%u %c%c%c%c, fd=%d, length=%u"),
+          i, m->index, m->width, m->height, __v4l2_fmt(m->format), dmafd, m->length);
+
+    /* ...notify application on output buffer allocation */
+    return CHK_API(client->cb->allocate(client->cdata, (int)i, buffer));
+}
+
+/* ...pass received frame to the application */
+static int vin_client_frame(vin_client_t *client, u32 i, vin_msg_frame_t *m)
+{
+    GstBuffer      *buffer;
+
+    CHK_ERR(i < (u32)client->num && m->index < VIDEO_MAX_FRAME, -(errno = EPROTO));
+    CHK_ERR(buffer = client->camera[i].pool[m->index].buffer, -(errno = EPROTO));
+
+    /* ...set decoding/presentation timestamp (in nanoseconds) */
+    GST_BUFFER_DTS(buffer) = GST_BUFFER_PTS(buffer) = m->ts * 1000;
+
+    /* ...tag buffer with frame identity and open its timing record */
+    GST_BUFFER_OFFSET(buffer) = stamp_frame_id((int)i, m->sequence);
+    stamp_frame(buffer, (int)i, m->sequence, m->ts);
+
+    /* ...pass buffer to the application */
+    CHK_API(client->cb->process(client->cdata, (int)i, buffer));
+
+    /* ...drop the reference (buffer is now owned by application) */
+    gst_buffer_unref(buffer);
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Reception thread
+ ******************************************************************************/
+
+static void * vin_client_thread(void *arg)
+{
+    vin_client_t   *client = arg;
+    struct pollfd   pfd[2];
+    vin_msg_t       msg;
+    u64             v;
+    int             dmafd;
+    int             r;
+
+    pfd[0].fd = client->fd, pfd[1].fd = client->evfd, pfd[1].events = POLLIN;
+
+    while (1)
+    {
+        /* ...wait for socket writability only if some releases are pending */
+        pfd[0].events = POLLIN | (__atomic_load_n(&client->pending, __ATOMIC_RELAXED) ? POLLOUT : 0);
+
+        if (poll(pfd, 2, -1) < 0)
+        {
+            /* ...ignore soft interruptions */
+            if (errno == EINTR)     continue;
+            TRACE(ERROR, _x("poll failed: %m"));
+            break;
+        }
+
+        /* ...clear wake-up event; pending releases are picked up by the next poll */
+        if (pfd[1].revents & POLLIN)
+        {
+            (read(client->evfd, &v, sizeof(v)) < 0 ? TRACE(ERROR, _x("event read failed: %m")) : 0);
+        }
+
+        if (pfd[0].revents & POLLOUT)
+        {
+            vin_client_flush(client);
+        }
+
+        if (!(pfd[0].revents & (POLLIN | POLLERR | POLLHUP)))
+        {
+            continue;
+        }
+
+        if (vin_client_recv(client, &msg, &dmafd) < 0)
+        {
+            TRACE(ERROR, _x("connection to capture daemon lost: %m"));
+            break;
+        }
+
+        switch (msg.type)
+        {
+        case VIN_MSG_BUFFER:
+            if ((r = vin_client_import(client, msg.camera, &msg.buffer, dmafd)) < 0)
+            {
+                (dmafd >= 0 ? close(dmafd) : 0);
+            }
+            break;
+
+        case VIN_MSG_FRAME:
+            r = vin_client_frame(client, msg.camera, &msg.frame);
+            break;
+
+        default:
+            TRACE(ERROR, _x("unexpected message: %u"), msg.type);
+            r = -(errno = EPROTO);
+        }
+
+        if (r < 0)
+        {
+            TRACE(ERROR, _x("frame processing failed: %m"));
+            break;
+        }
+    }
+
+    return (void *)(intptr_t)-errno;
+}
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+/* ...subscribe to the camera frames (must precede client start) */
+int vin_client_subscribe(vin_client_t *client, int i, int w, int h, u32 fmt, int ratio, int depth)
+{
+    vin_msg_t       msg;
+    int             dmafd;
+
+    CHK_ERR((u32)i < (u32)client->num, -(errno = EINVAL));
+
+    memset(&msg, 0, sizeof(msg));
+    msg.type = VIN_MSG_SUBSCRIBE, msg.camera = (u32)i;
+    msg.subscribe.version = VIN_PROTO_VERSION;
+    msg.subscribe.ratio = (u32)ratio, msg.subscribe.depth = (u32)depth;
+    msg.subscribe.width = (u32)w, msg.subscribe.height = (u32)h, msg.subscribe.format = fmt;
+    strncpy(msg.subscribe.name, client->camera[i].name, VIN_PROTO_NAME_MAX - 1);
+
+    CHK_ERR(send(client->fd, &msg, sizeof(msg), MSG_NOSIGNAL) == sizeof(msg), -errno);
+
+    /* ...frames are not flowing yet, so next message is a response */
+    CHK_API(vin_client_recv(client, &msg, &dmafd));
+    CHK_ERR(msg.type == VIN_MSG_ACK && dmafd < 0, -(errno = EPROTO));
+    CHK_ERR(msg.ack.result >= 0, -(errno = -msg.ack.result));
+
+    TRACE(INIT, _b("camera-%d subscribed to '%s': %d*%d %c%c%c%c, ratio=%d, depth=%d (pool=%d)"),
+          i, client->camera[i].name, w, h, __v4l2_fmt(fmt), ratio, depth, msg.ack.result);
+
+    return 0;
+}
+
+/* ...start frames reception */
+int vin_client_start(vin_client_t *client)
+{
+    /* ...reception thread replaces capture threads, so it takes "vin" class settings */
+    CHK_API(thread_create(&client->thread, "vin-client", 128 << 10, NULL, vin_client_thread, client));
+
+    return 0;
+}
+
+/* ...module initialization function */
+vin_client_t * vin_client_init(const char *path, char **devname, int num, camera_callback_t *cb, void *cdata)
+{
+    vin_client_t       *client;
+    struct sockaddr_un  addr;
+    int                 i;
+
+    CHK_ERR(strlen(path) < sizeof(addr.sun_path), (errno = ENAMETOOLONG, NULL));
+
+    /* ...create client structure */
+    CHK_ERR(client = calloc(1, sizeof(*client)), (errno = ENOMEM, NULL));
+
+    if ((client->camera = calloc(client->num = num, sizeof(*client->camera))) == NULL)
+    {
+        TRACE(ERROR, _x("failed to allocate %zu bytes"), num * sizeof(*client->camera));
+        goto error;
+    }
+
+    for (i = 0; i < num; i++)
+    {
+        client->camera[i].name = devname[i];
+    }
+
+    /* ...save application provided callback */
+    client->cb = cb, client->cdata = cdata;
+
+    /* ...releases that cannot be sent in-place are passed to reception thread */
+    pthread_mutex_init(&client->lock, NULL);
+
+    if ((client->evfd = eventfd(0, EFD_CLOEXEC)) < 0)
+    {
+        TRACE(ERROR, _x("failed to create event: %m"));
+        goto error;
+    }
+
+    /* ...connect to the capture daemon */
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    if ((client->fd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) < 0 ||
+        connect(client->fd, (struct sockaddr *)&addr, sizeof(addr)) < 0)
+    {
+        TRACE(ERROR, _x("failed to connect to capture daemon '%s': %m"), path);
+        goto error_fd;
+    }
+
+    TRACE(INIT, _b("connected to capture daemon '%s'"), path);
+
+    return client;
+
+error_fd:
+    (client->fd >= 0 ? close(client->fd) : 0);
+    close(client->evfd);
+
+error:
+    free(client->camera);
+    free(client);
+    return NULL;
+}
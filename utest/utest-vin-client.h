@@ -0,0 +1,53 @@
+/*******************************************************************************
+ * utest-vin-client.h
+ *
+ * VIN capture daemon client
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#ifndef __UTEST_VIN_CLIENT_H
+#define __UTEST_VIN_CLIENT_H
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "utest-common.h"
+#include "utest-camera.h"
+
+/*******************************************************************************
+ * Opaque handles
+ ******************************************************************************/
+
+typedef struct vin_client   vin_client_t;
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
+
+extern vin_client_t * vin_client_init(const char *path, char **devname, int num, camera_callback_t *cb, void *cdata);
+
+extern int vin_client_subscribe(vin_client_t *client, int i, int w, int h, u32 fmt, int ratio, int depth);
+
+extern int vin_client_start(vin_client_t *client);
+
+#endif  /* __UTEST_VIN_CLIENT_H */
@@ -0,0 +1,738 @@
+/*******************************************************************************
+ * utest-vin-daemon.c
+ *
+ * VIN capture daemon distributing DMABUF frames to multiple clients
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#define MODULE_TAG                      VIND
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#define _GNU_SOURCE
+
+#include "sv/trace.h"
+#include "utest-common.h"
+#include "utest-vsink.h"
+#include "utest-vin.h"
+#include "utest-vin-proto.h"
+#include <getopt.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <linux/videodev2.h>
+
+/*******************************************************************************
+ * Tracing configuration
+ ******************************************************************************/
+
+TRACE_TAG(INIT, 1);
+TRACE_TAG(INFO, 1);
+TRACE_TAG(DEBUG, 0);
+
+/*******************************************************************************
+ * Local constants definitions
+ ******************************************************************************/
+
+/* ...maximal number of capture devices */
+#define VIND_DEVICES_MAX                16
+
+/* ...maximal number of connected clients */
+#define VIND_CLIENTS_MAX                8
+
+/* ...maximal number of subscriptions per client */
+#define VIND_SUBS_MAX                   16
+
+/* ...maximal number of buffers per device */
+#define VIND_POOL_MAX                   VIDEO_MAX_FRAME
+
+/* ...number of buffers that are never granted to clients (kept queued in the driver) */
+#define VIND_DRIVER_RESERVE             2
+
+/* ...statistics reporting period (in delivered frames) */
+#define VIND_STATS_PERIOD               1024
+
+/*******************************************************************************
+ * Local typedefs
+ ******************************************************************************/
+
+/* ...client subscription to particular camera */
+typedef struct vind_sub
+{
+    /* ...capture device index (negative - slot is not used) */
+    int                 camera;
+
+    /* ...decimation ratio and input frames counter */
+    u32                 ratio, count;
+
+    /* ...maximal and current number of frames held by client */
+    u32                 depth, busy;
+
+    /* ...mask of buffers whose descriptors have been passed to the client */
+    u32                 announced;
+
+    /* ...buffers held by client */
+    GstBuffer          *held[VIND_POOL_MAX];
+
+    /* ...delivered frames, frames skipped due to quota and dropped due to socket congestion */
+    u32                 delivered, skipped, dropped;
+
+}   vind_sub_t;
+
+/* ...connected client */
+typedef struct vind_client
+{
+    /* ...connection socket */
+    int                 fd;
+
+    /* ...connection failure indication (client is removed by the server thread) */
+    int                 dead;
+
+    /* ...subscriptions indexed by client camera number */
+    vind_sub_t          sub[VIND_SUBS_MAX];
+
+}   vind_client_t;
+
+/* ...capture device */
+typedef struct vind_device
+{
+    /* ...device name */
+    char               *name;
+
+    /* ...capture dimensions */
+    int                 width, height;
+
+    /* ...buffers pool (in allocation order) */
+    GstBuffer          *buffer[VIND_POOL_MAX];
+
+    /* ...number of allocated buffers */
+    int                 size;
+
+    /* ...number of buffers reserved by the clients */
+    int                 reserved;
+
+}   vind_device_t;
+
+/* ...daemon data */
+typedef struct vind
+{
+    /* ...VIN engine handle */
+    vin_data_t         *vin;
+
+    /* ...capture devices */
+    vind_device_t       dev[VIND_DEVICES_MAX];
+
+    /* ...number of capture devices */
+    int                 num;
+
+    /* ...listening socket and poll descriptor */
+    int                 lfd, efd;
+
+    /* ...connected clients */
+    vind_client_t      *client[VIND_CLIENTS_MAX];
+
+    /* ...clients table access lock */
+    pthread_mutex_t     lock;
+
+}   vind_t;
+
+/*******************************************************************************
+ * Global variables definitions
+ ******************************************************************************/
+
+/* ...log level */
+int     LOG_LEVEL = 1;
+
+/* ...capture devices names and dimensions (zero - default) */
+static char    *__vin_devices[VIND_DEVICES_MAX];
+static int      __vin_size[VIND_DEVICES_MAX][2];
+static int      __vin_num;
+
+/* ...default capture format */
+static int      __vin_width = 1280, __vin_height = 1080;
+static u32      __vin_format = V4L2_PIX_FMT_UYVY;
+
+/* ...number of buffers per device */
+static int      __vin_buffers_num = 8;
+
+/* ...socket path */
+static char    *__socket = VIN_PROTO_SOCKET;
+
+/*******************************************************************************
+ * Messages transmission
+ ******************************************************************************/
+
+/* ...send message with optional descriptor attached (never blocks) */
+static int vind_send(int fd, vin_msg_t *msg, int dmafd)
+{
+    struct iovec        iov = { .iov_base = msg, .iov_len = sizeof(*msg) };
+    struct msghdr       mh = { .msg_iov = &iov, .msg_iovlen = 1 };
+    union {
+        struct cmsghdr  h;
+        char            buf[CMSG_SPACE(sizeof(int))];
+    }                   ctl;
+    struct cmsghdr     *c;
+
+    /* ...attach descriptor as ancillary data */
+    if (dmafd >= 0)
+    {
+        memset(&ctl, 0, sizeof(ctl));
+        mh.msg_control = ctl.buf, mh.msg_controllen = sizeof(ctl.buf);
+        c = CMSG_FIRSTHDR(&mh);
+        c->cmsg_level = SOL_SOCKET, c->cmsg_type = SCM_RIGHTS;
+        c->cmsg_len = CMSG_LEN(sizeof(int));
+        memcpy(CMSG_DATA(c), &dmafd, sizeof(int));
+    }
+
+    CHK_ERR(sendmsg(fd, &mh, MSG_DONTWAIT | MSG_NOSIGNAL) == (ssize_t)sizeof(*msg), -errno);
+
+    return 0;
+}
+
+/* ...announce capture buffer to the client */
+static int vind_announce(vind_t *d, vind_client_t *c, int k, int j)
+{
+    vind_sub_t     *s = &c->sub[k];
+    GstBuffer      *buffer = d->dev[s->camera].buffer[j];
+    vsink_meta_t   *vmeta = gst_buffer_get_vsink_meta(buffer);
+    vin_msg_t       msg;
+    off_t           length;
+
+    CHK_ERR((length = lseek(vmeta->dmafd[0], 0, SEEK_END)) > 0, -errno);
+
+    memset(&msg, 0, sizeof(msg));
+    msg.type = VIN_MSG_BUFFER, msg.camera = (u32)k;
+    msg.buffer.index = (u32)j;
+    msg.buffer.width = (u32)d->dev[s->camera].width, msg.buffer.height = (u32)d->dev[s->camera].height;
+    msg.buffer.format = __vin_format, msg.buffer.length = (u32)length;
+
+    CHK_API(vind_send(c->fd, &msg, vmeta->dmafd[0]));
+
+    s->announced |= 1U << j;
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Capture interface
+ ******************************************************************************/
+
+/* ...register capture buffer (called during device initialization) */
+static int vind_alloc(void *data, int i, GstBuffer *buffer)
+{
+    vind_t         *d = data;
+    vind_device_t  *dev = &d->dev[i];
+    vsink_meta_t   *vmeta = gst_buffer_get_vsink_meta(buffer);
+
+    /* ...buffers are shared by descriptors only */
+    CHK_ERR(vmeta && vmeta->dmafd[0] >= 0, -(errno = ENOTSUP));
+    CHK_ERR(dev->size < VIND_POOL_MAX, -(errno = ENOMEM));
+
+    dev->buffer[dev->size++] = buffer;
+
+    return 0;
+}
+
+/* ...find index of the buffer in device pool */
+static inline int vind_buffer_index(vind_device_t *dev, GstBuffer *buffer)
+{
+    int     j;
+
+    for (j = 0; j < dev->size && dev->buffer[j] != buffer; j++)
+        ;
+
+    return (j < dev->size ? j : -1);
+}
+
+/* ...pass captured frame to the subscriber (called with a lock held) */
+static void vind_deliver(vind_t *d, vind_client_t *c, int k, int j, GstBuffer *buffer)
+{
+    vind_sub_t     *s = &c->sub[k];
+    vin_msg_t       msg;
+    int             r;
+
+    /* ...apply decimation ratio */
+    if (s->count++ % s->ratio)      return;
+
+    /* ...client holds all frames it may; skip frame rather than wait for it */
+    if (s->busy >= s->depth)
+    {
+        s->skipped++;
+        return;
+    }
+
+    /* ...pass buffer descriptor first time the buffer is used */
+    if ((s->announced & (1U << j)) == 0 && (r = vind_announce(d, c, k, j)) < 0)
+    {
+        goto error;
+    }
+
+    memset(&msg, 0, sizeof(msg));
+    msg.type = VIN_MSG_FRAME, msg.camera = (u32)k;
+    msg.frame.index = (u32)j;
+    msg.frame.sequence = (u32)GST_BUFFER_OFFSET(buffer);
+    msg.frame.ts = GST_BUFFER_PTS(buffer) / 1000;
+
+    if ((r = vind_send(c->fd, &msg, -1)) < 0)
+    {
+        goto error;
+    }
+
+    /* ...buffer is not requeued to the driver until client releases it */
+    s->held[j] = gst_buffer_ref(buffer), s->busy++;
+
+    if (++s->delivered % VIND_STATS_PERIOD == 0)
+    {
+        TRACE(INFO, _b("client-%d:%d: delivered=%u, skipped=%u, dropped=%u"), c->fd, k, s->delivered, s->skipped, s->dropped);
+    }
+
+    return;
+
+error:
+    /* ...socket queue is full - client is not reading; anything else is fatal */
+    (errno == EAGAIN || errno == EWOULDBLOCK ? s->dropped++ : (c->dead = 1));
+}
+
+/* ...process captured frame (called from capture thread) */
+static int vind_process(void *data, int i, GstBuffer *buffer)
+{
+    vind_t         *d = data;
+    int             j = vind_buffer_index(&d->dev[i], buffer);
+    int             n, k;
+
+    CHK_ERR(j >= 0, -(errno = EINVAL));
+
+    pthread_mutex_lock(&d->lock);
+
+    for (n = 0; n < VIND_CLIENTS_MAX; n++)
+    {
+        vind_client_t  *c = d->client[n];
+
+        if (!c || c->dead)      continue;
+
+        for (k = 0; k < VIND_SUBS_MAX; k++)
+        {
+            if (c->sub[k].camera == i)      vind_deliver(d, c, k, j, buffer);
+        }
+    }
+
+    pthread_mutex_unlock(&d->lock);
+
+    /* ...buffer is returned to the driver once all subscribers release it */
+    return 0;
+}
+
+/* ...capture callbacks */
+static camera_callback_t vind_cb = {
+    .allocate = vind_alloc,
+    .process = vind_process,
+};
+
+/*******************************************************************************
+ * Clients handling
+ ******************************************************************************/
+
+/* ...find capture device by name */
+static inline int vind_device_find(vind_t *d, const char *name)
+{
+    int     i;
+
+    for (i = 0; i < d->num && strcmp(d->dev[i].name, name); i++)
+        ;
+
+    return (i < d->num ? i : -1);
+}
+
+/* ...process subscription request (called with a lock held) */
+static int vind_subscribe(vind_t *d, vind_client_t *c, u32 k, vin_msg_subscribe_t *req)
+{
+    vind_sub_t     *s;
+    int             i;
+
+    CHK_ERR(req->version == VIN_PROTO_VERSION, -(errno = EPROTO));
+    CHK_ERR(k < VIND_SUBS_MAX && c->sub[k].camera < 0, -(errno = EINVAL));
+    CHK_ERR(req->depth > 0 && req->depth <= VIN_PROTO_DEPTH_MAX, -(errno = EINVAL));
+
+    /* ...find device and make sure format is what client expects */
+    req->name[VIN_PROTO_NAME_MAX - 1] = '\0';
+    CHK_ERR((i = vind_device_find(d, req->name)) >= 0, -(errno = ENODEV));
+    CHK_ERR(!req->width || req->width == (u32)d->dev[i].width, -(errno = EINVAL));
+    CHK_ERR(!req->height || req->height == (u32)d->dev[i].height, -(errno = EINVAL));
+    CHK_ERR(!req->format || req->format == __vin_format, -(errno = EINVAL));
+
+    /* ...driver must always keep enough buffers whatever clients do */
+    CHK_ERR(d->dev[i].reserved + (int)req->depth <= d->dev[i].size - VIND_DRIVER_RESERVE, -(errno = ENOSPC));
+
+    s = &c->sub[k];
+    memset(s, 0, sizeof(*s));
+    s->camera = i;
+    s->ratio = (req->ratio > 1 ? req->ratio : 1);
+    s->depth = req->depth;
+    d->dev[i].reserved += (int)req->depth;
+
+    TRACE(INFO, _b("client-%d:%u: subscribed to '%s' (ratio=%u, depth=%u)"), c->fd, k, req->name, s->ratio, s->depth);
+
+    return d->dev[i].size;
+}
+
+/* ...process frame release (called with a lock held; returns buffer to drop) */
+static GstBuffer * vind_release(vind_client_t *c, u32 k, u32 j)
+{
+    vind_sub_t     *s;
+    GstBuffer      *buffer;
+
+    CHK_ERR(k < VIND_SUBS_MAX && j < VIND_POOL_MAX, (errno = EINVAL, NULL));
+
+    s = &c->sub[k];
+    CHK_ERR(buffer = s->held[j], (errno = EINVAL, NULL));
+
+    s->held[j] = NULL, s->busy--;
+
+    return buffer;
+}
+
+/* ...process client message */
+static int vind_client_message(vind_t *d, vind_client_t *c)
+{
+    vin_msg_t       msg;
+    ssize_t         n;
+    GstBuffer      *buffer = NULL;
+    int             r = 0;
+
+    /* ...read single message (connection is closed by peer if nothing is read) */
+    CHK_ERR((n = recv(c->fd, &msg, sizeof(msg), MSG_DONTWAIT)) != 0, -(errno = ECONNRESET));
+    if (n < 0 && errno == EAGAIN)       return 0;
+    CHK_ERR(n == (ssize_t)sizeof(msg), -(errno = (n < 0 ? errno : EPROTO)));
+
+    pthread_mutex_lock(&d->lock);
+
+    switch (msg.type)
+    {
+    case VIN_MSG_SUBSCRIBE:
+        r = vind_subscribe(d, c, msg.camera, &msg.subscribe);
+        msg.type = VIN_MSG_ACK, msg.ack.result = (r < 0 ? -errno : r);
+        r = vind_send(c->fd, &msg, -1);
+        break;
+
+    case VIN_MSG_RELEASE:
+        buffer = vind_release(c, msg.camera, msg.release.index);
+        r = (buffer ? 0 : -errno);
+        break;
+
+    default:
+        TRACE(ERROR, _x("client-%d: unexpected message: %u"), c->fd, msg.type);
+        r = -(errno = EPROTO);
+    }
+
+    pthread_mutex_unlock(&d->lock);
+
+    /* ...buffer recycling takes capture group lock; do that outside of clients lock */
+    if (buffer)     gst_buffer_unref(buffer);
+
+    return CHK_API(r);
+}
+
+/* ...accept new client connection */
+static int vind_client_accept(vind_t *d)
+{
+    vind_client_t      *c;
+    struct epoll_event  event;
+    int                 fd, n, k;
+
+    CHK_ERR((fd = accept4(d->lfd, NULL, NULL, SOCK_CLOEXEC)) >= 0, -errno);
+
+    pthread_mutex_lock(&d->lock);
+
+    for (n = 0; n < VIND_CLIENTS_MAX && d->client[n]; n++)
+        ;
+
+    if (n == VIND_CLIENTS_MAX || (c = calloc(1, sizeof(*c))) == NULL)
+    {
+        pthread_mutex_unlock(&d->lock);
+        TRACE(ERROR, _x("client rejected: too many connections"));
+        close(fd);
+        return 0;
+    }
+
+    c->fd = fd;
+    for (k = 0; k < VIND_SUBS_MAX; k++)     c->sub[k].camera = -1;
+
+    /* ...poll source identifies client slot */
+    event.events = EPOLLIN, event.data.u32 = (u32)n;
+    if (epoll_ctl(d->efd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        pthread_mutex_unlock(&d->lock);
+        TRACE(ERROR, _x("failed to register client: %m"));
+        free(c), close(fd);
+        return 0;
+    }
+
+    d->client[n] = c;
+
+    pthread_mutex_unlock(&d->lock);
+
+    TRACE(INFO, _b("client-%d connected"), fd);
+
+    return 0;
+}
+
+/* ...remove client and return all frames it holds */
+static void vind_client_remove(vind_t *d, int n)
+{
+    vind_client_t  *c = d->client[n];
+    GstBuffer      *held[VIND_SUBS_MAX * VIND_POOL_MAX];
+    int             k, j, m = 0;
+
+    pthread_mutex_lock(&d->lock);
+
+    d->client[n] = NULL;
+
+    for (k = 0; k < VIND_SUBS_MAX; k++)
+    {
+        vind_sub_t     *s = &c->sub[k];
+
+        if (s->camera < 0)      continue;
+
+        for (j = 0; j < VIND_POOL_MAX; j++)
+        {
+            if (s->held[j])     held[m++] = s->held[j];
+        }
+
+        d->dev[s->camera].reserved -= (int)s->depth;
+
+        TRACE(INFO, _b("client-%d:%d: delivered=%u, skipped=%u, dropped=%u"), c->fd, k, s->delivered, s->skipped, s->dropped);
+    }
+
+    pthread_mutex_unlock(&d->lock);
+
+    /* ...return outstanding buffers to the driver */
+    while (m--)     gst_buffer_unref(held[m]);
+
+    epoll_ctl(d->efd, EPOLL_CTL_DEL, c->fd, NULL);
+    close(c->fd);
+
+    TRACE(INFO, _b("client-%d disconnected"), c->fd);
+
+    free(c);
+}
+
+/* ...server loop (accepts connections and processes clients requests) */
+static int vind_serve(vind_t *d)
+{
+    struct epoll_event  event[VIND_CLIENTS_MAX + 1];
+    int                 r, k, n;
+
+    while (1)
+    {
+        if ((r = epoll_wait(d->efd, event, VIND_CLIENTS_MAX + 1, -1)) < 0)
+        {
+            /* ...ignore soft interruptions */
+            if (errno == EINTR)     continue;
+            TRACE(ERROR, _x("poll failed: %m"));
+            return -errno;
+        }
+
+        for (k = 0; k < r; k++)
+        {
+            vind_client_t  *c;
+
+            if ((n = (int)event[k].data.u32) == VIND_CLIENTS_MAX)
+            {
+                (vind_client_accept(d) < 0 ? TRACE(ERROR, _x("accept failed: %m")) : 0);
+            }
+            else if ((c = d->client[n]) == NULL || c->dead)
+            {
+                /* ...client has failed already; ignore its events */
+                continue;
+            }
+            else if ((event[k].events & (EPOLLERR | EPOLLHUP)) || vind_client_message(d, c) < 0)
+            {
+                /* ...slot is released after the batch so that pending events cannot hit its new owner */
+                pthread_mutex_lock(&d->lock);
+                c->dead = 1;
+                pthread_mutex_unlock(&d->lock);
+            }
+        }
+
+        /* ...remove clients whose connection has failed */
+        for (n = 0; n < VIND_CLIENTS_MAX; n++)
+        {
+            if (d->client[n] && d->client[n]->dead)     vind_client_remove(d, n);
+        }
+    }
+}
+
+/* ...create listening socket */
+static int vind_listen(vind_t *d, const char *path)
+{
+    struct sockaddr_un  addr;
+    struct epoll_event  event;
+
+    CHK_ERR(strlen(path) < sizeof(addr.sun_path), -(errno = ENAMETOOLONG));
+    CHK_ERR((d->lfd = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0)) >= 0, -errno);
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    /* ...remove stale socket left by previous instance */
+    unlink(path);
+
+    CHK_API(bind(d->lfd, (struct sockaddr *)&addr, sizeof(addr)));
+    CHK_API(listen(d->lfd, VIND_CLIENTS_MAX));
+
+    CHK_ERR((d->efd = epoll_create1(EPOLL_CLOEXEC)) >= 0, -errno);
+    event.events = EPOLLIN, event.data.u32 = VIND_CLIENTS_MAX;
+    CHK_API(epoll_ctl(d->efd, EPOLL_CTL_ADD, d->lfd, &event));
+
+    TRACE(INIT, _b("listening on '%s'"), path);
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Parameters parsing
+ ******************************************************************************/
+
+/* ...parse capture format */
+static inline u32 parse_format(const char *str)
+{
+    if (!strcasecmp(str, "uyvy"))           return V4L2_PIX_FMT_UYVY;
+    else if (!strcasecmp(str, "yuyv"))      return V4L2_PIX_FMT_YUYV;
+    else if (!strcasecmp(str, "nv16"))      return V4L2_PIX_FMT_NV16;
+    else if (!strcasecmp(str, "nv12"))      return V4L2_PIX_FMT_NV12;
+    else                                    return 0;
+}
+
+static const struct option    options[] = {
+    {   "debug",    required_argument,  NULL,   'd' },
+    {   "vin",      required_argument,  NULL,   'v' },
+    {   "width",    required_argument,  NULL,   'w' },
+    {   "height",   required_argument,  NULL,   'h' },
+    {   "format",   required_argument,  NULL,   'f' },
+    {   "buffers",  required_argument,  NULL,   'n' },
+    {   "socket",   required_argument,  NULL,   's' },
+    {   NULL,       0,                  NULL,   0   },
+};
+
+static int parse_cmdline(int argc, char **argv)
+{
+    int     index = 0;
+    int     opt;
+    char   *s;
+
+    while ((opt = getopt_long(argc, argv, "d:v:w:h:f:n:s:", options, &index)) >= 0)
+    {
+        switch (opt)
+        {
+        case 'd':
+            LOG_LEVEL = atoi(optarg);
+            break;
+
+        case 'v':
+            for (s = strtok(optarg, ","); s; s = strtok(NULL, ","))
+            {
+                char   *p = strchr(s, '@');
+
+                /* ...optional per-device dimensions ("device@WxH") */
+                CHK_ERR(__vin_num < VIND_DEVICES_MAX, -(errno = EINVAL));
+                (p ? *p++ = '\0', sscanf(p, "%dx%d", &__vin_size[__vin_num][0], &__vin_size[__vin_num][1]) : 0);
+                __vin_devices[__vin_num++] = s;
+            }
+            break;
+
+        case 'w':
+            CHK_ERR((u32)(__vin_width = atoi(optarg)) < 4096, -(errno = EINVAL));
+            break;
+
+        case 'h':
+            CHK_ERR((u32)(__vin_height = atoi(optarg)) < 4096, -(errno = EINVAL));
+            break;
+
+        case 'f':
+            CHK_ERR(__vin_format = parse_format(optarg), -(errno = EINVAL));
+            break;
+
+        case 'n':
+            CHK_ERR((__vin_buffers_num = atoi(optarg)) > VIND_DRIVER_RESERVE && __vin_buffers_num <= VIND_POOL_MAX, -(errno = EINVAL));
+            break;
+
+        case 's':
+            __socket = optarg;
+            break;
+
+        default:
+            return -EINVAL;
+        }
+    }
+
+    /* ...at least one device must be given */
+    CHK_ERR(__vin_num > 0, -(errno = EINVAL));
+
+    return 0;
+}
+
+/*******************************************************************************
+ * Entry point
+ ******************************************************************************/
+
+int main(int argc, char **argv)
+{
+    static vind_t   d;
+    int             i;
+
+    TRACE_INIT("VIN capture daemon");
+
+    gst_init(&argc, &argv);
+
+    CHK_API(parse_cmdline(argc, argv));
+
+    pthread_mutex_init(&d.lock, NULL);
+
+    /* ...open capture devices */
+    for (i = 0, d.num = __vin_num; i < d.num; i++)
+    {
+        d.dev[i].name = __vin_devices[i];
+        d.dev[i].width = (__vin_size[i][0] > 0 ? __vin_size[i][0] : __vin_width);
+        d.dev[i].height = (__vin_size[i][1] > 0 ? __vin_size[i][1] : __vin_height);
+    }
+
+    CHK_ERR(d.vin = vin_init(__vin_devices, d.num, &vind_cb, &d), -errno);
+
+    for (i = 0; i < d.num; i++)
+    {
+        CHK_API(vin_device_init(d.vin, i, d.dev[i].width, d.dev[i].height, __vin_format, __vin_buffers_num));
+    }
+
+    /* ...accept clients before frames start flowing */
+    CHK_API(vind_listen(&d, __socket));
+    CHK_API(vin_start(d.vin));
+
+    TRACE(INIT, _b("capture daemon started: %d devices, %c%c%c%c, %d buffers"),
+          d.num, __v4l2_fmt(__vin_format), __vin_buffers_num);
+
+    return vind_serve(&d);
+}
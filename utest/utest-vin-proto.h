@@ -0,0 +1,143 @@
+/*******************************************************************************
+ * utest-vin-proto.h
+ *
+ * VIN capture daemon protocol
+ *
+ * Copyright (c) 2016 Cogent Embedded Inc. ALL RIGHTS RESERVED.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ *******************************************************************************/
+
+#ifndef __UTEST_VIN_PROTO_H
+#define __UTEST_VIN_PROTO_H
+
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "utest-common.h"
+
+/*******************************************************************************
+ * Protocol description
+ *
+ * Daemon owns VIN devices and listens on a SOCK_SEQPACKET Unix socket. Client
+ * subscribes to a camera by its device name, specifying decimation ratio and
+ * maximal number of frames it may hold. Every capture buffer is announced to
+ * the client once, with its DMABUF descriptor attached (SCM_RIGHTS); frames
+ * are then passed by buffer index. Client returns each frame with a release
+ * message; frames exceeding client quota or not fitting into socket queue are
+ * skipped for that client only, so slow client never stalls capture.
+ ******************************************************************************/
+
+/* ...protocol revision */
+#define VIN_PROTO_VERSION               1
+
+/* ...default socket path */
+#define VIN_PROTO_SOCKET                "/tmp/vind.sock"
+
+/* ...maximal length of device name */
+#define VIN_PROTO_NAME_MAX              64
+
+/* ...maximal number of frames held by a client per camera */
+#define VIN_PROTO_DEPTH_MAX             4
+
+/* ...message types */
+enum {
+    VIN_MSG_SUBSCRIBE,
+    VIN_MSG_RELEASE,
+    VIN_MSG_ACK,
+    VIN_MSG_BUFFER,
+    VIN_MSG_FRAME,
+};
+
+/* ...client subscription (client -> daemon) */
+typedef struct vin_msg_subscribe
+{
+    /* ...protocol revision */
+    u32                 version;
+
+    /* ...decimation ratio (pass every N-th frame) and maximal number of frames held */
+    u32                 ratio, depth;
+
+    /* ...expected buffer format */
+    u32                 width, height, format;
+
+    /* ...capture device name */
+    char                name[VIN_PROTO_NAME_MAX];
+
+}   vin_msg_subscribe_t;
+
+/* ...subscription result (daemon -> client) */
+typedef struct vin_msg_ack
+{
+    /* ...negative error code or buffer pool size */
+    s32                 result;
+
+}   vin_msg_ack_t;
+
+/* ...capture buffer announcement with DMABUF descriptor attached (daemon -> client) */
+typedef struct vin_msg_buffer
+{
+    /* ...buffer index in the pool */
+    u32                 index;
+
+    /* ...buffer format and length */
+    u32                 width, height, format, length;
+
+}   vin_msg_buffer_t;
+
+/* ...captured frame (daemon -> client) */
+typedef struct vin_msg_frame
+{
+    /* ...buffer index and capture sequence number */
+    u32                 index, sequence;
+
+    /* ...capture timestamp (us) */
+    u64                 ts;
+
+}   vin_msg_frame_t;
+
+/* ...frame release (client -> daemon) */
+typedef struct vin_msg_release
+{
+    /* ...buffer index */
+    u32                 index;
+
+}   vin_msg_release_t;
+
+/* ...protocol message */
+typedef struct vin_msg
+{
+    /* ...message type */
+    u32                 type;
+
+    /* ...subscription identifier (client camera index) */
+    u32                 camera;
+
+    union {
+        vin_msg_subscribe_t     subscribe;
+        vin_msg_ack_t           ack;
+        vin_msg_buffer_t        buffer;
+        vin_msg_frame_t         frame;
+        vin_msg_release_t       release;
+    };
+
+}   vin_msg_t;
+
+#endif  /* __UTEST_VIN_PROTO_H */
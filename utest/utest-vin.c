@@ -30,14 +30,20 @@
  * Includes
  ******************************************************************************/
 
+#define _GNU_SOURCE
+
 #include "sv/trace.h"
 #include "utest-common.h"
 #include "utest-camera.h"
 #include "utest-vsink.h"
+#include "utest-vin.h"
+#include "utest-stamp.h"
+#include "utest-recorder.h"
 #include <fcntl.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <sys/epoll.h>
+#include <sys/eventfd.h>
 #include <linux/version.h>
 #include <linux/videodev2.h>
 
@@ -56,6 +62,21 @@ TRACE_TAG(DEBUG, 1);
 /* ...individual camera buffer pool size */
 #define VIN_BUFFER_POOL_SIZE            5
 
+/* ...maximal camera buffer pool size */
+#define VIN_BUFFER_POOL_MAX             VIDEO_MAX_FRAME
+
+/* ...statistics reporting period (in frames) */
+#define VIN_STATS_PERIOD                1024
+
+/* ...maximal number of capture threads */
+#define VIN_GROUPS_MAX                  8
+
+/* ...maximal time to wait for consumers to return buffers on pool resize (ms) */
+#define VIN_RESIZE_TIMEOUT              500
+
+/* ...poll-source identifier of the capture thread wake-up event */
+#define VIN_EVENT_KICK                  ((u32)~0U)
+
 /* ...external VIN device names */
 extern char * vin_devices[CAMERAS_NUMBER];
 
@@ -75,14 +96,55 @@ typedef struct vin_buffer
     /* ...buffer length */
     u32                 length;
 
+    /* ...exported DMABUF descriptor (negative - not supported by the driver) */
+    int                 dmafd;
+
     /* ...associated GStreamer buffer */
     GstBuffer          *buffer;
+
+    /* ...buffer is owned by application */
+    int                 busy;
     
 }   vin_buffer_t;
 
+/* ...capture thread servicing a group of devices */
+typedef struct vin_group
+{
+    /* ...module back-pointer */
+    struct vin_data        *vin;
+
+    /* ...mask of devices serviced by the thread */
+    u32                     devices;
+
+    /* ...number of devices in a group */
+    int                     num;
+
+    /* ...epoll-descriptor */
+    int                     efd;
+
+    /* ...wake-up event descriptor */
+    int                     evfd;
+
+    /* ...CPU affinity mask (zero - no affinity) */
+    u32                     cpus;
+
+    /* ...SCHED_FIFO priority (zero - default scheduling policy) */
+    int                     priority;
+
+    /* ...group data access lock */
+    pthread_mutex_t         lock;
+
+    /* ...capture thread */
+    pthread_t               thread;
+
+}   vin_group_t;
+
 /* ...particular video device */
 typedef struct vin_device
 {
+    /* ...capture thread group */
+    vin_group_t            *group;
+
     /* ...V4L2 device descriptor */
     int                     vfd;
 
@@ -92,9 +154,16 @@ typedef struct vin_device
     /* ...buffers pool */
     vin_buffer_t           *pool;
 
+    /* ...buffer dimensions and V4L2 format */
+    int                     width, height;
+    u32                     format;
+
     /* ...streaming status */
     int                     active;
 
+    /* ...buffers pool release flag */
+    int                     release;
+
     /* ...number of submitted buffers */
     int                     submitted;
 
@@ -104,6 +173,18 @@ typedef struct vin_device
     /* ...conditional variable for busy buffers collection */
     pthread_cond_t          wait;
 
+    /* ...sequence number of last dequeued buffer */
+    u32                     sequence;
+
+    /* ...maximal number of buffers owned by consumer in latest-frame mode (zero - disabled) */
+    int                     latest;
+
+    /* ...index of the frame withheld from consumer (negative - none) */
+    int                     pending;
+
+    /* ...capture statistics */
+    vin_stats_t             stats;
+
 }   vin_device_t;
     
 /* ...decoder data structure */   
@@ -112,8 +193,11 @@ typedef struct vin_data
     /* ...GStreamer bin element for pipeline handling */
     GstElement                 *bin;
 
-    /* ...single epoll-descriptor */
-    int                         efd;
+    /* ...capture threads (first one services all unassigned devices) */
+    vin_group_t                 group[VIN_GROUPS_MAX];
+
+    /* ...number of capture threads */
+    int                         groups;
 
     /* ...number of devices connected */
     int                         num;
@@ -130,12 +214,6 @@ typedef struct vin_data
     /* ...decoder activity state */
     int                         active;
 
-    /* ...queue access lock */
-    pthread_mutex_t             lock;
-
-    /* ...decoding thread - tbd - make it a data source for GMainLoop? */
-    pthread_t                   thread;
-
     /* ...decoding thread conditional variable */
     pthread_cond_t              wait;
 
@@ -321,6 +399,7 @@ static inline int vin_allocate_buffers(int vfd, vin_buffer_t *pool, int num)
 {
     struct v4l2_requestbuffers  reqbuf;
     struct v4l2_buffer          buf;
+    struct v4l2_exportbuffer    exp;
     int                         j;
     
     /* ...all buffers are allocated by kernel */
@@ -347,7 +426,14 @@ static inline int vin_allocate_buffers(int vfd, vin_buffer_t *pool, int num)
         _buf->data = mmap(NULL, _buf->length, PROT_READ | PROT_WRITE, MAP_SHARED, vfd, _buf->offset);
         CHK_ERR(_buf->data != MAP_FAILED, -errno);
 
-        TRACE(DEBUG, _b("output-buffer-%d mapped: %p[%08X] (%u bytes)"), j, _buf->data, _buf->offset, _buf->length);
+        /* ...export buffer for zero-copy sharing with other processes (optional) */
+        memset(&exp, 0, sizeof(exp));
+        exp.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+        exp.index = j;
+        exp.flags = O_RDWR | O_CLOEXEC;
+        _buf->dmafd = (ioctl(vfd, VIDIOC_EXPBUF, &exp) == 0 ? exp.fd : -1);
+
+        TRACE(DEBUG, _b("output-buffer-%d mapped: %p[%08X] (%u bytes, dmafd=%d)"), j, _buf->data, _buf->offset, _buf->length, _buf->dmafd);
     }
 
     /* ...start streaming as soon as we allocated buffers */
@@ -367,10 +453,11 @@ static inline int vin_destroy_buffers(int vfd, vin_buffer_t *pool, int num)
     /* ...stop streaming before doing anything */
     CHK_API(vin_streaming_enable(vfd, 0));
 
-    /* ...unmap all buffers */
+    /* ...unmap all buffers and close exported descriptors */
     for (j = 0; j < num; j++)
     {
         munmap(pool[j].data, pool[j].length);
+        (pool[j].dmafd >= 0 ? close(pool[j].dmafd) : 0);
     }
     
     /* ...release kernel-allocated buffers */
@@ -401,7 +488,7 @@ static inline int vin_output_buffer_enqueue(int vfd, int j)
 }
 
 /* ...dequeue input buffer */
-static inline int vin_output_buffer_dequeue(int vfd, u64 *ts, u32 *seq)
+static inline int vin_output_buffer_dequeue(int vfd, u64 *ts, u32 *seq, u32 *flags)
 {
     struct v4l2_buffer  buf;
 
@@ -412,11 +499,44 @@ static inline int vin_output_buffer_dequeue(int vfd, u64 *ts, u32 *seq)
     CHK_API(ioctl(vfd, VIDIOC_DQBUF, &buf));
     (ts ? *ts = buf.timestamp.tv_sec * 1000000ULL + buf.timestamp.tv_usec : 0);
     (seq ? *seq = buf.sequence : 0);
+    (flags ? *flags = buf.flags : 0);
     
     return buf.index;
 }
 
 
+/*******************************************************************************
+ * Capture statistics
+ ******************************************************************************/
+
+/* ...update device statistics upon buffer dequeuing (called with a lock held) */
+static inline void __stats_update(vin_device_t *dev, int i, u32 seq, u32 flags)
+{
+    vin_stats_t    *stats = &dev->stats;
+
+    /* ...detect sequence gaps (driver has lost frames) */
+    if (stats->frames && seq != dev->sequence + 1)
+    {
+        TRACE(DEBUG, _b("vin-%d: sequence gap: %u -> %u"), i, dev->sequence, seq);
+
+        /* ...account missed frames; sequence reset is treated as a single gap */
+        stats->gaps++, stats->lost += (seq > dev->sequence ? seq - dev->sequence - 1 : 1);
+    }
+
+    /* ...driver has reported buffer corruption */
+    (flags & V4L2_BUF_FLAG_ERROR ? stats->errors++ : 0);
+
+    /* ...latch sequence number */
+    dev->sequence = seq;
+
+    /* ...report statistics periodically */
+    if (++stats->frames % VIN_STATS_PERIOD == 0)
+    {
+        TRACE(INFO, _b("vin-%d: frames=%u, gaps=%u, lost=%u, errors=%u, dropped=%u, skipped=%u, starved=%u"),
+              i, stats->frames, stats->gaps, stats->lost, stats->errors, stats->dropped, stats->skipped, stats->starved);
+    }
+}
+
 /*******************************************************************************
  * V4L2 decoder thread
  ******************************************************************************/
@@ -431,13 +551,28 @@ static inline int __register_poll(vin_data_t *vin, int i, int add)
     event.events = EPOLLIN, event.data.u32 = (u32)i;
 
     /* ...add/remove source */
-    CHK_API(epoll_ctl(vin->efd, (add ? EPOLL_CTL_ADD : EPOLL_CTL_DEL), dev->vfd, &event));
+    CHK_API(epoll_ctl(dev->group->efd, (add ? EPOLL_CTL_ADD : EPOLL_CTL_DEL), dev->vfd, &event));
 
     TRACE(DEBUG, _b("#%d: poll source %s"), i, (add ? "added" : "removed"));
 
     return 0;
 }
 
+/* ...create capture thread wake-up event */
+static inline int __register_kick(vin_group_t *group)
+{
+    struct epoll_event  event;
+
+    /* ...create non-blocking event descriptor */
+    CHK_ERR((group->evfd = eventfd(0, EFD_NONBLOCK)) >= 0, -errno);
+
+    /* ...add descriptor to the group poll set */
+    event.events = EPOLLIN, event.data.u32 = VIN_EVENT_KICK;
+    CHK_API(epoll_ctl(group->efd, EPOLL_CTL_ADD, group->evfd, &event));
+
+    return 0;
+}
+
 /* ...submit buffer to the device (called with a decoder lock held) */
 static inline int __submit_buffer(vin_data_t *vin, int i, int j)
 {
@@ -457,23 +592,53 @@ static inline int __submit_buffer(vin_data_t *vin, int i, int j)
     return 0;
 }
 
-/* ...buffer processing function */
+/* ...pass buffer to the application (called with a group lock held) */
+static inline int __deliver_buffer(vin_data_t *vin, int i, int j)
+{
+    vin_device_t   *dev = &vin->dev[i];
+    GstBuffer      *buffer = dev->pool[j].buffer;
+
+    /* ...advance number of busy buffers */
+    dev->busy++, dev->pool[j].busy = 1;
+
+    /* ...release lock before passing buffer to the application */
+    pthread_mutex_unlock(&dev->group->lock);
+
+    /* ...pass output buffer to application */
+    CHK_API(vin->cb->process(vin->cdata, i, buffer));
+
+    /* ...drop the reference (buffer is now owned by application) */
+    gst_buffer_unref(buffer);
+
+    /* ...reacquire data access lock */
+    pthread_mutex_lock(&dev->group->lock);
+    
+    return 0;
+}
+
+/* ...buffer processing function (called with a group lock held) */
 static inline int __process_buffer(vin_data_t *vin, int i)
 {
     vin_device_t   *dev = &vin->dev[i];
     GstBuffer      *buffer;
     int             j;
     u64             ts;
-    u32             seq;
+    u32             seq, flags;
     
-    /* ...if streaming is disabled already, bail out (hmm - tbd) */
-    BUG(!dev->active, _x("vin-%d: invalid state"), i);
+    /* ...poll event may be stale if pool is being resized */
+    if (!dev->active)       return 0;
 
-    /* ...get buffer from a device */
-    CHK_API(j = vin_output_buffer_dequeue(dev->vfd, &ts, &seq));
+    /* ...get buffer from a device (poll event may be stale if pool has been reallocated) */
+    if ((j = vin_output_buffer_dequeue(dev->vfd, &ts, &seq, &flags)) < 0)
+    {
+        return (errno == EAGAIN ? 0 : j);
+    }
 
-    /* ...remove poll-source if last buffer is dequeued */
-    (--dev->submitted == 0 ? __register_poll(vin, i, 0) : 0);
+    /* ...update capture statistics */
+    __stats_update(dev, i, seq, flags);
+
+    /* ...remove poll-source if last buffer is dequeued (driver is starving) */
+    (--dev->submitted == 0 ? __register_poll(vin, i, 0), dev->stats.starved++ : 0);
 
     /* ...get buffer descriptor */
     buffer = dev->pool[j].buffer;
@@ -481,35 +646,70 @@ static inline int __process_buffer(vin_data_t *vin, int i)
     /* ...set decoding/presentation timestamp (in nanoseconds) */
     GST_BUFFER_DTS(buffer) = GST_BUFFER_PTS(buffer) = ts * 1000;
 
+    /* ...tag buffer with frame identity and open its timing record */
+    GST_BUFFER_OFFSET(buffer) = stamp_frame_id(i, seq);
+    stamp_frame(buffer, i, seq, ts);
+    recorder_event(REC_VIN_DEQUEUE, i, seq);
+
     TRACE(DEBUG, _b("dequeued buffer #<%d,%d>, ts=%zu, seq=%u, submitted=%d"), i, j, ts, seq, dev->submitted);
 
-    /* ...advance number of busy buffers */
-    dev->busy++;
+    /* ...in latest-frame mode withhold the buffer if consumer is still busy */
+    if (dev->latest && dev->busy >= dev->latest)
+    {
+        /* ...previously withheld frame is outdated; return it to the driver right away */
+        if (dev->pending >= 0)
+        {
+            TRACE(DEBUG, _b("vin-%d: frame #%d superseded"), i, dev->pending);
+            CHK_API(__submit_buffer(vin, i, dev->pending));
+            dev->stats.skipped++;
+        }
 
-    /* ...release lock before passing buffer to the application */
-    pthread_mutex_unlock(&vin->lock);
+        /* ...keep the newest frame until consumer releases a buffer */
+        dev->pending = j;
 
-    /* ...pass output buffer to application */
-    CHK_API(vin->cb->process(vin->cdata, i, buffer));
+        return 0;
+    }
 
-    /* ...drop the reference (buffer is now owned by application) */
-    gst_buffer_unref(buffer);
+    return __deliver_buffer(vin, i, j);
+}
+
+/* ...deliver withheld frames to the consumers that became ready (called with a group lock held) */
+static inline int __process_pending(vin_data_t *vin, vin_group_t *group)
+{
+    u64     v;
+    int     i, j;
+
+    /* ...clear wake-up event */
+    CHK_ERR(read(group->evfd, &v, sizeof(v)) == sizeof(v) || errno == EAGAIN, -errno);
+
+    for (i = 0; i < vin->num; i++)
+    {
+        vin_device_t   *dev = &vin->dev[i];
+
+        /* ...skip devices from other groups and those not having a frame withheld */
+        if (dev->group != group || dev->pending < 0)    continue;
+
+        /* ...skip device if consumer is still busy */
+        if (!dev->active || dev->busy >= dev->latest)   continue;
+
+        /* ...pass the frame to the application */
+        j = dev->pending, dev->pending = -1;
+        CHK_API(__deliver_buffer(vin, i, j));
+    }
 
-    /* ...reacquire data access lock */
-    pthread_mutex_lock(&vin->lock);
-    
     return 0;
 }
 
-/* ...decoding thread */
+/* ...decoding thread (services single group of devices) */
 static void * vin_thread(void *arg)
 {
-    vin_data_t         *vin = arg;
-    struct epoll_event  event[vin->num];
+    vin_group_t        *group = arg;
+    vin_data_t         *vin = group->vin;
+    struct epoll_event  event[group->num + 1];
 
     /* ...lock internal data access */
     pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-    pthread_mutex_lock(&vin->lock);
+    pthread_mutex_lock(&group->lock);
 
     /* ...start processing loop */
     while (1)
@@ -517,19 +717,19 @@ static void * vin_thread(void *arg)
         int     r, k;
         
         /* ...release the lock before going to waiting state */
-        pthread_mutex_unlock(&vin->lock);
+        pthread_mutex_unlock(&group->lock);
         pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 
         TRACE(DEBUG, _b("start waiting..."));
         
         /* ...wait for event (infinite timeout) */
-        r = epoll_wait(vin->efd, event, vin->num, -1);
+        r = epoll_wait(group->efd, event, group->num + 1, -1);
 
         TRACE(DEBUG, _b("done waiting: %d"), r);
 
         /* ...reacquire the lock */
         pthread_setcancelstate(PTHREAD_CANCEL_DISABLE, NULL);
-        pthread_mutex_lock(&vin->lock);
+        pthread_mutex_lock(&group->lock);
 
         /* ...check operation result */
         if (r < 0)
@@ -545,8 +745,16 @@ static void * vin_thread(void *arg)
         {
             int     i = (int)event[k].data.u32;
 
-            /* ...process output buffers */
-            if (event[k].events & EPOLLIN)
+            /* ...process wake-up request */
+            if (event[k].data.u32 == VIN_EVENT_KICK)
+            {
+                if (__process_pending(vin, group) < 0)
+                {
+                    TRACE(ERROR, _x("processing failed: %m"));
+                    goto out;
+                }
+            }
+            else if (event[k].events & EPOLLIN)
             {
                 if (__process_buffer(vin, i) < 0)
                 {
@@ -563,7 +771,7 @@ static void * vin_thread(void *arg)
 
 out:
     /* ...release access lock */
-    pthread_mutex_unlock(&vin->lock);
+    pthread_mutex_unlock(&group->lock);
     pthread_setcancelstate(PTHREAD_CANCEL_ENABLE, NULL);
 
     TRACE(INIT, _b("thread exits: %m"));
@@ -572,25 +780,92 @@ out:
 }
 
 
+/* ...create capture thread for a group of devices */
+static int __group_start(vin_data_t *vin, vin_group_t *group)
+{
+    int             id = (int)(group - vin->group);
+    thread_cfg_t    cfg = {
+        .cpus = group->cpus,
+        .policy = (group->priority > 0 ? SCHED_FIFO : SCHED_OTHER),
+        .priority = group->priority,
+    };
+    char            name[16];
+
+    sprintf(name, "vin-%d", id);
+
+    /* ...create V4L2 thread to asynchronously process input buffers (command-line settings take precedence) */
+    CHK_API(thread_create(&group->thread, name, 128 << 10, (group->cpus || group->priority ? &cfg : NULL), vin_thread, group));
+
+    TRACE(INIT, _b("vin-group-%d: devices=%X, cpus=%X, priority=%d"), id, group->devices, group->cpus, group->priority);
+
+    return 0;
+}
+
 /* ...start module operation */
 int vin_start(vin_data_t *vin)
 {
-    pthread_attr_t  attr;
-    int             r;
+    int     g;
     
     /* ...mark module is active */
     vin->active = 1;
 
-    /* ...initialize thread attributes (joinable, 128KB stack) */
-    pthread_attr_init(&attr);
-    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_JOINABLE);
-    pthread_attr_setstacksize(&attr, 128 << 10);
+    /* ...start all non-empty capture groups */
+    for (g = 0; g < vin->groups; g++)
+    {
+        CHK_API(vin->group[g].num ? __group_start(vin, &vin->group[g]) : 0);
+    }
 
-    /* ...create V4L2 thread to asynchronously process input buffers */
-    r = pthread_create(&vin->thread, &attr, vin_thread, vin);
-    pthread_attr_destroy(&attr);
+    return 0;
+}
 
-    return CHK_API(r);
+/* ...assign a group of devices to a dedicated capture thread */
+int vin_thread_setup(vin_data_t *vin, const vin_thread_cfg_t *cfg)
+{
+    vin_group_t            *group;
+    pthread_mutexattr_t     attr;
+    int                     i;
+
+    /* ...threads configuration must precede devices initialization */
+    CHK_ERR(!vin->active, -(errno = EBUSY));
+    CHK_ERR(vin->groups < VIN_GROUPS_MAX, -(errno = ENOMEM));
+    CHK_ERR(cfg->devices && (cfg->devices >> vin->num) == 0, -(errno = EINVAL));
+
+    /* ...make sure none of the devices is running yet */
+    for (i = 0; i < vin->num; i++)
+    {
+        CHK_ERR(!(cfg->devices & (1 << i)) || !vin->dev[i].pool, -(errno = EBUSY));
+    }
+
+    /* ...create new group */
+    group = &vin->group[vin->groups];
+    CHK_ERR((group->efd = epoll_create(vin->num)) >= 0, -errno);
+    CHK_API(__register_kick(group));
+    group->vin = vin;
+    group->devices = cfg->devices;
+    group->cpus = cfg->cpus;
+    group->priority = cfg->priority;
+
+    /* ...initialize group access lock */
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&group->lock, &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    /* ...move devices from their current groups */
+    for (i = 0; i < vin->num; i++)
+    {
+        vin_device_t   *dev = &vin->dev[i];
+
+        if (cfg->devices & (1 << i))
+        {
+            dev->group->devices &= ~(1 << i), dev->group->num--;
+            dev->group = group, group->num++;
+        }
+    }
+
+    TRACE(INIT, _b("vin-group-%d created: devices=%X"), vin->groups, group->devices);
+
+    return vin->groups++;
 }
 
 /*******************************************************************************
@@ -610,22 +885,30 @@ static gboolean __output_buffer_dispose(GstMiniObject *obj)
     /* ...verify buffer validity */
     BUG((u32)i >= (u32)vin->num || (u32)j >= (u32)dev->size, _x("invalid buffer: <%d,%d>"), i, j);
 
-    /* ...lock internal data access */
-    pthread_mutex_lock(&vin->lock);
+    /* ...lock device group data access */
+    pthread_mutex_lock(&dev->group->lock);
 
-    /* ...decrement amount of outstanding buffers */
-    dev->busy--;
+    /* ...decrement amount of outstanding buffers (pool own references are not accounted) */
+    (dev->release ? 0 : (dev->busy--, dev->pool[j].busy = 0));
 
     TRACE(DEBUG, _b("output buffer #<%d:%d> (%p) returned to pool (busy: %d)"), i, j, buffer, dev->busy);
 
     /* ...check if buffer needs to be requeued into the pool */
-    if (vin->active)
+    if (vin->active && !dev->release)
     {
         /* ...increment buffer reference */
         gst_buffer_ref(buffer);
 
         /* ...if streaming is enabled, submit buffer */
         (dev->active ? __submit_buffer(vin, i, j) : 0);
+
+        /* ...wake up capture thread if a withheld frame can be delivered now */
+        if (dev->pending >= 0 && dev->busy < dev->latest)
+        {
+            u64     v = 1;
+
+            (write(dev->group->evfd, &v, sizeof(v)) < 0 ? TRACE(ERROR, _x("vin-%d: wake-up failed: %m"), i) : 0);
+        }
         
         /* ...indicate the miniobject should not be freed */
         destroy = FALSE;
@@ -633,9 +916,6 @@ static gboolean __output_buffer_dispose(GstMiniObject *obj)
     else
     {
         TRACE(DEBUG, _b("buffer %p is freed"), buffer);
- 
-        /* ...signal flushing completion operation */
-        (dev->busy == 0 ? pthread_cond_signal(&vin->wait) : 0);
 
         /* ...reset buffer pointer to indicate it's destroyed */
         dev->pool[j].buffer = NULL;
@@ -644,28 +924,27 @@ static gboolean __output_buffer_dispose(GstMiniObject *obj)
         destroy = TRUE;
     }
 
+    /* ...signal flushing completion operation */
+    (!dev->active && dev->busy == 0 ? pthread_cond_broadcast(&dev->wait) : 0);
+
     /* ...release data access lock */
-    pthread_mutex_unlock(&vin->lock);
+    pthread_mutex_unlock(&dev->group->lock);
     
     return destroy;
 }
 
 
-/* ...runtime initialization */
-int vin_device_init(vin_data_t *vin, int i, int w, int h, u32 fmt, int size)
+/* ...create buffer pool of the device (called with a group lock held) */
+static int __device_pool_create(vin_data_t *vin, int i, int size)
 {
     vin_device_t   *dev = &vin->dev[i];
-    int         j;
-
-    /* ...make sure we have proper index */
-    CHK_ERR((u32)i < (u32)vin->num, -(errno = EINVAL));
+    int             w = dev->width, h = dev->height;
+    u32             fmt = dev->format;
+    int             j;
 
     /* ...create buffer pool */
     CHK_ERR(dev->pool = calloc(dev->size = size, sizeof(*dev->pool)), -(errno = ENOMEM));
 
-    /* ...set VIN format */
-    CHK_API(vin_set_formats(dev->vfd, w, h, fmt));
-
     /* ...allocate output buffers */
     CHK_API(vin_allocate_buffers(dev->vfd, dev->pool, size));
     
@@ -694,7 +973,7 @@ int vin_device_init(vin_data_t *vin, int i, int w, int h, u32 fmt, int size)
         vmeta->width = w;
         vmeta->height = h;
         vmeta->format = __pixfmt_v4l2_to_gst(fmt);
-        vmeta->dmafd[0] = -1;
+        vmeta->dmafd[0] = buf->dmafd;
         vmeta->dmafd[1] = -1;
         vmeta->plane[0] = buf->data;
         vmeta->plane[1] = NULL;
@@ -713,12 +992,137 @@ int vin_device_init(vin_data_t *vin, int i, int w, int h, u32 fmt, int size)
         __submit_buffer(vin, i, j);
     }
 
+    return 0;
+}
+
+/* ...runtime initialization */
+int vin_device_init(vin_data_t *vin, int i, int w, int h, u32 fmt, int size)
+{
+    vin_device_t   *dev = &vin->dev[i];
+    int             r;
+
+    /* ...make sure we have proper index */
+    CHK_ERR((u32)i < (u32)vin->num, -(errno = EINVAL));
+
+    /* ...save buffers format */
+    dev->width = w, dev->height = h, dev->format = fmt;
+
+    /* ...no frame is withheld */
+    dev->pending = -1;
+
+    /* ...set VIN format */
+    CHK_API(vin_set_formats(dev->vfd, w, h, fmt));
+
+    /* ...create buffer pool */
+    pthread_mutex_lock(&dev->group->lock);
+    r = __device_pool_create(vin, i, size);
+    pthread_mutex_unlock(&dev->group->lock);
+
+    CHK_API(r);
+
     TRACE(INIT, _b("vin-%d runtime initialized: %d*%d %c%c%c%c (%d)"), i, w, h, __v4l2_fmt(fmt), size);
 
     return 0;
 }
 
-/* ...close VIN device (called with lock held) */
+/* ...change depth of the device buffer pool at runtime (caller must not hold device buffers) */
+/* ...note - drain needs consumers progress; resize is aborted if buffers are not returned in time */
+int vin_device_resize(vin_data_t *vin, int i, int size)
+{
+    vin_device_t   *dev = &vin->dev[i];
+    struct timespec ts;
+    u32             t0, t1;
+    int             j, r = 0;
+
+    /* ...make sure we have proper index and device is running */
+    CHK_ERR((u32)i < (u32)vin->num && dev->pool, -(errno = EINVAL));
+
+    /* ...pool must be able to hold consumer buffers */
+    CHK_ERR(size > dev->latest && size <= VIN_BUFFER_POOL_MAX, -(errno = EINVAL));
+
+    pthread_mutex_lock(&dev->group->lock);
+
+    /* ...bail out if nothing changes */
+    if (size == dev->size)
+    {
+        pthread_mutex_unlock(&dev->group->lock);
+        return 0;
+    }
+
+    t0 = __get_time_usec();
+
+    /* ...stop buffers recycling */
+    dev->active = 0;
+
+    /* ...remove device from the poll set */
+    (dev->submitted ? __register_poll(vin, i, 0) : 0), dev->submitted = 0;
+
+    /* ...withheld frame is discarded along with the pool */
+    dev->pending = -1;
+
+    /* ...stop streaming; driver releases all queued buffers */
+    vin_streaming_enable(dev->vfd, 0);
+
+    /* ...wait until application returns all buffers (group lock is released while waiting) */
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_sec += VIN_RESIZE_TIMEOUT / 1000;
+    ((ts.tv_nsec += (VIN_RESIZE_TIMEOUT % 1000) * 1000000) >= 1000000000 ? ts.tv_sec++, ts.tv_nsec -= 1000000000 : 0);
+
+    while (dev->busy && r == 0)
+    {
+        r = pthread_cond_timedwait(&dev->wait, &dev->group->lock, &ts);
+    }
+
+    t1 = __get_time_usec();
+
+    /* ...consumers did not make progress; resume streaming with the old pool */
+    if (dev->busy)
+    {
+        TRACE(ERROR, _x("vin-%d: resize aborted: %d buffers not returned in %u us"), i, dev->busy, t1 - t0);
+
+        for (j = 0; j < dev->size; j++)
+        {
+            (!dev->pool[j].busy ? __submit_buffer(vin, i, j) : 0);
+        }
+
+        /* ...buffers held by application are requeued when returned */
+        dev->active = 1;
+        vin_streaming_enable(dev->vfd, 1);
+
+        pthread_mutex_unlock(&dev->group->lock);
+
+        return -(errno = ETIMEDOUT);
+    }
+
+    /* ...destroy GStreamer buffers of the old pool */
+    dev->release = 1;
+    for (j = 0; j < dev->size; j++)
+    {
+        GstBuffer  *buffer;
+
+        ((buffer = dev->pool[j].buffer) ? gst_buffer_unref(buffer) : 0);
+    }
+    dev->release = 0;
+
+    /* ...release kernel buffers */
+    vin_destroy_buffers(dev->vfd, dev->pool, dev->size);
+    free(dev->pool), dev->pool = NULL;
+
+    /* ...create new pool and restart streaming */
+    r = __device_pool_create(vin, i, size);
+
+    /* ...update switching statistics */
+    dev->stats.resizes++;
+    dev->stats.resize_time = __get_time_usec() - t0;
+
+    TRACE(INFO, _b("vin-%d: pool resized to %d buffers: %u us (drain: %u us)"), i, size, dev->stats.resize_time, t1 - t0);
+
+    pthread_mutex_unlock(&dev->group->lock);
+
+    return CHK_API(r);
+}
+
+/* ...close VIN device (called with a group lock held) */
 static void __vin_device_close(vin_data_t *vin, int i)
 {
     vin_device_t   *dev = &vin->dev[i];
@@ -730,7 +1134,7 @@ static void __vin_device_close(vin_data_t *vin, int i)
     /* ...wait until all buffers are collected */
     while (dev->busy)
     {
-        pthread_cond_wait(&dev->wait, &vin->lock);
+        pthread_cond_wait(&dev->wait, &dev->group->lock);
     }
 
     /* ...destroy the buffers that haven't been freed yet */
@@ -759,25 +1163,41 @@ static void __vin_device_close(vin_data_t *vin, int i)
 void vin_destroy(gpointer data, GObject *obj)
 {
     vin_data_t     *vin = data;
-    int             i;
+    int             i, g;
 
-    /* ...acquire lock */
-    pthread_mutex_lock(&vin->lock);
+    /* ...acquire all group locks */
+    for (g = 0; g < vin->groups; g++)
+    {
+        pthread_mutex_lock(&vin->group[g].lock);
+    }
     
     /* ...clear activity flag */
     vin->active = 0;
 
-    /* ...cancel processing thread */
-    pthread_cancel(vin->thread);
+    /* ...cancel processing threads */
+    for (g = 0; g < vin->groups; g++)
+    {
+        (vin->group[g].num ? pthread_cancel(vin->group[g].thread) : 0);
+        pthread_mutex_unlock(&vin->group[g].lock);
+    }
 
     /* ...wait for all devices flushing */
     for (i = 0; i < vin->num; i++)
     {
+        vin_group_t    *group = vin->dev[i].group;
+
+        pthread_mutex_lock(&group->lock);
         __vin_device_close(vin, i);
+        pthread_mutex_unlock(&group->lock);
     }    
 
-    /* ...destroy mutex */
-    pthread_mutex_destroy(&vin->lock);
+    /* ...destroy groups */
+    for (g = 0; g < vin->groups; g++)
+    {
+        close(vin->group[g].evfd);
+        close(vin->group[g].efd);
+        pthread_mutex_destroy(&vin->group[g].lock);
+    }
     
     /* ...destroy decoder structure */
     free(vin);
@@ -790,15 +1210,78 @@ int get_v4l2_fd(vin_data_t *vin, int i)
         return vin->dev[i].vfd;
 }
 
+/* ...set latest-frame-only delivery mode (depth - maximal number of frames owned by consumer) */
+int vin_device_set_latest(vin_data_t *vin, int i, int depth)
+{
+    vin_device_t   *dev = &vin->dev[i];
+
+    /* ...make sure we have proper index */
+    CHK_ERR((u32)i < (u32)vin->num, -(errno = EINVAL));
+
+    /* ...consumer must not be able to hold entire pool */
+    CHK_ERR(depth >= 0 && (!dev->size || depth < dev->size), -(errno = EINVAL));
+
+    pthread_mutex_lock(&dev->group->lock);
+
+    /* ...release withheld frame if mode is disabled */
+    if ((dev->latest = depth) == 0 && dev->pending >= 0)
+    {
+        (dev->active ? __submit_buffer(vin, i, dev->pending) : 0);
+        dev->pending = -1;
+    }
+
+    pthread_mutex_unlock(&dev->group->lock);
+
+    TRACE(INIT, _b("vin-%d: latest-frame mode %s (depth=%d)"), i, (depth ? "enabled" : "disabled"), depth);
+
+    return 0;
+}
+
+/* ...retrieve capture statistics of particular device */
+int vin_device_get_stats(vin_data_t *vin, int i, vin_stats_t *stats)
+{
+    /* ...make sure we have proper index */
+    CHK_ERR((u32)i < (u32)vin->num, -(errno = EINVAL));
+
+    /* ...take a snapshot with a lock held */
+    pthread_mutex_lock(&vin->dev[i].group->lock);
+    *stats = vin->dev[i].stats;
+    stats->pool = vin->dev[i].size;
+    pthread_mutex_unlock(&vin->dev[i].group->lock);
+
+    return 0;
+}
+
+/* ...account buffer dropped by the application pipeline */
+void vin_buffer_dropped(GstBuffer *buffer)
+{
+    vin_data_t     *vin = (vin_data_t *)buffer->pool;
+    vin_meta_t     *meta = gst_buffer_get_vin_meta(buffer);
+    vin_device_t   *dev;
+
+    /* ...ignore buffers that are not produced by VIN */
+    if (!meta)      return;
+
+    dev = &vin->dev[meta->camera_id];
+    pthread_mutex_lock(&dev->group->lock);
+    dev->stats.dropped++;
+    pthread_mutex_unlock(&dev->group->lock);
+}
+
 /* ...module initialization function */
 vin_data_t * vin_init(char **devname, int num, camera_callback_t *cb, void *cdata)
 {
     vin_data_t             *vin;
+    vin_group_t            *group;
     pthread_mutexattr_t     attr;
     int                     i;
 
     /* ...create decoder structure */
-    CHK_ERR(vin = malloc(sizeof(*vin)), (errno = ENOMEM, NULL));
+    CHK_ERR(vin = calloc(1, sizeof(*vin)), (errno = ENOMEM, NULL));
+
+    /* ...default group services all devices */
+    group = &vin->group[0], vin->groups = 1;
+    group->vin = vin, group->num = num, group->devices = (1 << num) - 1;
 
     /* ...save application provided callback */
     vin->cb = cb, vin->cdata = cdata;
@@ -811,7 +1294,7 @@ vin_data_t * vin_init(char **devname, int num, camera_callback_t *cb, void *cdat
     }
 
     /* ...create epoll descriptor */
-    if ((vin->efd = epoll_create(num)) < 0)
+    if ((group->efd = epoll_create(num)) < 0 || __register_kick(group) < 0)
     {
         TRACE(ERROR, _x("failed to create epoll: %m"));
         goto error;
@@ -822,6 +1305,12 @@ vin_data_t * vin_init(char **devname, int num, camera_callback_t *cb, void *cdat
     {
         vin_device_t   *dev = &vin->dev[i];
 
+        /* ...assign device to the default group */
+        dev->group = group;
+
+        /* ...initialize buffers collection conditional */
+        pthread_cond_init(&dev->wait, NULL);
+
         /* ...open VIN device */
         if ((dev->vfd = open(devname[i], O_RDWR | O_NONBLOCK)) < 0)
         {
@@ -843,7 +1332,7 @@ vin_data_t * vin_init(char **devname, int num, camera_callback_t *cb, void *cdat
     /* ...initialize internal queue access lock */
     pthread_mutexattr_init(&attr);
     pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
-    pthread_mutex_init(&vin->lock, &attr);
+    pthread_mutex_init(&group->lock, &attr);
     pthread_mutexattr_destroy(&attr);
 
     TRACE(INIT, _b("VIN module initialized"));
@@ -863,7 +1352,7 @@ error_dev:
 
 error:
     /* ...close epoll file descriptor */
-    close(vin->efd);
+    (group->efd > 0 ? close(group->efd) : 0);
 
     /* ...release module memory */
     free(vin);
@@ -27,15 +27,90 @@
 #ifndef __UTEST_VIN_H
 #define __UTEST_VIN_H
 
-typedef struct vin_data    *vin_data_t;
+/*******************************************************************************
+ * Includes
+ ******************************************************************************/
+
+#include "utest-common.h"
+#include "utest-camera.h"
+
+/*******************************************************************************
+ * Opaque handles
+ ******************************************************************************/
+
+/* ...handle data */
+typedef struct vin_data     vin_data_t;
+
+/*******************************************************************************
+ * Capture statistics
+ ******************************************************************************/
+
+typedef struct vin_stats
+{
+    /* ...total number of frames dequeued from the driver */
+    u32                 frames;
+
+    /* ...number of sequence discontinuities and total amount of frames lost */
+    u32                 gaps, lost;
+
+    /* ...number of buffers marked as corrupted by the driver */
+    u32                 errors;
+
+    /* ...number of buffers dropped by the application pipeline */
+    u32                 dropped;
+
+    /* ...number of frames superseded in latest-frame-only mode */
+    u32                 skipped;
+
+    /* ...number of times the driver has been left without queued buffers */
+    u32                 starved;
+
+    /* ...current buffer pool depth */
+    u32                 pool;
+
+    /* ...number of pool resizes and duration of the last one (in microseconds) */
+    u32                 resizes, resize_time;
+
+}   vin_stats_t;
+
+/*******************************************************************************
+ * Capture threads configuration
+ ******************************************************************************/
+
+typedef struct vin_thread_cfg
+{
+    /* ...mask of devices serviced by the thread */
+    u32                 devices;
+
+    /* ...CPU affinity mask (zero - no affinity) */
+    u32                 cpus;
+
+    /* ...SCHED_FIFO priority (zero - default scheduling policy) */
+    int                 priority;
+
+}   vin_thread_cfg_t;
+
+/*******************************************************************************
+ * Public API
+ ******************************************************************************/
 
 extern vin_data_t * vin_init(char **devname, int num, camera_callback_t *cb, void *cdata);
 
+extern int vin_thread_setup(vin_data_t *vin, const vin_thread_cfg_t *cfg);
+
 extern int vin_device_init(vin_data_t *vin, int i, int w, int h, u32 fmt, int size);
 
 extern int vin_start(vin_data_t *vin);
 
 extern int get_v4l2_fd(vin_data_t *vin, int i);
 
+extern int vin_device_resize(vin_data_t *vin, int i, int size);
+
+extern int vin_device_set_latest(vin_data_t *vin, int i, int depth);
+
+extern int vin_device_get_stats(vin_data_t *vin, int i, vin_stats_t *stats);
+
+extern void vin_buffer_dropped(GstBuffer *buffer);
+
 #endif  /* __UTEST_VIN_H */
 
@@ -33,6 +33,7 @@
 
 #include <gst/app/gstappsink.h>
 #include <gst/video/video-info.h>
+#include "utest-stamp.h"
 
 /*******************************************************************************
  * Opaque type declaration
@@ -66,6 +67,9 @@ typedef struct vsink_meta
 
     /* ...sink pointer */
     video_sink_t       *sink;
+
+    /* ...frame processing stages times (us) */
+    u64                 stamps[STAMP_NUMBER];
     
 }   vsink_meta_t;
 